@@ -41,84 +41,72 @@
 
 #include <am_bsp.h>
 
-#include "ArducamCamera.h"
-
 #include "tflm.h"
 
 #include "button.h"
-#include "camera_task.h"
 
 #include "application_task.h"
 #include "application_task_cli.h"
+#include "bench_cli.h"
+#include "governor.h"
+#include "inference_task.h"
+#include "logger.h"
+#include "perf.h"
+#include "pipeline.h"
+#include "rpc.h"
+#include "rtos_alloc.h"
 
 static TaskHandle_t application_task_handle;
 static TimerHandle_t application_timer_handle;
 static QueueHandle_t application_queue_handle;
 
-static am_hal_burst_avail_e application_burst_available;
-static am_hal_burst_mode_e  application_burst_mode;
+static application_inference_callback_t request_callback;
 
-static uint8_t *image_buffer;
-static size_t image_size;
+static const bench_vector_t *bench_request_vectors;
+static size_t bench_request_count;
+static uint32_t bench_request_iterations;
+static uint32_t bench_request_modes;
+static uint32_t bench_samples[BENCH_MAX_SAMPLES];
 
 static uint32_t application_leds[4] = { AM_BSP_GPIO_LED1, AM_BSP_GPIO_LED2, AM_BSP_GPIO_LED3, AM_BSP_GPIO_LED4 };
 
 typedef enum application_command_e
 {
-    APPLICATION_COMMAND_CAPTURE_START,
-    APPLICATION_COMMAND_CAPTURE_DONE,
+    APPLICATION_COMMAND_INFERENCE_DONE,
+    APPLICATION_COMMAND_BENCH,
     APPLICATION_COMMAND_HEARTBEAT
 } application_command_t;
 
-void application_task_send(application_command_t *message);
-
-static void application_timer_handler(TimerHandle_t timer)
+typedef struct application_message_s
 {
     application_command_t command;
-    command = APPLICATION_COMMAND_HEARTBEAT;
-    application_task_send(&command);
-}
+    inference_result_t result; // APPLICATION_COMMAND_INFERENCE_DONE only
+} application_message_t;
 
-static void application_button_handler()
-{
-    application_command_t command;
-    command = APPLICATION_COMMAND_CAPTURE_START;
-    application_task_send(&command);
-}
+#define APPLICATION_TASK_STACK_SIZE (512)
+#define APPLICATION_QUEUE_LENGTH    (8)
 
-static void application_camera_handler(uint8_t *buffer, size_t size)
-{
-    image_buffer = buffer;
-    image_size = size;
+// remote inference requests, the host stops waiting after two seconds
+#define APPLICATION_INFERENCE_PRIORITY    (1)
+#define APPLICATION_INFERENCE_DEADLINE_MS (2000)
 
-    application_command_t command;
-    command = APPLICATION_COMMAND_CAPTURE_DONE;
-    application_task_send(&command);
-}
+RTOS_TASK_STORAGE(application_task, APPLICATION_TASK_STACK_SIZE)
+RTOS_QUEUE_STORAGE(application, APPLICATION_QUEUE_LENGTH, sizeof(application_message_t))
+RTOS_TIMER_STORAGE(application)
 
-static void application_burst_init()
-{
-    am_hal_burst_mode_initialize(&application_burst_available);
-    if (application_burst_available == AM_HAL_BURST_AVAIL)
-    {
-        am_hal_burst_mode_disable(&application_burst_mode);
-    }
-}
+void application_task_send(application_message_t *message);
 
-static void application_burst_enable()
+static void application_timer_handler(TimerHandle_t timer)
 {
-    if (application_burst_available == AM_HAL_BURST_AVAIL)
-    {
-        am_hal_burst_mode_enable(&application_burst_mode);
-    }
+    application_message_t message;
+    message.command = APPLICATION_COMMAND_HEARTBEAT;
+    application_task_send(&message);
 }
 
-static void application_burst_disable()
+static void application_button_handler()
 {
-    if (application_burst_available == AM_HAL_BURST_AVAIL)
-    {
-        am_hal_burst_mode_disable(&application_burst_mode);
-    }
+    LOG_INFO("Capture Start Triggered");
+    pipeline_trigger();
 }
 
 static void application_set_led(uint32_t value)
@@ -137,16 +125,92 @@ static void application_set_led(uint32_t value)
     }
 }
 
-static void application_inference()
+static void application_publish(const pipeline_frame_t *frame)
+{
+#if defined(TFLM_FRAME)
+    // the LEDs show the leftmost digit read
+    application_set_led(frame->digits.count ? (frame->digits.digits[0].label - '0') : TFLM_INFERENCE_FAILED);
+    LOG_INFO("Inference Done, %d digits read", frame->digits.count);
+#else
+    application_set_led(frame->value);
+    LOG_INFO("Inference Done");
+#endif
+}
+
+// Runs on the inference task; the result is handed back to the application
+// task so that the callback does not hold up the next request.
+static void application_inference_done(const inference_result_t *result, void *context)
+{
+    application_message_t message;
+    message.command = APPLICATION_COMMAND_INFERENCE_DONE;
+    message.result = *result;
+    application_task_send(&message);
+}
+
+static char application_bench_infer(const uint8_t *tensor, size_t size)
+{
+    size_t count;
+    uint32_t value = tflm_inference((uint8_t *)tensor, size, NULL, &count);
+
+    // the prediction is reported as the offset of its label from '0'
+    return (value == TFLM_INFERENCE_FAILED) ? 0 : (char)('0' + value);
+}
+
+// A frame model scores every window of the frame in one inference.
+static void application_bench_windows(const bench_result_t *result, uint32_t windows)
+{
+    if ((windows > 1) && (result->elapsed_us > 0))
+    {
+        uint32_t rate = (uint32_t)(((uint64_t)result->iterations * windows * 1000000) / result->elapsed_us);
+        am_util_stdio_printf("  windows: %d per frame, %d windows/s\r\n", windows, rate);
+    }
+}
+
+static void application_bench()
 {
-    uint32_t value;
-    uint8_t *result;
-    size_t result_size;
-    application_burst_enable();
-    value = tflm_inference(image_buffer, image_size, result, &result_size);
-    application_burst_disable();
-    application_set_led(value);
-    am_util_stdio_printf("Inference Done\r\n");
+    static const bench_platform_t platform = {
+        .timestamp = perf_timestamp,
+        .elapsed_us = perf_elapsed_us,
+        .infer = application_bench_infer,
+    };
+    tflm_info_t model;
+    bench_result_t result;
+
+    tflm_get_info(&model);
+
+    if (bench_request_modes & APPLICATION_BENCH_NORMAL)
+    {
+        bench_run(&platform,
+                  bench_request_vectors,
+                  bench_request_count,
+                  model.input_size,
+                  bench_request_iterations,
+                  bench_samples,
+                  &result);
+        bench_print("normal", &result);
+        application_bench_windows(&result, model.windows);
+    }
+
+    if (bench_request_modes & APPLICATION_BENCH_BURST)
+    {
+        if (!governor_burst_available())
+        {
+            am_util_stdio_printf("burst: not available\r\n");
+            return;
+        }
+
+        governor_hold(GOVERNOR_LEVEL_BURST);
+        bench_run(&platform,
+                  bench_request_vectors,
+                  bench_request_count,
+                  model.input_size,
+                  bench_request_iterations,
+                  bench_samples,
+                  &result);
+        governor_release(GOVERNOR_LEVEL_BURST);
+        bench_print("burst", &result);
+        application_bench_windows(&result, model.windows);
+    }
 }
 
 static void application_setup_task()
@@ -166,42 +230,53 @@ static void application_setup_task()
     am_hal_gpio_pinconfig(AM_BSP_GPIO_LED4, g_AM_HAL_GPIO_OUTPUT);
     am_hal_gpio_state_write(AM_BSP_GPIO_LED4, AM_HAL_GPIO_OUTPUT_CLEAR);
 
-    application_burst_init();
     tflm_setup();
+    rpc_setup();
+    bench_cli_register();
 
     button_sequence_register(1, 0B0, application_button_handler);
-    camera_event_subscribe(CAMERA_COMMAND_STILL_RETRIEVE_DONE, application_camera_handler);
+    pipeline_set_publish(application_publish);
 
     xTimerStart(application_timer_handle, portMAX_DELAY);
 }
 
 static void application_task(void *parameter)
 {
-    application_command_t message;
+    application_message_t message;
 
+    logger_register_task();
     application_task_cli_register();
     application_setup_task();
     while (1)
     {
         if (xQueueReceive(application_queue_handle, &message, portMAX_DELAY) == pdPASS)
         {
-            switch(message)
+            switch(message.command)
             {
-            case APPLICATION_COMMAND_CAPTURE_START:
-                am_util_stdio_printf("Capture Start Triggered\r\n");
-
-                camera_message_t message;
-                message.command = CAMERA_COMMAND_STILL_CAPTURE;
-                message.payload.capture_parameters.resolution = CAM_IMAGE_MODE_96X96;
-                message.payload.capture_parameters.format = CAM_IMAGE_PIX_FMT_RGB565;
-                camera_task_send(&message);
+            case APPLICATION_COMMAND_INFERENCE_DONE:
+                // a request that was dropped, went stale or was cancelled
+                // predicted nothing, so the LEDs keep the last result
+                if ((message.result.value != INFERENCE_DROPPED) && (message.result.value != INFERENCE_STALE) &&
+                    (message.result.value != TFLM_INFERENCE_CANCELLED))
+                {
+                    application_set_led(message.result.value);
+                }
+                if (request_callback)
+                {
+                    governor_token_t token = governor_enter(PERF_STAGE_REPORT);
+                    request_callback(message.result.value,
+                                     message.result.scores,
+                                     message.result.count,
+                                     message.result.ticks);
+                    perf_record(PERF_STAGE_REPORT, perf_elapsed_us(token.start));
+                    governor_exit(PERF_STAGE_REPORT, token);
+                }
                 break;
 
-            case APPLICATION_COMMAND_CAPTURE_DONE:
-                am_util_stdio_printf("Capture Done\r\n");
+            case APPLICATION_COMMAND_BENCH:
                 xTimerStop(application_timer_handle, portMAX_DELAY);
                 am_hal_gpio_state_write(AM_BSP_GPIO_LED0, AM_HAL_GPIO_OUTPUT_SET);
-                application_inference();
+                application_bench();
                 am_hal_gpio_state_write(AM_BSP_GPIO_LED0, AM_HAL_GPIO_OUTPUT_CLEAR);
                 xTimerStart(application_timer_handle, portMAX_DELAY);
                 break;
@@ -219,12 +294,63 @@ static void application_task(void *parameter)
 
 void application_task_create(uint32_t priority)
 {
-    application_queue_handle = xQueueCreate(8, sizeof(application_command_t));
-    application_timer_handle = xTimerCreate("application", pdMS_TO_TICKS(500), pdTRUE, NULL, application_timer_handler);
-    xTaskCreate(application_task, "application", 512, 0, priority, &application_task_handle);
+    application_queue_handle =
+        RTOS_QUEUE_CREATE(application, APPLICATION_QUEUE_LENGTH, sizeof(application_message_t));
+    application_timer_handle = RTOS_TIMER_CREATE(
+        application, "application", pdMS_TO_TICKS(500), pdTRUE, NULL, application_timer_handler);
+    RTOS_TASK_CREATE(application_task,
+                     application_task,
+                     "application",
+                     APPLICATION_TASK_STACK_SIZE,
+                     0,
+                     priority,
+                     &application_task_handle);
+}
+
+//
+// Queue an inference on a caller owned tensor with the inference task.  The
+// buffer must stay valid until the callback, which runs on the application
+// task, has been invoked.  A request that could not run reports
+// INFERENCE_DROPPED or INFERENCE_STALE instead of a prediction.
+//
+void application_inference_submit(uint8_t *buffer,
+                                  size_t size,
+                                  application_inference_callback_t callback)
+{
+    inference_request_t request = {
+        .tensor = buffer,
+        .size = size,
+        .model = 0,
+        .priority = APPLICATION_INFERENCE_PRIORITY,
+        .deadline_ms = APPLICATION_INFERENCE_DEADLINE_MS,
+        .callback = application_inference_done,
+        .context = NULL,
+    };
+
+    request_callback = callback;
+    inference_submit(&request);
+}
+
+//
+// Run a benchmark on the application task.  The vectors must stay valid until
+// the results have been printed.
+//
+void application_bench_submit(const bench_vector_t *vectors,
+                              size_t count,
+                              uint32_t iterations,
+                              uint32_t modes)
+{
+    bench_request_vectors = vectors;
+    bench_request_count = count;
+    bench_request_iterations = (iterations > BENCH_MAX_SAMPLES) ? BENCH_MAX_SAMPLES : iterations;
+    bench_request_modes = modes;
+
+    application_message_t message;
+    message.command = APPLICATION_COMMAND_BENCH;
+    application_task_send(&message);
 }
 
-void application_task_send(application_command_t *message)
+void application_task_send(application_message_t *message)
 {
     if (application_queue_handle)
     {
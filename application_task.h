@@ -32,6 +32,27 @@
 #ifndef _APPLICATION_TASK_H_
 #define _APPLICATION_TASK_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bench.h"
+
+typedef void (*application_inference_callback_t)(uint32_t value,
+                                                 const int8_t *scores,
+                                                 size_t count,
+                                                 uint32_t ticks);
+
 extern void application_task_create(uint32_t priority);
+extern void application_inference_submit(uint8_t *buffer,
+                                         size_t size,
+                                         application_inference_callback_t callback);
+
+#define APPLICATION_BENCH_NORMAL (0x01)
+#define APPLICATION_BENCH_BURST  (0x02)
+
+extern void application_bench_submit(const bench_vector_t *vectors,
+                                     size_t count,
+                                     uint32_t iterations,
+                                     uint32_t modes);
 
 #endif
\ No newline at end of file
@@ -39,6 +39,7 @@
 #include <FreeRTOS_CLI.h>
 
 #include "application_task_cli.h"
+#include "tflm.h"
 
 static portBASE_TYPE application_task_cli_entry(char *pui8OutBuffer,
                                                 size_t ui32OutBufferLength,
@@ -61,6 +62,61 @@ static void help(char *pui8OutBuffer, size_t argc, char **argv)
     strcat(pui8OutBuffer, "\r\n");
     strcat(pui8OutBuffer, "supported commands are:\r\n");
     strcat(pui8OutBuffer, "  reset  perform a soft reset\r\n");
+    strcat(pui8OutBuffer, "  exit [percent]\r\n");
+    strcat(pui8OutBuffer, "         stop inference at the first exit head this confident,\r\n");
+    strcat(pui8OutBuffer, "         0 runs every layer\r\n");
+    strcat(pui8OutBuffer, "  slice [layers]\r\n");
+    strcat(pui8OutBuffer, "         yield the processor every this many layers,\r\n");
+    strcat(pui8OutBuffer, "         0 runs the whole model in one go\r\n");
+    strcat(pui8OutBuffer, "  setup [clear]\r\n");
+    strcat(pui8OutBuffer, "         show how long model setup took, clear plans\r\n");
+    strcat(pui8OutBuffer, "         the interpreter again at the next reset\r\n");
+}
+
+static void exit_threshold(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    tflm_info_t model;
+
+    if (argc > 2)
+    {
+        tflm_set_exit_threshold(strtoul(argv[2], NULL, 0));
+    }
+
+    tflm_get_info(&model);
+    am_util_stdio_printf("\r\nexit threshold %d%%, %d exits, %d layers\r\n",
+                         model.exit_threshold,
+                         model.exits,
+                         model.layers);
+}
+
+static void slice(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    tflm_info_t model;
+
+    if (argc > 2)
+    {
+        tflm_set_slice(strtoul(argv[2], NULL, 0));
+    }
+
+    tflm_get_info(&model);
+    am_util_stdio_printf("\r\nslice %d layers, longest %d ticks\r\n",
+                         model.slice_layers,
+                         model.slice_ticks);
+}
+
+static void setup(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    tflm_info_t model;
+
+    if ((argc > 2) && (strcmp(argv[2], "clear") == 0))
+    {
+        tflm_snapshot_clear();
+    }
+
+    tflm_get_info(&model);
+    am_util_stdio_printf("\r\nsetup %d us, %s\r\n",
+                         model.setup_us,
+                         model.setup_restored ? "restored from snapshot" : "planned");
 }
 
 portBASE_TYPE
@@ -83,6 +139,18 @@ application_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, cons
     {
         NVIC_SystemReset();
     }
+    else if (strcmp(argv[1], "exit") == 0)
+    {
+        exit_threshold(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "slice") == 0)
+    {
+        slice(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "setup") == 0)
+    {
+        setup(pui8OutBuffer, argc, argv);
+    }
 
     return pdFALSE;
 }
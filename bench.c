@@ -0,0 +1,160 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+
+#include "bench.h"
+
+#ifdef BENCH_HOST
+#include <stdio.h>
+#define bench_printf printf
+#else
+#include <am_util.h>
+#define bench_printf am_util_stdio_printf
+#endif
+
+#ifndef BENCH_VECTORS
+const bench_vector_t bench_vectors[] = {{0, NULL}};
+const size_t bench_vector_count = 0;
+#endif
+
+static int bench_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+// nearest rank percentile of a sorted array
+static uint32_t bench_percentile(const uint32_t *sorted, uint32_t count, uint32_t percent)
+{
+    uint32_t rank = (percent * count + 99) / 100;
+
+    return sorted[(rank > 0) ? (rank - 1) : 0];
+}
+
+void bench_run(const bench_platform_t *platform,
+               const bench_vector_t *vectors,
+               size_t vector_count,
+               size_t tensor_size,
+               uint32_t iterations,
+               uint32_t *samples,
+               bench_result_t *result)
+{
+    uint64_t total = 0;
+    uint32_t completed = 0;
+
+    *result = (bench_result_t){0};
+    if ((vector_count == 0) || (iterations == 0))
+    {
+        return;
+    }
+
+    uint32_t start = platform->timestamp();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        const bench_vector_t *vector = &vectors[i % vector_count];
+
+        uint32_t timestamp = platform->timestamp();
+        char label = platform->infer(vector->tensor, tensor_size);
+        uint32_t elapsed = platform->elapsed_us(timestamp);
+
+        if (label == 0)
+        {
+            result->failed++;
+            continue;
+        }
+
+        samples[completed++] = elapsed;
+        total += elapsed;
+
+        if (vector->label)
+        {
+            result->labelled++;
+            if (label == vector->label)
+            {
+                result->correct++;
+            }
+        }
+    }
+    result->elapsed_us = platform->elapsed_us(start);
+    result->iterations = iterations;
+
+    if (completed == 0)
+    {
+        return;
+    }
+
+    qsort(samples, completed, sizeof(samples[0]), bench_compare);
+    result->min_us = samples[0];
+    result->p50_us = bench_percentile(samples, completed, 50);
+    result->p95_us = bench_percentile(samples, completed, 95);
+    result->p99_us = bench_percentile(samples, completed, 99);
+    result->max_us = samples[completed - 1];
+    result->mean_us = (uint32_t)(total / completed);
+}
+
+void bench_print(const char *title, const bench_result_t *result)
+{
+    uint32_t completed = result->iterations - result->failed;
+
+    bench_printf("%s: %d inferences, %d failed\r\n", title, result->iterations, result->failed);
+    if (completed == 0)
+    {
+        return;
+    }
+
+    bench_printf("  latency us: min %d, p50 %d, p95 %d, p99 %d, max %d, mean %d\r\n",
+                 result->min_us,
+                 result->p50_us,
+                 result->p95_us,
+                 result->p99_us,
+                 result->max_us,
+                 result->mean_us);
+
+    if (result->elapsed_us > 0)
+    {
+        // hundredths of an inference per second, without floating point
+        uint32_t rate = (uint32_t)(((uint64_t)completed * 100000000) / result->elapsed_us);
+        bench_printf("  throughput: %d.%02d inferences/s\r\n", rate / 100, rate % 100);
+    }
+
+    if (result->labelled > 0)
+    {
+        uint32_t accuracy = (result->correct * 10000) / result->labelled;
+        bench_printf("  accuracy: %d.%02d%% (%d of %d)\r\n",
+                     accuracy / 100,
+                     accuracy % 100,
+                     result->correct,
+                     result->labelled);
+    }
+}
@@ -0,0 +1,103 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Inference benchmark shared by the firmware "bench" command and the host
+// harness in tools/bench_host.  The platform supplies the clock and the
+// inference call, so this file must not depend on FreeRTOS or the HAL.
+//
+#define BENCH_MAX_SAMPLES (256)
+
+typedef struct bench_vector_s
+{
+    char label; // expected ASCII label, 0 when unknown
+    const uint8_t *tensor;
+} bench_vector_t;
+
+typedef struct bench_platform_s
+{
+    uint32_t (*timestamp)(void);
+    uint32_t (*elapsed_us)(uint32_t start);
+
+    // returns the predicted ASCII label, 0 if the inference failed
+    char (*infer)(const uint8_t *tensor, size_t size);
+} bench_platform_t;
+
+typedef struct bench_result_s
+{
+    uint32_t iterations;
+    uint32_t failed;
+    uint32_t labelled;
+    uint32_t correct;
+    uint32_t min_us;
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t mean_us;
+    uint32_t elapsed_us; // wall clock for the whole run
+} bench_result_t;
+
+//
+// Cycle through the vectors for the requested number of iterations.  samples
+// must have room for one entry per iteration.
+//
+extern void bench_run(const bench_platform_t *platform,
+                      const bench_vector_t *vectors,
+                      size_t vector_count,
+                      size_t tensor_size,
+                      uint32_t iterations,
+                      uint32_t *samples,
+                      bench_result_t *result);
+extern void bench_print(const char *title, const bench_result_t *result);
+
+//
+// Vectors compiled into flash, generated by tools/generate_bench_vectors.py
+// and selected with the BENCH_VECTORS cmake option.
+//
+extern const bench_vector_t bench_vectors[];
+extern const size_t bench_vector_count;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <FreeRTOS_CLI.h>
+
+#include "application_task.h"
+#include "bench.h"
+#include "bench_cli.h"
+#include "rpc.h"
+
+static portBASE_TYPE bench_cli_entry(char *pui8OutBuffer,
+                                     size_t ui32OutBufferLength,
+                                     const char *pui8Command);
+
+static CLI_Command_Definition_t bench_cli_definition = {
+    (const char *const) "bench",
+    (const char *const) "bench  :  Inference Benchmark.\r\n",
+    bench_cli_entry,
+    -1};
+
+static bench_vector_t bench_uploaded;
+
+void bench_cli_register()
+{
+    FreeRTOS_CLIRegisterCommand(&bench_cli_definition);
+}
+
+static void help(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    strcat(pui8OutBuffer, "\r\nusage: bench [count] [flash|uploaded] [normal|burst|both]\r\n");
+    strcat(pui8OutBuffer, "\r\n");
+    strcat(pui8OutBuffer, "  count     number of inferences, at most 256 (default 100)\r\n");
+    strcat(pui8OutBuffer, "  flash     cycle through the vectors built into the firmware\r\n");
+    strcat(pui8OutBuffer, "  uploaded  repeat the tensor staged over RPC\r\n");
+    strcat(pui8OutBuffer, "  normal    run at the normal clock\r\n");
+    strcat(pui8OutBuffer, "  burst     run in burst mode\r\n");
+    strcat(pui8OutBuffer, "  both      run once in each mode (default)\r\n");
+}
+
+portBASE_TYPE
+bench_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const char *pui8Command)
+{
+    size_t argc;
+    char *argv[8];
+    char argz[128];
+    uint32_t iterations = 100;
+    uint32_t modes = APPLICATION_BENCH_NORMAL | APPLICATION_BENCH_BURST;
+    const bench_vector_t *vectors = bench_vectors;
+    size_t count = bench_vector_count;
+
+    pui8OutBuffer[0] = 0;
+
+    strcpy(argz, pui8Command);
+    FreeRTOS_CLIExtractParameters(argz, &argc, argv);
+
+    for (size_t i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "help") == 0)
+        {
+            help(pui8OutBuffer, argc, argv);
+            return pdFALSE;
+        }
+        else if (strcmp(argv[i], "flash") == 0)
+        {
+            vectors = bench_vectors;
+            count = bench_vector_count;
+        }
+        else if (strcmp(argv[i], "uploaded") == 0)
+        {
+            bench_uploaded.label = 0;
+            bench_uploaded.tensor = rpc_staged_tensor();
+            vectors = &bench_uploaded;
+            count = 1;
+        }
+        else if (strcmp(argv[i], "normal") == 0)
+        {
+            modes = APPLICATION_BENCH_NORMAL;
+        }
+        else if (strcmp(argv[i], "burst") == 0)
+        {
+            modes = APPLICATION_BENCH_BURST;
+        }
+        else if (strcmp(argv[i], "both") == 0)
+        {
+            modes = APPLICATION_BENCH_NORMAL | APPLICATION_BENCH_BURST;
+        }
+        else
+        {
+            iterations = strtoul(argv[i], NULL, 0);
+        }
+    }
+
+    if (count == 0)
+    {
+        strcat(pui8OutBuffer, "no vectors in flash, rebuild with BENCH_VECTORS or use 'uploaded'\r\n");
+        return pdFALSE;
+    }
+
+    application_bench_submit(vectors, count, iterations, modes);
+
+    return pdFALSE;
+}
@@ -132,10 +132,11 @@ static am_hal_uart_config_t g_sBspUartBufferedConfig =
     .ui32FlowControl = AM_HAL_UART_FLOW_CTRL_NONE,
 
     //
-    // Set TX and RX FIFOs to interrupt at half-full.
+    // Interrupt when the TX FIFO is half empty and the RX FIFO is three
+    // quarters full. The receive timeout interrupt picks up any tail bytes.
     //
     .ui32FifoLevels = (AM_HAL_UART_TX_FIFO_1_2 |
-                       AM_HAL_UART_RX_FIFO_1_2),
+                       AM_HAL_UART_RX_FIFO_3_4),
 
     //
     // The default interface will just use polling instead of buffers.
@@ -935,6 +936,11 @@ am_bsp_buffered_uart_printf_enable(void)
     am_hal_uart_power_control(g_sCOMUART, AM_HAL_SYSCTRL_WAKE, false);
     am_hal_uart_configure(g_sCOMUART, &g_sBspUartBufferedConfig);
 
+    //
+    // Report receive FIFO overruns so the application can count them.
+    //
+    am_hal_uart_interrupt_enable(g_sCOMUART, AM_HAL_UART_INT_OVER_RUN);
+
     //
     // Enable the UART pins.
     //
@@ -954,16 +960,19 @@ am_bsp_buffered_uart_printf_enable(void)
 
 //*****************************************************************************
 //
-// Interrupt routine for the buffered UART interface.
+// Interrupt routine for the buffered UART interface. Returns the interrupt
+// status that was serviced.
 //
 //*****************************************************************************
-void
+uint32_t
 am_bsp_buffered_uart_service(void)
 {
     uint32_t ui32Status, ui32Idle;
     am_hal_uart_interrupt_status_get(g_sCOMUART, &ui32Status, true);
     am_hal_uart_interrupt_clear(g_sCOMUART, ui32Status);
     am_hal_uart_interrupt_service(g_sCOMUART, ui32Status, &ui32Idle);
+
+    return ui32Status;
 } // am_bsp_buffered_uart_service()
 #endif // AM_BSP_DISABLE_BUFFERED_UART
 
@@ -135,7 +135,7 @@ extern void am_bsp_uart_printf_enable(void);
 extern void am_bsp_uart_printf_disable(void);
 
 extern void am_bsp_buffered_uart_printf_enable(void);
-extern void am_bsp_buffered_uart_service(void);
+extern uint32_t am_bsp_buffered_uart_service(void);
 
 extern uint32_t am_bsp_com_uart_transfer(const am_hal_uart_transfer_t *psTransfer);
 
@@ -29,24 +29,30 @@
  * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
+#include <stdbool.h>
+
 #include <am_mcu_apollo.h>
 #include <am_util.h>
 
 #include <FreeRTOS.h>
-#include <list.h>
 #include <task.h>
 #include <queue.h>
-#include <timers.h>
 
 #include "am_bsp.h"
 #include "button.h"
 #include "button_task.h"
+#include "button_trie.h"
+#include "logger.h"
+#include "perf.h"
+#include "rtos_alloc.h"
 
 #define BUTTON_DEBOUNCE_DELAY_MS   (20)
-#define BUTTON_PRESS_SAMPLING_MS   (20)
 #define BUTTON_PRESS_GAP_MS       (500)
 #define BUTTON_PRESS_SHORT_MS     (500)
-#define BUTTON_PRESS_LONG_MS     (2000)
+
+// the button pulls the pin low while it is held
+#define BUTTON_LEVEL_PRESSED  (0)
+#define BUTTON_LEVEL_RELEASED (1)
 
 typedef enum
 {
@@ -54,219 +60,234 @@ typedef enum
     BUTTON_PRESS_LONG = 1,
 } button_press_e;
 
-typedef enum
-{
-    BUTTON_STATE_TIMEOUT,
-    BUTTON_STATE_PRESSED,
-} button_command_e;
-
 typedef struct
 {
-    uint8_t size:8;
-    uint32_t sequence:24;
-} button_sequence_t;
-
-typedef union
-{
-    button_sequence_t sequence;
-    uint32_t          value;
-} button_sequence_u;
+    uint32_t timestamp;
+    uint32_t level;
+} button_edge_t;
 
+#define BUTTON_TASK_STACK_SIZE (512)
+#define BUTTON_QUEUE_LENGTH     (16)
 
 static TaskHandle_t  button_task_handle;
 static QueueHandle_t button_queue_handle;
-static TimerHandle_t button_timer_handle;
-static uint32_t button_state_counter;
 
-static List_t button_sequence_list;
-static uint32_t ui32ButtonSequence;
+RTOS_TASK_STORAGE(button_task, BUTTON_TASK_STACK_SIZE)
+RTOS_QUEUE_STORAGE(button, BUTTON_QUEUE_LENGTH, sizeof(button_edge_t))
+
+// position of the presses so far in the sequence trie
+static uint16_t button_sequence_node;
 
-static void button_task_send_command(button_command_e command)
+static uint32_t button_level;
+static uint32_t button_edge_timestamp;
+static uint32_t button_press_timestamp;
+
+static bool button_recheck_pending;
+static TickType_t button_recheck_deadline;
+static bool button_gap_pending;
+static TickType_t button_gap_deadline;
+
+//
+// Both edges interrupt.  The edge is timestamped with the system timer here so
+// press durations do not depend on how quickly the task gets to run.
+//
+static void button_edge_handler()
 {
-    BaseType_t xHigherPriorityTaskWoken;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    button_edge_t edge;
 
-    if (xPortIsInsideInterrupt() == pdTRUE)
-    {
-        xHigherPriorityTaskWoken = pdFALSE;
-        xQueueSendFromISR(button_queue_handle, &command, &xHigherPriorityTaskWoken);
-        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
-    }
-    else
-    {
-        xQueueSend(button_queue_handle, &command, portMAX_DELAY);
-    }
+    edge.timestamp = perf_timestamp();
+    am_hal_gpio_state_read(AM_BSP_GPIO_BUTTON0, AM_HAL_GPIO_INPUT_READ, &edge.level);
+
+    xQueueSendFromISR(button_queue_handle, &edge, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
-static void button_task_timer_callback(TimerHandle_t xTimer)
+static void button_sequence_reset()
 {
-    button_task_send_command(BUTTON_STATE_TIMEOUT);
+    button_sequence_node = BUTTON_TRIE_ROOT;
+    button_gap_pending = false;
 }
 
-static void button_press_handler()
+static void button_sequence_match(button_press_e press)
 {
-    am_hal_gpio_interrupt_disable(AM_HAL_GPIO_BIT(AM_BSP_GPIO_BUTTON0));
-    am_hal_gpio_interrupt_clear(AM_HAL_GPIO_BIT(AM_BSP_GPIO_BUTTON0));
-
-    button_task_send_command(BUTTON_STATE_PRESSED);
+    switch (button_trie_step(&button_sequence_node, press))
+    {
+    case BUTTON_TRIE_MATCH:
+        // unambiguous, fire without waiting for the gap to expire
+        button_trie_execute(button_sequence_node);
+        button_sequence_reset();
+        break;
+
+    case BUTTON_TRIE_PREFIX:
+    case BUTTON_TRIE_AMBIGUOUS:
+        // wait for the next press before deciding
+        button_gap_pending = true;
+        button_gap_deadline = xTaskGetTickCount() + pdMS_TO_TICKS(BUTTON_PRESS_GAP_MS);
+        break;
+
+    default:
+        // nothing registered starts with these presses
+        button_sequence_reset();
+        break;
+    }
 }
 
-static button_press_e button_press_classification()
+static void button_transition(uint32_t level, uint32_t timestamp)
 {
-    uint32_t initial_state;
-    uint32_t current_state;
-    uint32_t duration;
+    button_level = level;
+    button_edge_timestamp = timestamp;
+
+    if (level == BUTTON_LEVEL_PRESSED)
+    {
+        button_press_timestamp = timestamp;
+        button_gap_pending = false;
+        return;
+    }
 
-    xTimerStop(button_timer_handle, portMAX_DELAY);
+    uint32_t duration = perf_interval_us(button_press_timestamp, timestamp) / 1000;
+    button_press_e press = (duration < BUTTON_PRESS_SHORT_MS) ? BUTTON_PRESS_SHORT : BUTTON_PRESS_LONG;
 
-    vTaskDelay(pdMS_TO_TICKS(BUTTON_DEBOUNCE_DELAY_MS));
-    am_hal_gpio_state_read(AM_BSP_GPIO_BUTTON0, AM_HAL_GPIO_INPUT_READ, &initial_state);
-    if (initial_state == 1)
+    LOG_DEBUG("button: %s press, %d ms", (press == BUTTON_PRESS_SHORT) ? "short" : "long", duration);
+
+    button_sequence_match(press);
+}
+
+static void button_edge(const button_edge_t *edge)
+{
+    if (edge->level == button_level)
     {
-        am_hal_gpio_interrupt_clear(AM_HAL_GPIO_BIT(AM_BSP_GPIO_BUTTON0));
-        am_hal_gpio_interrupt_enable(AM_HAL_GPIO_BIT(AM_BSP_GPIO_BUTTON0));
-        return BUTTON_PRESS_SHORT;
+        return;
     }
 
-    duration = BUTTON_DEBOUNCE_DELAY_MS;
-    current_state = initial_state;
-    while (current_state == initial_state)
+    // an edge inside the debounce window is contact bounce; look at the pin
+    // again once it has settled in case the state really changed
+    if (perf_interval_us(button_edge_timestamp, edge->timestamp) <
+        (BUTTON_DEBOUNCE_DELAY_MS * 1000))
     {
-        vTaskDelay(pdMS_TO_TICKS(BUTTON_PRESS_SAMPLING_MS));
-        am_hal_gpio_state_read(AM_BSP_GPIO_BUTTON0, AM_HAL_GPIO_INPUT_READ, &current_state);
-        duration += BUTTON_PRESS_SAMPLING_MS;
+        button_recheck_pending = true;
+        button_recheck_deadline = xTaskGetTickCount() + pdMS_TO_TICKS(BUTTON_DEBOUNCE_DELAY_MS);
+        return;
     }
 
-    am_hal_gpio_interrupt_clear(AM_HAL_GPIO_BIT(AM_BSP_GPIO_BUTTON0));
-    am_hal_gpio_interrupt_enable(AM_HAL_GPIO_BIT(AM_BSP_GPIO_BUTTON0));
+    button_transition(edge->level, edge->timestamp);
+}
 
-    xTimerChangePeriod(button_timer_handle, pdMS_TO_TICKS(BUTTON_PRESS_GAP_MS), portMAX_DELAY);
+static bool button_deadline_expired(TickType_t deadline, TickType_t now)
+{
+    return (int32_t)(deadline - now) <= 0;
+}
+
+static void button_deadlines()
+{
+    TickType_t now = xTaskGetTickCount();
 
-    if (duration < BUTTON_PRESS_SHORT_MS)
+    if (button_recheck_pending && button_deadline_expired(button_recheck_deadline, now))
     {
-        return BUTTON_PRESS_SHORT;
+        uint32_t level;
+
+        button_recheck_pending = false;
+        am_hal_gpio_state_read(AM_BSP_GPIO_BUTTON0, AM_HAL_GPIO_INPUT_READ, &level);
+        if (level != button_level)
+        {
+            button_transition(level, perf_timestamp());
+        }
     }
 
-    return BUTTON_PRESS_LONG;
+    if (button_gap_pending && button_deadline_expired(button_gap_deadline, now))
+    {
+        button_trie_execute(button_sequence_node);
+        button_sequence_reset();
+    }
 }
 
-static void button_sequence_set_bit(uint32_t *pSequence, uint32_t count, button_press_e press)
+static TickType_t button_next_timeout()
 {
-    *pSequence |= (press << count);
-}
+    TickType_t now = xTaskGetTickCount();
+    TickType_t timeout = portMAX_DELAY;
 
-static void button_sequence_execute()
-{
-    ListItem_t *pItem = listGET_HEAD_ENTRY(&button_sequence_list);
+    if (button_recheck_pending)
+    {
+        timeout = button_deadline_expired(button_recheck_deadline, now)
+                      ? 0
+                      : button_recheck_deadline - now;
+    }
 
-    while (pItem != (ListItem_t *)&(button_sequence_list.xListEnd))
+    if (button_gap_pending)
     {
-        button_sequence_u seq = (button_sequence_u)pItem->xItemValue;
-        if (button_state_counter == seq.sequence.size)
+        TickType_t gap = button_deadline_expired(button_gap_deadline, now)
+                             ? 0
+                             : button_gap_deadline - now;
+        if (gap < timeout)
         {
-            if (ui32ButtonSequence == seq.sequence.sequence)
-            {
-                sequence_callback_t callback = (sequence_callback_t)pItem->pvOwner;
-                if (callback != NULL)
-                {
-                    callback();
-                    pItem = listGET_NEXT(pItem);
-                    continue;
-                }
-            }
+            timeout = gap;
         }
-        pItem = listGET_NEXT(pItem);
     }
+
+    return timeout;
 }
 
 static void button_task(void *parameter)
 {
-    button_command_e command;
-    button_press_e press_type;
+    button_edge_t edge;
+
+    logger_register_task();
+
+    am_hal_gpio_state_read(AM_BSP_GPIO_BUTTON0, AM_HAL_GPIO_INPUT_READ, &button_level);
+    button_edge_timestamp = perf_timestamp();
 
     while (1)
     {
-        if (xQueueReceive(button_queue_handle, &command, portMAX_DELAY) == pdPASS)
+        if (xQueueReceive(button_queue_handle, &edge, button_next_timeout()) == pdPASS)
         {
-            switch(command)
-            {
-            case BUTTON_STATE_PRESSED:
-                press_type = button_press_classification();
-                button_sequence_set_bit(&ui32ButtonSequence, button_state_counter, press_type);
-                button_state_counter++;
-                break;
-
-            case BUTTON_STATE_TIMEOUT:
-                button_sequence_execute();
-                button_state_counter = 0;
-                ui32ButtonSequence = 0;
-                break;
-
-            default:
-                button_state_counter = 0;
-                ui32ButtonSequence = 0;
-                break;
-            }
+            button_edge(&edge);
         }
-     }
+        button_deadlines();
+    }
 }
 
 void button_task_create(uint32_t priority)
 {
-    button_state_counter = 0;
-    ui32ButtonSequence = 0;
+    am_hal_gpio_pincfg_t button_config = g_AM_BSP_GPIO_BUTTON0;
+
+    button_sequence_reset();
+    button_recheck_pending = false;
+
+    button_trie_init();
+    button_queue_handle = RTOS_QUEUE_CREATE(button, BUTTON_QUEUE_LENGTH, sizeof(button_edge_t));
 
-    am_hal_gpio_pinconfig(AM_BSP_GPIO_BUTTON0, g_AM_BSP_GPIO_BUTTON0);
-    am_hal_gpio_interrupt_register(AM_BSP_GPIO_BUTTON0, button_press_handler);
+    button_config.eIntDir = AM_HAL_GPIO_PIN_INTDIR_BOTH;
+    am_hal_gpio_pinconfig(AM_BSP_GPIO_BUTTON0, button_config);
+    am_hal_gpio_interrupt_register(AM_BSP_GPIO_BUTTON0, button_edge_handler);
     am_hal_gpio_interrupt_clear(AM_HAL_GPIO_BIT(AM_BSP_GPIO_BUTTON0));
     am_hal_gpio_interrupt_enable(AM_HAL_GPIO_BIT(AM_BSP_GPIO_BUTTON0));
     NVIC_EnableIRQ(GPIO_IRQn);
- 
-    xTaskCreate(button_task, "Button Task", 512, 0, priority, &button_task_handle);
-    button_queue_handle = xQueueCreate(16, sizeof(button_command_e));
-    button_timer_handle = xTimerCreate(
-        "Button Timer",
-        pdMS_TO_TICKS(1000),
-        pdFALSE,
-        NULL,
-        button_task_timer_callback);
-
-    vListInitialise(&button_sequence_list);    
-}
 
+    RTOS_TASK_CREATE(button_task,
+                     button_task,
+                     "Button Task",
+                     BUTTON_TASK_STACK_SIZE,
+                     0,
+                     priority,
+                     &button_task_handle);
+}
 void button_sequence_register(uint8_t size, uint32_t value, sequence_callback_t cb)
 {
-    ListItem_t *pItem = pvPortMalloc(sizeof(ListItem_t));
-    vListInitialiseItem(pItem);
-    vListInsert(&button_sequence_list, pItem);
+    bool inserted;
 
-    button_sequence_u seq;
-    seq.sequence.size     = size;
-    seq.sequence.sequence = value;
+    vTaskSuspendAll();
+    inserted = button_trie_insert(size, value, cb);
+    xTaskResumeAll();
 
-    pItem->xItemValue = seq.value;
-    pItem->pvOwner = cb;
+    if (!inserted)
+    {
+        LOG_ERROR("button: unable to register sequence 0x%x of %d presses", value, size);
+    }
 }
 
 void button_sequence_unregister(uint8_t size, uint32_t value, sequence_callback_t cb)
 {
-    ListItem_t *pItem = listGET_HEAD_ENTRY(&button_sequence_list);
-
-    while (pItem != (ListItem_t *)&(button_sequence_list.xListEnd))
-    {
-        button_sequence_u seq = (button_sequence_u)pItem->xItemValue;
-        if (size == seq.sequence.size)
-        {
-            if (value == seq.sequence.sequence)
-            {
-                sequence_callback_t callback = (sequence_callback_t)pItem->pvOwner;
-                if (callback == cb)
-                {
-                    uxListRemove(pItem);
-                    vPortFree(pItem);
-                    return;
-                }
-            }
-        }
-        pItem = listGET_NEXT(pItem);
-    }
-}
\ No newline at end of file
+    vTaskSuspendAll();
+    button_trie_remove(size, value, cb);
+    xTaskResumeAll();
+}
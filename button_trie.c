@@ -0,0 +1,222 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stddef.h>
+
+#include "button_trie.h"
+
+#define BUTTON_TRIE_NULL (0)
+
+typedef struct
+{
+    uint16_t child[2];  // BUTTON_TRIE_NULL when absent, the root is never a child
+    uint16_t callbacks; // 1-based index into the callback pool
+    uint16_t next_free;
+} button_trie_node_t;
+
+typedef struct
+{
+    sequence_callback_t callback;
+    uint16_t next; // 1-based, BUTTON_TRIE_NULL terminates
+} button_trie_callback_t;
+
+static button_trie_node_t button_trie_nodes[BUTTON_TRIE_MAX_NODES];
+static button_trie_callback_t button_trie_callbacks[BUTTON_TRIE_MAX_CALLBACKS];
+static uint16_t button_trie_free_nodes;
+static uint16_t button_trie_free_node_count;
+static uint16_t button_trie_free_callbacks;
+
+static uint16_t button_trie_node_alloc(void)
+{
+    uint16_t node = button_trie_free_nodes;
+
+    button_trie_free_nodes = button_trie_nodes[node].next_free;
+    button_trie_free_node_count--;
+
+    button_trie_nodes[node].child[0] = BUTTON_TRIE_NULL;
+    button_trie_nodes[node].child[1] = BUTTON_TRIE_NULL;
+    button_trie_nodes[node].callbacks = BUTTON_TRIE_NULL;
+
+    return node;
+}
+
+static void button_trie_node_free(uint16_t node)
+{
+    button_trie_nodes[node].next_free = button_trie_free_nodes;
+    button_trie_free_nodes = node;
+    button_trie_free_node_count++;
+}
+
+static bool button_trie_node_empty(uint16_t node)
+{
+    return (button_trie_nodes[node].callbacks == BUTTON_TRIE_NULL) &&
+           (button_trie_nodes[node].child[0] == BUTTON_TRIE_NULL) &&
+           (button_trie_nodes[node].child[1] == BUTTON_TRIE_NULL);
+}
+
+void button_trie_init(void)
+{
+    button_trie_nodes[BUTTON_TRIE_ROOT].child[0] = BUTTON_TRIE_NULL;
+    button_trie_nodes[BUTTON_TRIE_ROOT].child[1] = BUTTON_TRIE_NULL;
+    button_trie_nodes[BUTTON_TRIE_ROOT].callbacks = BUTTON_TRIE_NULL;
+
+    button_trie_free_nodes = BUTTON_TRIE_NULL;
+    button_trie_free_node_count = 0;
+    for (uint16_t i = BUTTON_TRIE_MAX_NODES - 1; i > BUTTON_TRIE_ROOT; i--)
+    {
+        button_trie_node_free(i);
+    }
+
+    button_trie_free_callbacks = BUTTON_TRIE_NULL;
+    for (uint16_t i = BUTTON_TRIE_MAX_CALLBACKS; i > 0; i--)
+    {
+        button_trie_callbacks[i - 1].next = button_trie_free_callbacks;
+        button_trie_free_callbacks = i;
+    }
+}
+
+bool button_trie_insert(uint8_t size, uint32_t value, sequence_callback_t cb)
+{
+    uint16_t node = BUTTON_TRIE_ROOT;
+    uint8_t depth = 0;
+
+    if ((size == 0) || (size > 32) || (button_trie_free_callbacks == BUTTON_TRIE_NULL))
+    {
+        return false;
+    }
+
+    // follow the existing part of the path first so that nothing is changed
+    // when the pool cannot hold the rest of it
+    while ((depth < size) &&
+           (button_trie_nodes[node].child[(value >> depth) & 0x01] != BUTTON_TRIE_NULL))
+    {
+        node = button_trie_nodes[node].child[(value >> depth) & 0x01];
+        depth++;
+    }
+
+    if ((size - depth) > button_trie_free_node_count)
+    {
+        return false;
+    }
+
+    for (; depth < size; depth++)
+    {
+        uint16_t child = button_trie_node_alloc();
+        button_trie_nodes[node].child[(value >> depth) & 0x01] = child;
+        node = child;
+    }
+
+    uint16_t entry = button_trie_free_callbacks;
+    button_trie_free_callbacks = button_trie_callbacks[entry - 1].next;
+    button_trie_callbacks[entry - 1].callback = cb;
+    button_trie_callbacks[entry - 1].next = button_trie_nodes[node].callbacks;
+    button_trie_nodes[node].callbacks = entry;
+
+    return true;
+}
+
+bool button_trie_remove(uint8_t size, uint32_t value, sequence_callback_t cb)
+{
+    uint16_t path[33];
+    uint16_t node = BUTTON_TRIE_ROOT;
+
+    if ((size == 0) || (size > 32))
+    {
+        return false;
+    }
+
+    path[0] = BUTTON_TRIE_ROOT;
+    for (uint8_t depth = 0; depth < size; depth++)
+    {
+        node = button_trie_nodes[node].child[(value >> depth) & 0x01];
+        if (node == BUTTON_TRIE_NULL)
+        {
+            return false;
+        }
+        path[depth + 1] = node;
+    }
+
+    uint16_t *link = &button_trie_nodes[node].callbacks;
+    while ((*link != BUTTON_TRIE_NULL) && (button_trie_callbacks[*link - 1].callback != cb))
+    {
+        link = &button_trie_callbacks[*link - 1].next;
+    }
+    if (*link == BUTTON_TRIE_NULL)
+    {
+        return false;
+    }
+
+    uint16_t entry = *link;
+    *link = button_trie_callbacks[entry - 1].next;
+    button_trie_callbacks[entry - 1].next = button_trie_free_callbacks;
+    button_trie_free_callbacks = entry;
+
+    // release the nodes that no longer lead to any sequence
+    for (uint8_t depth = size; (depth > 0) && button_trie_node_empty(path[depth]); depth--)
+    {
+        button_trie_nodes[path[depth - 1]].child[(value >> (depth - 1)) & 0x01] = BUTTON_TRIE_NULL;
+        button_trie_node_free(path[depth]);
+    }
+
+    return true;
+}
+
+button_trie_result_e button_trie_step(uint16_t *node, uint32_t press)
+{
+    uint16_t next = button_trie_nodes[*node].child[press & 0x01];
+
+    if (next == BUTTON_TRIE_NULL)
+    {
+        return BUTTON_TRIE_NONE;
+    }
+    *node = next;
+
+    bool extendable = (button_trie_nodes[next].child[0] != BUTTON_TRIE_NULL) ||
+                      (button_trie_nodes[next].child[1] != BUTTON_TRIE_NULL);
+    if (button_trie_nodes[next].callbacks == BUTTON_TRIE_NULL)
+    {
+        return BUTTON_TRIE_PREFIX;
+    }
+
+    return extendable ? BUTTON_TRIE_AMBIGUOUS : BUTTON_TRIE_MATCH;
+}
+
+void button_trie_execute(uint16_t node)
+{
+    for (uint16_t entry = button_trie_nodes[node].callbacks; entry != BUTTON_TRIE_NULL;
+         entry = button_trie_callbacks[entry - 1].next)
+    {
+        if (button_trie_callbacks[entry - 1].callback != NULL)
+        {
+            button_trie_callbacks[entry - 1].callback();
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _BUTTON_TRIE_H_
+#define _BUTTON_TRIE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "button.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Registered button sequences are kept in a binary prefix tree indexed by the
+// press type (0 short, 1 long), allocated from fixed pools.  The matcher walks
+// one node per press.
+//
+#ifndef BUTTON_TRIE_MAX_NODES
+#define BUTTON_TRIE_MAX_NODES (32)
+#endif
+
+#ifndef BUTTON_TRIE_MAX_CALLBACKS
+#define BUTTON_TRIE_MAX_CALLBACKS (16)
+#endif
+
+#define BUTTON_TRIE_ROOT (0)
+
+typedef enum
+{
+    BUTTON_TRIE_NONE,     // no registered sequence starts with these presses
+    BUTTON_TRIE_PREFIX,   // only longer sequences match so far
+    BUTTON_TRIE_MATCH,    // complete match and nothing longer, fire now
+    BUTTON_TRIE_AMBIGUOUS // complete match, but a longer sequence may follow
+} button_trie_result_e;
+
+extern void button_trie_init(void);
+extern bool button_trie_insert(uint8_t size, uint32_t value, sequence_callback_t cb);
+extern bool button_trie_remove(uint8_t size, uint32_t value, sequence_callback_t cb);
+
+//
+// Advance *node by one press.  Start every sequence from BUTTON_TRIE_ROOT.
+//
+extern button_trie_result_e button_trie_step(uint16_t *node, uint32_t press);
+extern void button_trie_execute(uint16_t node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
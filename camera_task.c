@@ -36,20 +36,32 @@
 
 #include <FreeRTOS.h>
 #include <queue.h>
+#include <semphr.h>
 #include <task.h>
 #include <timers.h>
 
 #include <am_bsp.h>
 
+#include "ArducamAmbiqHAL.h"
 #include "ArducamCamera.h"
 #include "ArducamLink.h"
 
 #include "camera_task.h"
 #include "camera_task_cli.h"
 #include "console_task.h"
+#include "governor.h"
+#include "image_dump.h"
+#include "image_preprocess.h"
+#include "logger.h"
+#include "overlay.h"
+#include "perf.h"
+#include "rtos_alloc.h"
 
 #define COMMAND_BUFFER_LEN (64)
 
+#define CAMERA_TASK_STACK_SIZE (512)
+#define CAMERA_QUEUE_LENGTH    (10)
+
 static ArducamCamera camera;
 static uint8_t command_buffer[COMMAND_BUFFER_LEN];
 static uint8_t command_length;
@@ -57,23 +69,46 @@ static uint8_t sendFlag = TRUE;
 static uint32_t camera_stream_read = 0;
 static uint8_t camera_stream_started = 0;
 
-static uint8_t r_max, g_max, b_max;
-
 static TaskHandle_t camera_task_handle;
 static QueueHandle_t camera_queue_handle;
 static TimerHandle_t camera_timer_handle;
-
-#define IMAGE_PROCESS_BLOCK_SIZE (192)
-#define IMAGE_WIDTH  (32)
-#define IMAGE_HEIGHT (32)
-#define IMAGE_CHANNEL (3)
-#define IMAGE_SIZE  (IMAGE_WIDTH * IMAGE_HEIGHT * IMAGE_CHANNEL)
-
-static uint8_t image_process_buffer[IMAGE_PROCESS_BLOCK_SIZE];
-static uint8_t image_rgb888[IMAGE_SIZE];
-static uint8_t image_row_index, image_column_index;
-static uint32_t image_process_index = 0;
+static TimerHandle_t camera_idle_timer_handle;
+static SemaphoreHandle_t camera_power_mutex;
+
+RTOS_TASK_STORAGE(camera_task, CAMERA_TASK_STACK_SIZE)
+RTOS_QUEUE_STORAGE(camera, CAMERA_QUEUE_LENGTH, sizeof(camera_message_t))
+RTOS_TIMER_STORAGE(camera_stream)
+RTOS_TIMER_STORAGE(camera_idle)
+RTOS_SEMAPHORE_STORAGE(camera_power)
+
+static uint32_t camera_idle_timeout_ms = CAMERA_IDLE_TIMEOUT_MS;
+static TickType_t camera_last_active;
+static bool camera_asleep;
+static bool camera_streaming;
+static camera_power_stats_t camera_power_stats;
+
+#define IMAGE_PROCESS_BLOCK_SIZE (IMAGE_SOURCE_ROW_SIZE)
+
+// anything read beyond the end of a raw capture is dropped here
+static uint8_t camera_raw_discard[IMAGE_PROCESS_BLOCK_SIZE];
+
+// A still capture works in memory leased from the model, see overlay.h.  The
+// image is kept there for cam dump until the model needs the memory back.
+static uint8_t *image_process_buffer;
+static uint8_t *image_rgb888;
+static uint8_t *image_kept;
+static uint32_t image_kept_generation;
+static image_preprocess_t image_preprocess;
 static uint32_t image_capture_state = 0;
+static uint32_t image_capture_start;
+static uint32_t image_preprocess_us;
+static bool image_capture_cold;
+
+// destination of a raw capture requested with camera_capture_raw()
+static uint8_t *camera_raw_buffer;
+static size_t camera_raw_size;
+static size_t camera_raw_length;
+static TaskHandle_t camera_raw_waiter;
 
 typedef struct camera_event_callback_s
 {
@@ -83,6 +118,79 @@ typedef struct camera_event_callback_s
 
 static camera_event_callback_t camera_event_callback[CAMERA_COMMAND_MAXLEN];
 
+static bool camera_idle(void)
+{
+    return (image_capture_state == 0) && (camera.receivedLength == 0) && !camera_streaming;
+}
+
+//
+// Take the camera for an operation, powering it up if the idle policy put it
+// to sleep.  Only the cached settings registers are written back, the sensor
+// is not reset and begin() is not repeated.  Returns true if the camera was
+// woken.
+//
+static bool camera_power_acquire(void)
+{
+    bool woken = false;
+
+    xSemaphoreTake(camera_power_mutex, portMAX_DELAY);
+    xTimerStop(camera_idle_timer_handle, portMAX_DELAY);
+    if (camera_asleep)
+    {
+        uint32_t start = perf_timestamp();
+        camera_wake();
+        lowPowerOff(&camera);
+        camera_reg_restore();
+        camera_power_stats.wake_us = perf_elapsed_us(start);
+        camera_asleep = false;
+        woken = true;
+    }
+
+    return woken;
+}
+
+static void camera_power_release(void)
+{
+    camera_last_active = xTaskGetTickCount();
+    if ((camera_idle_timeout_ms > 0) && camera_idle())
+    {
+        xTimerChangePeriod(
+            camera_idle_timer_handle, pdMS_TO_TICKS(camera_idle_timeout_ms), portMAX_DELAY);
+    }
+    xSemaphoreGive(camera_power_mutex);
+}
+
+static void camera_power_down(void)
+{
+    xSemaphoreTake(camera_power_mutex, portMAX_DELAY);
+    // an idle event may be stale if the camera was used after it was queued
+    TickType_t idle = xTaskGetTickCount() - camera_last_active;
+    if (!camera_asleep && camera_idle() && (camera_idle_timeout_ms > 0) &&
+        (idle >= pdMS_TO_TICKS(camera_idle_timeout_ms)))
+    {
+        lowPowerOn(&camera);
+        camera_sleep();
+        camera_asleep = true;
+        camera_power_stats.sleeps++;
+        LOG_DEBUG("camera asleep");
+    }
+    xSemaphoreGive(camera_power_mutex);
+}
+
+static void camera_latency_record(camera_latency_t *latency, uint32_t us)
+{
+    if ((latency->count == 0) || (us < latency->min_us))
+    {
+        latency->min_us = us;
+    }
+    if (us > latency->max_us)
+    {
+        latency->max_us = us;
+    }
+    latency->total_us += us;
+    latency->count++;
+}
+
 uint8_t camera_process_command(ArducamCamera *cam, uint8_t *command)
 {
     camera_message_t message;
@@ -191,6 +299,13 @@ uint8_t camera_process_command(ArducamCamera *cam, uint8_t *command)
     return CAM_ERR_SUCCESS;
 }
 
+static void camera_idle_timer_callback(TimerHandle_t timer)
+{
+    camera_message_t message;
+    message.command = CAMERA_COMMAND_IDLE;
+    camera_task_send(&message);
+}
+
 static void camera_timer_callback(TimerHandle_t timer)
 {
     camera_message_t message;
@@ -204,7 +319,9 @@ static void camera_process_host_command(uint8_t ch)
     command_length++;
     if (ch == 0xAA)
     {
+        camera_power_acquire();
         camera_process_command(&camera, &command_buffer[1]);
+        camera_power_release();
         command_length = 0;
         memset(command_buffer, 0, COMMAND_BUFFER_LEN);
     }
@@ -256,52 +373,89 @@ static void camera_stop_preview(void)
     arducamUartWrite(0xBB);
 }
 
+static void camera_still_return(void)
+{
+    if (image_process_buffer)
+    {
+        overlay_return(image_process_buffer);
+        image_process_buffer = NULL;
+    }
+
+    if (image_rgb888)
+    {
+        overlay_return(image_rgb888);
+        image_rgb888 = NULL;
+    }
+}
+
+static bool camera_still_lease(void)
+{
+    image_kept = NULL;
+    image_rgb888 = overlay_lease(IMAGE_SIZE, portMAX_DELAY);
+    image_process_buffer = overlay_lease(IMAGE_PROCESS_BLOCK_SIZE, portMAX_DELAY);
+    if (!image_rgb888 || !image_process_buffer)
+    {
+        camera_still_return();
+        return false;
+    }
+
+    return true;
+}
+
+// Give the memory back but remember where the image is, it stays valid until
+// the model or another task uses the region.
+static void camera_still_keep(void)
+{
+    image_kept = image_rgb888;
+    camera_still_return();
+    image_kept_generation = overlay_generation();
+}
+
+static bool camera_still_reclaim(void)
+{
+    if (!image_kept)
+    {
+        return false;
+    }
+
+    image_rgb888 = overlay_lease(IMAGE_SIZE, portMAX_DELAY);
+    if ((image_rgb888 != image_kept) || (overlay_generation() != image_kept_generation))
+    {
+        image_kept = NULL;
+        camera_still_return();
+        return false;
+    }
+
+    return true;
+}
+
 static void camera_retrieve_still(void)
 {
     if (camera.receivedLength > 0)
     {
         // process only one block at a time to avoid blocking other tasks
-        uint32_t data_length = readBuff(&camera, image_process_buffer, IMAGE_PROCESS_BLOCK_SIZE);
+        uint8_t *block = camera_raw_buffer ? camera_raw_discard : image_process_buffer;
+        if (camera_raw_buffer && ((camera_raw_length + IMAGE_PROCESS_BLOCK_SIZE) <= camera_raw_size))
+        {
+            block = &camera_raw_buffer[camera_raw_length];
+        }
 
-        uint32_t i = 0;
-        while (i < data_length)
+        governor_token_t token = governor_enter(PERF_STAGE_CAPTURE);
+        uint32_t data_length = readBuff(&camera, block, IMAGE_PROCESS_BLOCK_SIZE);
+        governor_exit(PERF_STAGE_CAPTURE, token);
+
+        if (camera_raw_buffer)
         {
-            if ((image_row_index % 3) == 0)
-            {
-                if ((i % 3) == 0)
-                {
-                    uint8_t r_raw = (image_process_buffer[i] & 0b11111000) >> 3;
-                    uint8_t b_raw = (image_process_buffer[i+1] & 0b00011111);
-                    uint8_t g_upper = (image_process_buffer[i] & 0b00000111) << 3;
-                    uint8_t g_lower = (image_process_buffer[i+1] & 0b11100000) >> 5;
-                    uint8_t g_raw = g_upper | g_lower;
-                    i += 6;
-                    image_rgb888[image_process_index++] = r_raw;
-                    image_rgb888[image_process_index++] = g_raw;
-                    image_rgb888[image_process_index++] = b_raw;
-
-                    if (r_raw > r_max)
-                    {
-                        r_max = r_raw;
-                    }
-
-                    if (g_raw > g_max)
-                    {
-                        g_max = g_raw;
-                    }
-
-                    if (b_raw > b_max)
-                    {
-                        b_max = b_raw;
-                    }
-                }
-            }
-            else
-            {
-                break;
-            }
+            // anything beyond the destination is read and dropped
+            camera_raw_length += (block != camera_raw_discard) ? data_length : 0;
+        }
+        else
+        {
+            token = governor_enter(PERF_STAGE_PREPROCESS);
+            image_preprocess_row(&image_preprocess, image_process_buffer, data_length);
+            image_preprocess_us += perf_elapsed_us(token.start);
+            governor_exit(PERF_STAGE_PREPROCESS, token);
         }
-        image_row_index++;
 
         if (camera.receivedLength > 0)
         {
@@ -316,33 +470,26 @@ static void camera_retrieve_still(void)
             camera_task_send(&message);
         }
     }
-}
-
-static void camera_print_capture(void)
-{
-    am_util_stdio_printf("\r\n\r\n");
-    am_util_stdio_printf("Captured Image:\r\n");
-    for (int i = 0; i < IMAGE_SIZE; i += 3)
+    else if (camera_raw_buffer)
+    {
+        // nothing was captured, complete the request so the caller sees it
+        camera_message_t message;
+        message.command = CAMERA_COMMAND_STILL_RETRIEVE_DONE;
+        camera_task_send(&message);
+    }
+    else
     {
-        am_util_stdio_printf("0x%02x 0x%02x 0x%02x\r\n", image_rgb888[i], image_rgb888[i+1], image_rgb888[i+2]);
+        // nothing was captured, the model can have its memory back
+        camera_still_return();
     }
-     am_util_stdio_printf("\r\n\r\n");
 }
 
-static void camera_normalize()
+static void camera_print_capture(image_dump_encoding_e encoding, bool rle)
 {
-    uint32_t r, g, b, gray;
-    for (int i = 0; i < IMAGE_SIZE; i+=3)
-    {
-        r = image_rgb888[i] * 127 / r_max;
-        image_rgb888[i] = r;
-
-        g = image_rgb888[i+1] * 127 / g_max;
-        image_rgb888[i+1] = g;
-
-        b = image_rgb888[i+2] * 127 / b_max;
-        image_rgb888[i+2] = b;
-    }
+    am_util_stdio_printf("\r\n\r\n");
+    am_util_stdio_printf("Captured Image:\r\n");
+    image_dump(image_rgb888, IMAGE_WIDTH, IMAGE_HEIGHT, IMAGE_CHANNEL, encoding, rle);
+    am_util_stdio_printf("\r\n\r\n");
 }
 
 static void camera_setup()
@@ -363,8 +510,11 @@ static void camera_task(void *parameter)
 {
     camera_message_t message;
 
+    logger_register_task();
     camera_task_cli_register();
+    camera_power_acquire();
     camera_setup();
+    camera_power_release();
     while (1)
     {
         if (xQueueReceive(camera_queue_handle, &message, portMAX_DELAY) == pdPASS)
@@ -372,25 +522,49 @@ static void camera_task(void *parameter)
             switch (message.command)
             {
             case CAMERA_COMMAND_STREAM_START:
+                camera_power_acquire();
+                camera_streaming = true;
                 xTimerStart(camera_timer_handle, portMAX_DELAY);
+                camera_power_release();
                 break;
 
             case CAMERA_COMMAND_STREAM_STOP:
+                camera_power_acquire();
+                camera_streaming = false;
                 xTimerStop(camera_timer_handle, portMAX_DELAY);
+                camera_power_release();
                 break;
 
             case CAMERA_COMMAND_STREAM_REFRESH:
+                camera_power_acquire();
                 captureThread(&camera);
+                camera_power_release();
                 break;
 
             case CAMERA_COMMAND_STILL_CAPTURE:
-                image_process_index = 0;
-                image_row_index = 0;
-                image_column_index = 0;
+                if ((image_capture_state == 0) && !camera_raw_buffer && !camera_still_lease())
+                {
+                    LOG_ERROR("No memory for a still capture.");
+                    break;
+                }
+
+                if (image_capture_state == 0)
+                {
+                    image_capture_start = perf_timestamp();
+                    image_preprocess_us = 0;
+                    image_capture_cold = camera_power_acquire();
+                }
+                else
+                {
+                    camera_power_acquire();
+                }
                 takePicture(&camera,
                     (CAM_IMAGE_MODE)message.payload.capture_parameters.resolution,
                     (CAM_IMAGE_PIX_FMT)message.payload.capture_parameters.format);
-                memset(image_rgb888, 0, IMAGE_SIZE);
+                if (!camera_raw_buffer)
+                {
+                    image_preprocess_init(&image_preprocess, image_rgb888);
+                }
                 if (image_capture_state < 2)
                 {
                     image_capture_state++;
@@ -399,19 +573,41 @@ static void camera_task(void *parameter)
                 }
                 else
                 {
+                    camera_latency_record(
+                        image_capture_cold ? &camera_power_stats.cold : &camera_power_stats.warm,
+                        perf_elapsed_us(image_capture_start));
                     image_capture_state = 0;
-                    r_max = b_max = g_max = 0;
                     camera_retrieve_still();
                 }
+                camera_power_release();
                 break;
 
             case CAMERA_COMMAND_STILL_RETRIEVE:
+                camera_power_acquire();
                 camera_retrieve_still();
+                camera_power_release();
                 break;
 
             case CAMERA_COMMAND_STILL_RETRIEVE_DONE:
                 image_capture_state = 0;
-                camera_normalize();
+                if (camera_raw_buffer)
+                {
+                    perf_record(PERF_STAGE_CAPTURE, perf_elapsed_us(image_capture_start));
+                    camera_raw_buffer = NULL;
+                    xTaskNotify(camera_raw_waiter, camera_raw_length == camera_raw_size, eSetValueWithOverwrite);
+                    break;
+                }
+                {
+                    governor_token_t token = governor_enter(PERF_STAGE_PREPROCESS);
+                    image_preprocess_normalize(&image_preprocess);
+                    image_preprocess_us += perf_elapsed_us(token.start);
+                    governor_exit(PERF_STAGE_PREPROCESS, token);
+
+                    // retrieval and preprocessing are interleaved row by row
+                    perf_record(PERF_STAGE_CAPTURE,
+                                perf_elapsed_us(image_capture_start) - image_preprocess_us);
+                    perf_record(PERF_STAGE_PREPROCESS, image_preprocess_us);
+                }
                 if (camera_event_callback[CAMERA_COMMAND_STILL_RETRIEVE_DONE].handler)
                 {
                     camera_event_callback[CAMERA_COMMAND_STILL_RETRIEVE_DONE].handler(image_rgb888, IMAGE_SIZE);
@@ -419,8 +615,25 @@ static void camera_task(void *parameter)
                 else
                 {
                     am_util_stdio_printf("No callback attached, displaying raw capture:\r\n");
-                    camera_print_capture();
+                    camera_print_capture(IMAGE_DUMP_BASE64, true);
+                }
+                camera_still_keep();
+                break;
+
+            case CAMERA_COMMAND_DUMP:
+                if (!camera_still_reclaim())
+                {
+                    am_util_stdio_printf("\r\nNo capture to dump, the memory has been used since.\r\n");
+                    break;
                 }
+                camera_print_capture(
+                    (image_dump_encoding_e)message.payload.dump_parameters.encoding,
+                    message.payload.dump_parameters.rle);
+                camera_still_return();
+                break;
+
+            case CAMERA_COMMAND_IDLE:
+                camera_power_down();
                 break;
 
             default:
@@ -433,9 +646,19 @@ static void camera_task(void *parameter)
 void camera_task_create(uint32_t priority)
 {
     memset(camera_event_callback, 0, sizeof(camera_event_callback));
-    camera_queue_handle = xQueueCreate(10, sizeof(camera_message_t));
-    camera_timer_handle = xTimerCreate("camera timer", 50, pdTRUE, NULL, camera_timer_callback);
-    xTaskCreate(camera_task, "camera", 512, 0, priority, &camera_task_handle);
+    camera_queue_handle = RTOS_QUEUE_CREATE(camera, CAMERA_QUEUE_LENGTH, sizeof(camera_message_t));
+    camera_timer_handle = RTOS_TIMER_CREATE(
+        camera_stream, "camera timer", 50, pdTRUE, NULL, camera_timer_callback);
+    camera_idle_timer_handle = RTOS_TIMER_CREATE(
+        camera_idle, "camera idle", pdMS_TO_TICKS(1000), pdFALSE, NULL, camera_idle_timer_callback);
+    camera_power_mutex = RTOS_MUTEX_CREATE(camera_power);
+    RTOS_TASK_CREATE(camera_task,
+                     camera_task,
+                     "camera",
+                     CAMERA_TASK_STACK_SIZE,
+                     0,
+                     priority,
+                     &camera_task_handle);
 }
 
 void camera_task_send(camera_message_t *message)
@@ -468,3 +691,39 @@ void camera_event_subscribe(camera_command_t event, camera_event_handler_t handl
         }
     }
 }
+
+bool camera_capture_raw(uint8_t *buffer, size_t size)
+{
+    camera_message_t message;
+    uint32_t complete;
+
+    camera_raw_size = size;
+    camera_raw_length = 0;
+    camera_raw_waiter = xTaskGetCurrentTaskHandle();
+    camera_raw_buffer = buffer;
+    xTaskNotifyStateClear(NULL);
+
+    message.command = CAMERA_COMMAND_STILL_CAPTURE;
+    message.payload.capture_parameters.resolution = CAM_IMAGE_MODE_96X96;
+    message.payload.capture_parameters.format = CAM_IMAGE_PIX_FMT_RGB565;
+    camera_task_send(&message);
+
+    xTaskNotifyWait(0, UINT32_MAX, &complete, portMAX_DELAY);
+    return complete != 0;
+}
+
+void camera_set_idle_timeout(uint32_t milliseconds)
+{
+    camera_power_acquire();
+    camera_idle_timeout_ms = milliseconds;
+    camera_power_release();
+}
+
+void camera_get_power_stats(camera_power_stats_t *stats)
+{
+    xSemaphoreTake(camera_power_mutex, portMAX_DELAY);
+    *stats = camera_power_stats;
+    stats->idle_timeout_ms = camera_idle_timeout_ms;
+    stats->asleep = camera_asleep;
+    xSemaphoreGive(camera_power_mutex);
+}
@@ -32,8 +32,18 @@
 #ifndef _CAMERA_TASK_H_
 #define _CAMERA_TASK_H_
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+//
+// Time without camera activity after which the sensor is put into low power
+// mode and the IOM is powered down.  0 keeps the camera always on.
+//
+#ifndef CAMERA_IDLE_TIMEOUT_MS
+#define CAMERA_IDLE_TIMEOUT_MS (5000)
+#endif
+
 typedef enum camera_command_e {
     CAMERA_COMMAND_STREAM_START,
     CAMERA_COMMAND_STREAM_STOP,
@@ -41,6 +51,8 @@ typedef enum camera_command_e {
     CAMERA_COMMAND_STILL_CAPTURE,
     CAMERA_COMMAND_STILL_RETRIEVE,
     CAMERA_COMMAND_STILL_RETRIEVE_DONE,
+    CAMERA_COMMAND_DUMP,
+    CAMERA_COMMAND_IDLE,
     CAMERA_COMMAND_MAXLEN
 } camera_command_t;
 
@@ -50,10 +62,17 @@ typedef struct camera_capture_parameters_s
     uint16_t format;
 } camera_capture_parameters_t;
 
+typedef struct camera_dump_parameters_s
+{
+    uint8_t encoding;
+    uint8_t rle;
+} camera_dump_parameters_t;
+
 typedef union camera_message_payload_u
 {
     uint8_t *buffer;
     camera_capture_parameters_t capture_parameters;
+    camera_dump_parameters_t dump_parameters;
 } camera_message_payload_t;
 
 typedef struct camera_message_s
@@ -62,10 +81,33 @@ typedef struct camera_message_s
     camera_message_payload_t payload;
 } camera_message_t;
 
+typedef struct camera_latency_s
+{
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} camera_latency_t;
+
+typedef struct camera_power_stats_s
+{
+    uint32_t idle_timeout_ms;
+    uint32_t asleep;
+    uint32_t sleeps;
+    uint32_t wake_us;          // last power up and register restore
+    camera_latency_t cold;     // capture request to first frame, camera asleep
+    camera_latency_t warm;     // capture request to first frame, camera on
+} camera_power_stats_t;
+
+// the image passed to a still capture handler is only valid during the call
 typedef void (*camera_event_handler_t)(uint8_t *, size_t size);
 
 extern void camera_task_create(uint32_t priority);
 extern void camera_task_send(camera_message_t *message);
 extern void camera_event_subscribe(camera_command_t event, camera_event_handler_t handler);
+// capture a raw frame into buffer and wait for it, the caller must be a task
+extern bool camera_capture_raw(uint8_t *buffer, size_t size);
+extern void camera_set_idle_timeout(uint32_t milliseconds);
+extern void camera_get_power_stats(camera_power_stats_t *stats);
 
 #endif
\ No newline at end of file
@@ -42,6 +42,7 @@
 
 #include "camera_task.h"
 #include "camera_task_cli.h"
+#include "image_dump.h"
 
 static portBASE_TYPE camera_task_cli_entry(char *pui8OutBuffer,
                                                 size_t ui32OutBufferLength,
@@ -63,6 +64,13 @@ static void help(char *pui8OutBuffer, size_t argc, char **argv)
     strcat(pui8OutBuffer, "\r\nusage: cam <command>\r\n");
     strcat(pui8OutBuffer, "\r\n");
     strcat(pui8OutBuffer, "supported commands are:\r\n");
+    strcat(pui8OutBuffer, "  capture                   capture and classify a still image\r\n");
+    strcat(pui8OutBuffer, "  retrieve                  retrieve the pending still image\r\n");
+    strcat(pui8OutBuffer, "  dump [base64|binary] [rle]\r\n");
+    strcat(pui8OutBuffer, "                            dump the last processed capture\r\n");
+    strcat(pui8OutBuffer, "  idle [ms]                 power the camera down after ms idle,\r\n");
+    strcat(pui8OutBuffer, "                            0 keeps it always on\r\n");
+    strcat(pui8OutBuffer, "  power                     idle policy and wake latency\r\n");
 }
 
 static void capture(char *pui8OutBuffer, size_t argc, char **argv)
@@ -82,6 +90,68 @@ static void retrieve(char *pui8OutBuffer, size_t argc, char **argv)
     camera_task_send(&message);
 }
 
+static void dump(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    camera_message_t message;
+    message.command = CAMERA_COMMAND_DUMP;
+    message.payload.dump_parameters.encoding = IMAGE_DUMP_BASE64;
+    message.payload.dump_parameters.rle = 0;
+
+    for (size_t i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "binary") == 0)
+        {
+            message.payload.dump_parameters.encoding = IMAGE_DUMP_BINARY;
+        }
+        else if (strcmp(argv[i], "base64") == 0)
+        {
+            message.payload.dump_parameters.encoding = IMAGE_DUMP_BASE64;
+        }
+        else if (strcmp(argv[i], "rle") == 0)
+        {
+            message.payload.dump_parameters.rle = 1;
+        }
+    }
+
+    camera_task_send(&message);
+}
+
+static void idle(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    if (argc > 2)
+    {
+        camera_set_idle_timeout(strtoul(argv[2], NULL, 0));
+    }
+}
+
+static void power_latency(const char *name, camera_latency_t *latency)
+{
+    am_util_stdio_printf("%s: %d captures", name, latency->count);
+    if (latency->count > 0)
+    {
+        am_util_stdio_printf(", min %d us, mean %d us, max %d us",
+                             latency->min_us,
+                             (uint32_t)(latency->total_us / latency->count),
+                             latency->max_us);
+    }
+    am_util_stdio_printf("\r\n");
+}
+
+static void power(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    camera_power_stats_t stats;
+    camera_get_power_stats(&stats);
+
+    am_util_stdio_printf("\r\ncamera %s, idle timeout %d ms, %d sleeps, last wake %d us\r\n",
+                         stats.asleep ? "asleep" : "on",
+                         stats.idle_timeout_ms,
+                         stats.sleeps,
+                         stats.wake_us);
+    am_util_stdio_printf("capture request to first frame\r\n");
+    power_latency("  from sleep", &stats.cold);
+    power_latency("  always on ", &stats.warm);
+}
+
 portBASE_TYPE
 camera_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const char *pui8Command)
 {
@@ -106,6 +176,18 @@ camera_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const cha
     {
         retrieve(pui8OutBuffer, argc, argv);
     }
+    else if (strcmp(argv[1], "dump") == 0)
+    {
+        dump(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "idle") == 0)
+    {
+        idle(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "power") == 0)
+    {
+        power(pui8OutBuffer, argc, argv);
+    }
 
 
     return pdFALSE;
@@ -44,27 +44,56 @@
 #include "SEGGER_RTT.h"
 
 #include "console_task.h"
+#include "logger.h"
+#include "perf.h"
+#include "rtos_alloc.h"
 
 #define CONSOLE_UART_INST 0
 
 #define MAX_CMD_HIST_LEN (8)
 #define MAX_INPUT_LEN    (128)
 
-#define STREAM_BUFFER_SIZE 64
+#define STREAM_BUFFER_SIZE 512
+#define UART_BUFFER_SIZE   64
+#define RX_BATCH_SIZE      64
+
+#define BINARY_TIMEOUT_MS (500)
+
+#define CONSOLE_TASK_STACK_SIZE (512)
 
 static console_output_e console_output;
 
 static volatile StreamBufferHandle_t stream_buffer;
 
-static uint8_t uart_buffer[32];
+RTOS_TASK_STORAGE(console_task, CONSOLE_TASK_STACK_SIZE)
+RTOS_STREAM_BUFFER_STORAGE(console_rx, STREAM_BUFFER_SIZE)
+
+static uint8_t uart_buffer[UART_BUFFER_SIZE];
 static am_hal_uart_transfer_t uart_transfer = {
     .ui32Direction = AM_HAL_UART_READ,
     .pui8Data = uart_buffer,
-    .ui32NumBytes = 32,
+    .ui32NumBytes = UART_BUFFER_SIZE,
     .ui32TimeoutMs = 0,
     .pui32BytesTransferred = 0,
 };
 
+static uint8_t rx_batch[RX_BATCH_SIZE];
+static size_t rx_batch_length;
+static size_t rx_batch_index;
+
+static volatile uint32_t rx_bytes;
+static volatile uint32_t rx_dropped;
+static volatile uint32_t rx_overruns;
+static uint32_t rx_batches;
+
+// stamped by the ISR for the first byte not yet read by the task, this is how
+// long the console waits behind whatever else is running
+static volatile uint32_t rx_stamp;
+static volatile bool rx_stamped;
+static uint32_t rx_latency_max;
+static uint64_t rx_latency_total;
+static uint32_t rx_latency_count;
+
 static char cmd_buffer[MAX_INPUT_LEN];
 static uint8_t cmd_size = 0;
 
@@ -82,6 +111,9 @@ static uint32_t cmd_process_mode = 0;
 static uint8_t cmd_custom_trigger_start = 0;
 static uint8_t cmd_custom_trigger_end = 0;
 static console_custom_process cmd_custom_hook;
+static uint8_t cmd_binary_sync = 0;
+static bool cmd_binary_active = false;
+static console_binary_process cmd_binary_hook;
 
 static const char crlf[] = "\r\n";
 
@@ -162,6 +194,35 @@ static void console_clear_line(uint8_t pos)
     }
 }
 
+//
+// Pull everything the ISR has queued so far into the local batch so that the
+// bytes can be parsed without going back to the kernel for each one.
+//
+static bool console_fill(TickType_t timeout)
+{
+    rx_batch_index = 0;
+    rx_batch_length = xStreamBufferReceive(stream_buffer, rx_batch, sizeof(rx_batch), timeout);
+    if (rx_batch_length > 0)
+    {
+        rx_batches++;
+    }
+
+    if (rx_stamped)
+    {
+        uint32_t latency = perf_elapsed_us(rx_stamp);
+
+        rx_stamped = false;
+        rx_latency_total += latency;
+        rx_latency_count++;
+        if (latency > rx_latency_max)
+        {
+            rx_latency_max = latency;
+        }
+    }
+
+    return rx_batch_length > 0;
+}
+
 static char console_read()
 {
     uint8_t ch;
@@ -172,12 +233,32 @@ static char console_read()
     }
     else if (console_output == CONSOLE_OUTPUT_UART)
     {
-        xStreamBufferReceive(stream_buffer, &ch, 1, portMAX_DELAY);
+        while (rx_batch_index == rx_batch_length)
+        {
+            console_fill(portMAX_DELAY);
+        }
+        ch = rx_batch[rx_batch_index++];
     }
 
     return ch;
 }
 
+static bool console_read_timeout(uint8_t *ch, TickType_t timeout)
+{
+    if (console_output == CONSOLE_OUTPUT_UART)
+    {
+        if ((rx_batch_index == rx_batch_length) && !console_fill(timeout))
+        {
+            return false;
+        }
+        *ch = rx_batch[rx_batch_index++];
+        return true;
+    }
+
+    *ch = console_read();
+    return true;
+}
+
 static void console_rtt_print(char *str)
 {
     SEGGER_RTT_WriteString(0, str);
@@ -198,7 +279,7 @@ static void console_task_setup(void)
 
         memset(cmd_hist, 0, MAX_CMD_HIST_LEN * MAX_INPUT_LEN);
 
-        stream_buffer = xStreamBufferCreate(STREAM_BUFFER_SIZE, 1);
+        stream_buffer = RTOS_STREAM_BUFFER_CREATE(console_rx, STREAM_BUFFER_SIZE, 1);
     }
 
     cmd_hist_len = 0;
@@ -210,6 +291,17 @@ static void console_task_setup(void)
     cmd_custom_trigger_start = 0;
     cmd_custom_trigger_end = 0;
     cmd_custom_hook = 0;
+    cmd_binary_sync = 0;
+    cmd_binary_active = false;
+    cmd_binary_hook = 0;
+
+    rx_batch_length = 0;
+    rx_batch_index = 0;
+    rx_bytes = 0;
+    rx_dropped = 0;
+    rx_overruns = 0;
+    rx_batches = 0;
+    console_reset_latency();
 }
 
 static void console_process_text(char *out_str, uint8_t ch)
@@ -311,9 +403,31 @@ static void console_task(void *parameter)
     char *out_str;
     out_str = FreeRTOS_CLIGetOutputBuffer();
 
+    logger_register_task();
+
     while (1)
     {
-        uint8_t ch = console_read();
+        uint8_t ch;
+
+        if (cmd_binary_active)
+        {
+            // a binary frame is in progress, abandon it if the host goes quiet
+            if (!console_read_timeout(&ch, pdMS_TO_TICKS(BINARY_TIMEOUT_MS)))
+            {
+                cmd_binary_active = cmd_binary_hook(CONSOLE_BINARY_TIMEOUT);
+                continue;
+            }
+            cmd_binary_active = cmd_binary_hook(ch);
+            continue;
+        }
+
+        ch = console_read();
+        if ((cmd_size == 0) && (cmd_process_mode == 0) && cmd_binary_hook && (ch == cmd_binary_sync))
+        {
+            cmd_binary_active = cmd_binary_hook(ch);
+            continue;
+        }
+
         if ((cmd_size == 0) && (cmd_custom_trigger_start > 0))
         {
             if (ch == cmd_custom_trigger_start)
@@ -348,7 +462,13 @@ void console_task_create(uint32_t priority, console_output_e output)
     am_util_stdio_printf(crlf);
     console_print_prompt();
 
-    xTaskCreate(console_task, "console", 512, 0, priority, &console_task_handle);
+    RTOS_TASK_CREATE(console_task,
+                     console_task,
+                     "console",
+                     CONSOLE_TASK_STACK_SIZE,
+                     0,
+                     priority,
+                     &console_task_handle);
 }
 
 void console_print_prompt()
@@ -376,20 +496,76 @@ void console_register_custom_process(console_custom_process hook)
     cmd_custom_hook = hook;
 }
 
+void console_register_binary_process(uint8_t sync, console_binary_process hook)
+{
+    cmd_binary_sync = sync;
+    cmd_binary_hook = hook;
+}
+
+void console_write(const uint8_t *buffer, size_t length)
+{
+    if (console_output == CONSOLE_OUTPUT_RTT)
+    {
+        SEGGER_RTT_Write(0, buffer, length);
+    }
+    else if (console_output == CONSOLE_OUTPUT_UART)
+    {
+        am_bsp_uart_send((uint8_t *)buffer, length);
+    }
+}
+
+void console_get_stats(console_stats_t *stats)
+{
+    stats->rx_bytes = rx_bytes;
+    stats->rx_batches = rx_batches;
+    stats->rx_dropped = rx_dropped;
+    stats->rx_overruns = rx_overruns;
+    stats->rx_latency_max_us = rx_latency_max;
+    stats->rx_latency_mean_us =
+        rx_latency_count ? (uint32_t)(rx_latency_total / rx_latency_count) : 0;
+}
+
+void console_reset_latency(void)
+{
+    rx_latency_max = 0;
+    rx_latency_total = 0;
+    rx_latency_count = 0;
+}
+
 void am_uart_isr()
 {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    uint32_t received = 0;
+    uint32_t received;
+    uint32_t status;
 
     uart_transfer.pui32BytesTransferred = &received;
 
-    am_bsp_buffered_uart_service();
-    am_bsp_com_uart_transfer(&uart_transfer);
-    if (received > 0)
+    status = am_bsp_buffered_uart_service();
+    if (status & AM_HAL_UART_INT_OVER_RUN)
     {
-        xStreamBufferSendFromISR(
-            stream_buffer, (void *)uart_buffer, received, &xHigherPriorityTaskWoken);
+        rx_overruns++;
     }
 
+    // drain the HAL receive queue completely so a burst costs one wake-up
+    do
+    {
+        received = 0;
+        am_bsp_com_uart_transfer(&uart_transfer);
+        if (received > 0)
+        {
+            size_t sent = xStreamBufferSendFromISR(
+                stream_buffer, (void *)uart_buffer, received, &xHigherPriorityTaskWoken);
+
+            if (!rx_stamped)
+            {
+                rx_stamp = perf_timestamp();
+                rx_stamped = true;
+            }
+
+            rx_bytes += received;
+            rx_dropped += received - sent;
+        }
+    } while (received == UART_BUFFER_SIZE);
+
     portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
 }
@@ -32,6 +32,10 @@
 #ifndef _CONSOLE_TASK_H_
 #define _CONSOLE_TASK_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -42,12 +46,29 @@ typedef enum
     CONSOLE_OUTPUT_RTT,
 } console_output_e;
 
+#define CONSOLE_BINARY_TIMEOUT (-1)
+
+typedef struct
+{
+    uint32_t rx_bytes;    // bytes taken out of the UART
+    uint32_t rx_batches;  // stream buffer reads made by the console task
+    uint32_t rx_dropped;  // bytes lost because the stream buffer was full
+    uint32_t rx_overruns; // hardware receive FIFO overruns
+    uint32_t rx_latency_max_us;  // longest wait from byte arrival to the task reading it
+    uint32_t rx_latency_mean_us;
+} console_stats_t;
+
 typedef void (*console_custom_process)(uint8_t ch);
+typedef bool (*console_binary_process)(int32_t ch);
 
 extern void console_task_create(uint32_t priority, console_output_e output);
 extern void console_print_prompt();
 extern void console_register_custom_process_trigger(uint8_t start, uint8_t end);
 extern void console_register_custom_process(console_custom_process hook);
+extern void console_register_binary_process(uint8_t sync, console_binary_process hook);
+extern void console_write(const uint8_t *buffer, size_t length);
+extern void console_get_stats(console_stats_t *stats);
+extern void console_reset_latency(void);
 
 #ifdef __cplusplus
 }
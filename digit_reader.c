@@ -0,0 +1,166 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "digit_reader.h"
+
+static uint32_t digit_reader_threshold = DIGIT_READER_THRESHOLD;
+static uint32_t digit_reader_overlap = DIGIT_READER_OVERLAP;
+
+void digit_reader_set_threshold(uint32_t percent)
+{
+    digit_reader_threshold = (percent > 100) ? 100 : percent;
+}
+
+uint32_t digit_reader_get_threshold(void)
+{
+    return digit_reader_threshold;
+}
+
+void digit_reader_set_overlap(uint32_t percent)
+{
+    digit_reader_overlap = (percent > 100) ? 100 : percent;
+}
+
+uint32_t digit_reader_get_overlap(void)
+{
+    return digit_reader_overlap;
+}
+
+// Every window is the same size, so the overlap only depends on the offsets.
+static bool digit_reader_overlaps(const digit_reader_digit_t *a, const digit_reader_digit_t *b, uint32_t window)
+{
+    uint32_t dx = (uint32_t)abs((int32_t)a->x - (int32_t)b->x);
+    uint32_t dy = (uint32_t)abs((int32_t)a->y - (int32_t)b->y);
+
+    if ((dx >= window) || (dy >= window))
+    {
+        return false;
+    }
+
+    uint32_t intersection = (window - dx) * (window - dy);
+    uint32_t union_area = 2 * window * window - intersection;
+    return (intersection * 100) > (digit_reader_overlap * union_area);
+}
+
+void digit_reader_decode(const digit_reader_grid_t *grid, digit_reader_result_t *result)
+{
+    digit_reader_digit_t candidates[DIGIT_READER_MAX_CANDIDATES];
+    uint32_t count = 0;
+
+    memset(result, 0, sizeof(*result));
+    result->windows = grid->rows * grid->columns;
+
+    // candidates, most confident first; a tie keeps the earlier window first
+    for (uint32_t row = 0; row < grid->rows; row++)
+    {
+        for (uint32_t column = 0; column < grid->columns; column++)
+        {
+            const int8_t *scores = &grid->scores[(row * grid->columns + column) * grid->categories];
+            uint32_t best = 0;
+            for (uint32_t i = 1; i < grid->categories; i++)
+            {
+                best = (scores[i] > scores[best]) ? i : best;
+            }
+
+            // the softmax scores are probabilities in steps of 1/256 from -128
+            uint32_t confidence = ((scores[best] + 128) * 100) / 256;
+            if (confidence < digit_reader_threshold)
+            {
+                continue;
+            }
+            result->candidates++;
+
+            if (count == DIGIT_READER_MAX_CANDIDATES)
+            {
+                if (confidence <= candidates[count - 1].confidence)
+                {
+                    continue;
+                }
+                count--;
+            }
+
+            uint32_t position = count++;
+            while ((position > 0) && (candidates[position - 1].confidence < confidence))
+            {
+                candidates[position] = candidates[position - 1];
+                position--;
+            }
+            candidates[position].label = grid->labels[best];
+            candidates[position].confidence = (uint8_t)confidence;
+            candidates[position].x = (uint16_t)(column * grid->stride);
+            candidates[position].y = (uint16_t)(row * grid->stride);
+        }
+    }
+
+    // non-maximum suppression
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        bool suppressed = false;
+        for (uint32_t j = 0; (j < kept) && !suppressed; j++)
+        {
+            suppressed = digit_reader_overlaps(&candidates[i], &candidates[j], grid->window);
+        }
+
+        if (!suppressed)
+        {
+            candidates[kept++] = candidates[i];
+        }
+    }
+
+    // the digits on the line of the most confident one, left to right
+    for (uint32_t i = 0; (i < kept) && (result->count < DIGIT_READER_MAX_DIGITS); i++)
+    {
+        uint32_t dy = (uint32_t)abs((int32_t)candidates[i].y - (int32_t)candidates[0].y);
+        if ((dy * 2) > grid->window)
+        {
+            continue;
+        }
+
+        uint32_t position = result->count++;
+        while ((position > 0) && (result->digits[position - 1].x > candidates[i].x))
+        {
+            result->digits[position] = result->digits[position - 1];
+            position--;
+        }
+        result->digits[position] = candidates[i];
+    }
+
+    for (uint32_t i = 0; i < result->count; i++)
+    {
+        result->text[i] = result->digits[i].label;
+    }
+    result->text[result->count] = '\0';
+}
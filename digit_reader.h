@@ -0,0 +1,97 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _DIGIT_READER_H_
+#define _DIGIT_READER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Turns the window scores of a frame model (TFLM_FRAME) into a string of
+// digits.  Windows whose best score reaches the threshold are candidates;
+// non-maximum suppression keeps the most confident of any that overlap, and
+// the ones on the line of the most confident window are read left to right.
+//
+#ifndef DIGIT_READER_MAX_DIGITS
+#define DIGIT_READER_MAX_DIGITS (8)
+#endif
+
+// candidates kept before suppression, the least confident are dropped
+#ifndef DIGIT_READER_MAX_CANDIDATES
+#define DIGIT_READER_MAX_CANDIDATES (64)
+#endif
+
+#define DIGIT_READER_THRESHOLD (60) // percent
+#define DIGIT_READER_OVERLAP   (30) // percent intersection over union
+
+typedef struct digit_reader_grid_s
+{
+    const int8_t *scores; // softmax scores, categories per window, row by row
+    uint32_t rows;
+    uint32_t columns;
+    uint32_t stride;      // pixels from one window to the next
+    uint32_t window;      // window width and height in pixels
+    uint32_t categories;
+    const char *labels;
+} digit_reader_grid_t;
+
+typedef struct digit_reader_digit_s
+{
+    char label;
+    uint8_t confidence; // percent
+    uint16_t x;         // top left corner of the window in the frame
+    uint16_t y;
+} digit_reader_digit_t;
+
+typedef struct digit_reader_result_s
+{
+    uint32_t count;
+    char text[DIGIT_READER_MAX_DIGITS + 1];
+    digit_reader_digit_t digits[DIGIT_READER_MAX_DIGITS];
+    uint32_t windows;    // windows scored, 0 when the inference failed
+    uint32_t candidates; // windows at or above the threshold
+} digit_reader_result_t;
+
+extern void digit_reader_set_threshold(uint32_t percent);
+extern uint32_t digit_reader_get_threshold(void);
+extern void digit_reader_set_overlap(uint32_t percent);
+extern uint32_t digit_reader_get_overlap(void);
+extern void digit_reader_decode(const digit_reader_grid_t *grid, digit_reader_result_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -36,13 +36,45 @@
 
 #include <am_bsp.h>
 
-void *camera_iom_handle;
+#include "ArducamAmbiqHAL.h"
+
+void *camera_iom_handle = NULL;
 
 void camera_delay_ms(uint32_t delay)
 {
     am_util_delay_ms(delay);
 }
 
+//
+// Sensor settings registers that are written back after the sensor leaves
+// low power mode.  Commands such as reset, capture or power control are not
+// cached.
+//
+#define CAMERA_REG_CACHE_SIZE      (0x40)
+#define CAMERA_REG_SENSOR_RESET    (0x07)
+#define CAMERA_REG_SENSOR_STATE    (0x44)
+#define CAMERA_REG_SENSOR_IDLE     (0x02)
+
+static uint8_t camera_reg_cache[CAMERA_REG_CACHE_SIZE];
+static uint64_t camera_reg_cached;
+
+static bool camera_reg_cacheable(uint8_t address)
+{
+    // format, resolution and image controls, skipping auto focus
+    if ((address >= 0x20) && (address <= 0x2A) && (address != 0x29))
+    {
+        return true;
+    }
+
+    // exposure, gain and white balance
+    if ((address >= 0x30) && (address <= 0x35))
+    {
+        return true;
+    }
+
+    return false;
+}
+
 void camera_wake()
 {
     am_hal_iom_config_t config;
@@ -64,19 +96,56 @@ void camera_wake()
 #endif
 
     am_bsp_iom_pins_enable(0, AM_HAL_IOM_SPI_MODE);
-    am_hal_iom_initialize(0, &camera_iom_handle);
-    am_hal_iom_power_ctrl(camera_iom_handle, AM_HAL_SYSCTRL_WAKE, false);
-    am_hal_iom_configure(camera_iom_handle, &config);
+    if (camera_iom_handle == NULL)
+    {
+        am_hal_iom_initialize(0, &camera_iom_handle);
+        am_hal_iom_power_ctrl(camera_iom_handle, AM_HAL_SYSCTRL_WAKE, false);
+        am_hal_iom_configure(camera_iom_handle, &config);
+    }
+    else
+    {
+        // the configuration was saved by camera_sleep()
+        am_hal_iom_power_ctrl(camera_iom_handle, AM_HAL_SYSCTRL_WAKE, true);
+    }
     am_hal_iom_enable(camera_iom_handle);
 }
 
 void camera_sleep()
 {
     am_hal_iom_disable(camera_iom_handle);
-    am_hal_iom_power_ctrl(camera_iom_handle, AM_HAL_SYSCTRL_DEEPSLEEP, false);
+    am_hal_iom_power_ctrl(camera_iom_handle, AM_HAL_SYSCTRL_DEEPSLEEP, true);
     am_bsp_iom_pins_disable(0, AM_HAL_IOM_SPI_MODE);
 }
 
+uint32_t camera_reg_restore()
+{
+    for (uint8_t address = 0; address < CAMERA_REG_CACHE_SIZE; address++)
+    {
+        if ((camera_reg_cached & (1ULL << address)) == 0)
+        {
+            continue;
+        }
+
+        uint32_t status = camera_reg_write(address, &camera_reg_cache[address], 1, false);
+        if (status != AM_HAL_STATUS_SUCCESS)
+        {
+            return status;
+        }
+        camera_delay_ms(1);
+
+        // the sensor is programmed over I2C by the camera module
+        uint8_t state[2];
+        camera_reg_read(CAMERA_REG_SENSOR_STATE, state, 2, false);
+        while ((state[1] & 0x03) != CAMERA_REG_SENSOR_IDLE)
+        {
+            camera_delay_ms(2);
+            camera_reg_read(CAMERA_REG_SENSOR_STATE, state, 2, false);
+        }
+    }
+
+    return AM_HAL_STATUS_SUCCESS;
+}
+
 uint32_t camera_reg_read(uint8_t address, uint8_t *value, size_t length, bool persist)
 {
     am_hal_iom_transfer_t transfer;
@@ -105,6 +174,18 @@ uint32_t camera_reg_write(uint8_t address, uint8_t *value, size_t length, bool p
 
     uint32_t instr = address | 0x80;
 
+    address &= 0x7F;
+    if (address == CAMERA_REG_SENSOR_RESET)
+    {
+        // the sensor is back to its defaults
+        camera_reg_cached = 0;
+    }
+    else if ((length == 1) && camera_reg_cacheable(address))
+    {
+        camera_reg_cache[address] = *value;
+        camera_reg_cached |= 1ULL << address;
+    }
+
     transfer.ui32InstrLen = 1;
     transfer.ui32Instr = instr;
     transfer.eDirection = AM_HAL_IOM_TX;
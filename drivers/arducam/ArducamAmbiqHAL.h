@@ -38,6 +38,7 @@
 
 void camera_wake();
 void camera_sleep();
+uint32_t camera_reg_restore();
 void camera_delay_ms(uint32_t delay);
 
 uint32_t camera_reg_read(uint8_t address, uint8_t *value, size_t length, bool persist);
@@ -0,0 +1,304 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+
+#include "governor.h"
+#include "governor_cli.h"
+#include "rtos_alloc.h"
+
+typedef struct
+{
+    governor_level_e level;
+    governor_stage_stats_t stats;
+} governor_stage_t;
+
+static const uint32_t governor_power_uw[GOVERNOR_LEVEL_MAX] = {
+    GOVERNOR_POWER_NORMAL_UW,
+    GOVERNOR_POWER_BURST_UW,
+};
+
+static const char *governor_level_names[GOVERNOR_LEVEL_MAX] = {
+    "normal",
+    "burst",
+};
+
+static SemaphoreHandle_t governor_mutex;
+RTOS_SEMAPHORE_STORAGE(governor)
+static am_hal_burst_avail_e governor_burst_avail;
+static governor_level_e governor_current;
+static uint32_t governor_active_burst;
+static governor_mode_e governor_mode;
+static governor_stage_t governor_stages[PERF_STAGE_MAX];
+
+static void governor_apply(void)
+{
+    am_hal_burst_mode_e burst_mode;
+    governor_level_e level = governor_active_burst ? GOVERNOR_LEVEL_BURST : GOVERNOR_LEVEL_NORMAL;
+
+    if ((level == governor_current) || (governor_burst_avail != AM_HAL_BURST_AVAIL))
+    {
+        return;
+    }
+
+    if (level == GOVERNOR_LEVEL_BURST)
+    {
+        am_hal_burst_mode_enable(&burst_mode);
+    }
+    else
+    {
+        am_hal_burst_mode_disable(&burst_mode);
+    }
+    governor_current = level;
+}
+
+//
+// Energy of one run of the stage at each level, counting the time the faster
+// level spends asleep while the slower one would still be running.
+//
+static governor_level_e governor_profile_choice(const governor_stage_stats_t *stats)
+{
+    uint64_t mean_us[GOVERNOR_LEVEL_MAX];
+    uint64_t longest = 0;
+
+    for (uint32_t level = 0; level < GOVERNOR_LEVEL_MAX; level++)
+    {
+        mean_us[level] = stats->time_us[level] / stats->count[level];
+        if (mean_us[level] > longest)
+        {
+            longest = mean_us[level];
+        }
+    }
+
+    governor_level_e best = GOVERNOR_LEVEL_NORMAL;
+    uint64_t best_energy = UINT64_MAX;
+    for (uint32_t level = 0; level < GOVERNOR_LEVEL_MAX; level++)
+    {
+        uint64_t energy = mean_us[level] * governor_power_uw[level] +
+                          (longest - mean_us[level]) * GOVERNOR_POWER_SLEEP_UW;
+        if (energy < best_energy)
+        {
+            best_energy = energy;
+            best = (governor_level_e)level;
+        }
+    }
+
+    return best;
+}
+
+static governor_level_e governor_pick(governor_stage_t *stage)
+{
+    if (governor_burst_avail != AM_HAL_BURST_AVAIL)
+    {
+        return GOVERNOR_LEVEL_NORMAL;
+    }
+
+    if ((governor_mode == GOVERNOR_MODE_FIXED) || stage->stats.profiled)
+    {
+        return stage->level;
+    }
+
+    for (uint32_t level = 0; level < GOVERNOR_LEVEL_MAX; level++)
+    {
+        if (stage->stats.count[level] < GOVERNOR_PROFILE_SAMPLES)
+        {
+            return (governor_level_e)level;
+        }
+    }
+
+    stage->level = governor_profile_choice(&stage->stats);
+    stage->stats.profiled = true;
+    return stage->level;
+}
+
+void governor_setup(void)
+{
+    am_hal_burst_mode_e burst_mode;
+
+    governor_mutex = RTOS_MUTEX_CREATE(governor);
+
+    am_hal_burst_mode_initialize(&governor_burst_avail);
+    if (governor_burst_avail == AM_HAL_BURST_AVAIL)
+    {
+        am_hal_burst_mode_disable(&burst_mode);
+    }
+    governor_current = GOVERNOR_LEVEL_NORMAL;
+    governor_active_burst = 0;
+    governor_mode = GOVERNOR_MODE_FIXED;
+
+    memset(governor_stages, 0, sizeof(governor_stages));
+    governor_stages[PERF_STAGE_CAPTURE].level = GOVERNOR_LEVEL_NORMAL;
+    governor_stages[PERF_STAGE_PREPROCESS].level = GOVERNOR_LEVEL_NORMAL;
+    governor_stages[PERF_STAGE_INFERENCE].level = GOVERNOR_LEVEL_BURST;
+    governor_stages[PERF_STAGE_REPORT].level = GOVERNOR_LEVEL_NORMAL;
+
+    governor_cli_register();
+}
+
+bool governor_burst_available(void)
+{
+    return governor_burst_avail == AM_HAL_BURST_AVAIL;
+}
+
+void governor_set_mode(governor_mode_e mode)
+{
+    xSemaphoreTake(governor_mutex, portMAX_DELAY);
+    governor_mode = mode;
+    if (mode == GOVERNOR_MODE_PROFILE)
+    {
+        // profile from a clean slate
+        for (uint32_t i = 0; i < PERF_STAGE_MAX; i++)
+        {
+            memset(&governor_stages[i].stats, 0, sizeof(governor_stages[i].stats));
+        }
+    }
+    xSemaphoreGive(governor_mutex);
+}
+
+governor_mode_e governor_get_mode(void)
+{
+    return governor_mode;
+}
+
+void governor_set_level(perf_stage_e stage, governor_level_e level)
+{
+    if ((stage >= PERF_STAGE_MAX) || (level >= GOVERNOR_LEVEL_MAX))
+    {
+        return;
+    }
+
+    xSemaphoreTake(governor_mutex, portMAX_DELAY);
+    governor_stages[stage].level = level;
+    xSemaphoreGive(governor_mutex);
+}
+
+const char *governor_level_name(governor_level_e level)
+{
+    return (level < GOVERNOR_LEVEL_MAX) ? governor_level_names[level] : "unknown";
+}
+
+governor_token_t governor_enter(perf_stage_e stage)
+{
+    governor_token_t token = {.level = GOVERNOR_LEVEL_NORMAL};
+
+    if (stage < PERF_STAGE_MAX)
+    {
+        xSemaphoreTake(governor_mutex, portMAX_DELAY);
+        token.level = governor_pick(&governor_stages[stage]);
+        if (token.level == GOVERNOR_LEVEL_BURST)
+        {
+            governor_active_burst++;
+        }
+        governor_apply();
+        xSemaphoreGive(governor_mutex);
+    }
+
+    token.start = perf_timestamp();
+    return token;
+}
+
+void governor_exit(perf_stage_e stage, governor_token_t token)
+{
+    uint32_t elapsed = perf_elapsed_us(token.start);
+    governor_level_e level = token.level;
+
+    if (stage >= PERF_STAGE_MAX)
+    {
+        return;
+    }
+
+    xSemaphoreTake(governor_mutex, portMAX_DELAY);
+    governor_stage_t *entry = &governor_stages[stage];
+
+    entry->stats.count[level]++;
+    entry->stats.time_us[level] += elapsed;
+    // microseconds times microwatts is picojoules
+    entry->stats.energy_nj[level] += ((uint64_t)elapsed * governor_power_uw[level]) / 1000;
+
+    if ((level == GOVERNOR_LEVEL_BURST) && (governor_active_burst > 0))
+    {
+        governor_active_burst--;
+    }
+    governor_apply();
+    xSemaphoreGive(governor_mutex);
+}
+
+void governor_hold(governor_level_e level)
+{
+    xSemaphoreTake(governor_mutex, portMAX_DELAY);
+    if (level == GOVERNOR_LEVEL_BURST)
+    {
+        governor_active_burst++;
+    }
+    governor_apply();
+    xSemaphoreGive(governor_mutex);
+}
+
+void governor_release(governor_level_e level)
+{
+    xSemaphoreTake(governor_mutex, portMAX_DELAY);
+    if ((level == GOVERNOR_LEVEL_BURST) && (governor_active_burst > 0))
+    {
+        governor_active_burst--;
+    }
+    governor_apply();
+    xSemaphoreGive(governor_mutex);
+}
+
+void governor_get_stats(perf_stage_e stage, governor_stage_stats_t *stats)
+{
+    if (stage >= PERF_STAGE_MAX)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    xSemaphoreTake(governor_mutex, portMAX_DELAY);
+    *stats = governor_stages[stage].stats;
+    stats->level = governor_stages[stage].level;
+    xSemaphoreGive(governor_mutex);
+}
+
+void governor_reset(void)
+{
+    xSemaphoreTake(governor_mutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < PERF_STAGE_MAX; i++)
+    {
+        memset(&governor_stages[i].stats, 0, sizeof(governor_stages[i].stats));
+    }
+    xSemaphoreGive(governor_mutex);
+}
@@ -0,0 +1,122 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _GOVERNOR_H_
+#define _GOVERNOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "perf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Estimated power at each performance level, in microwatts, from the Apollo3
+// datasheet run currents at 3.3 V.  They only rank the levels against each
+// other; override them with measured values for absolute numbers.
+//
+#ifndef GOVERNOR_POWER_NORMAL_UW
+#define GOVERNOR_POWER_NORMAL_UW (950)
+#endif
+
+#ifndef GOVERNOR_POWER_BURST_UW
+#define GOVERNOR_POWER_BURST_UW (2100)
+#endif
+
+#ifndef GOVERNOR_POWER_SLEEP_UW
+#define GOVERNOR_POWER_SLEEP_UW (10)
+#endif
+
+// runs of each level a stage is given in profile mode before one is chosen
+#define GOVERNOR_PROFILE_SAMPLES (8)
+
+typedef enum governor_level_e
+{
+    GOVERNOR_LEVEL_NORMAL, // 48 MHz
+    GOVERNOR_LEVEL_BURST,  // 96 MHz
+    GOVERNOR_LEVEL_MAX
+} governor_level_e;
+
+typedef enum governor_mode_e
+{
+    GOVERNOR_MODE_FIXED,   // every stage runs at its assigned level
+    GOVERNOR_MODE_PROFILE, // try both levels, then keep the cheaper one
+} governor_mode_e;
+
+typedef struct governor_stage_stats_s
+{
+    governor_level_e level;
+    bool profiled;
+    uint32_t count[GOVERNOR_LEVEL_MAX];
+    uint64_t time_us[GOVERNOR_LEVEL_MAX];
+    uint64_t energy_nj[GOVERNOR_LEVEL_MAX];
+} governor_stage_stats_t;
+
+extern void governor_setup(void);
+extern bool governor_burst_available(void);
+
+extern void governor_set_mode(governor_mode_e mode);
+extern governor_mode_e governor_get_mode(void);
+extern void governor_set_level(perf_stage_e stage, governor_level_e level);
+extern const char *governor_level_name(governor_level_e level);
+
+// The level picked for one run of a stage.  Several tasks can be in the same
+// stage at once, so the level travels with the call rather than the stage.
+typedef struct governor_token_s
+{
+    uint32_t start; // perf_timestamp() when the stage was entered
+    governor_level_e level;
+} governor_token_t;
+
+//
+// Bracket a pipeline stage.  The clock is raised while any running stage
+// needs burst, so stages on different tasks do not fight over the setting.
+//
+extern governor_token_t governor_enter(perf_stage_e stage);
+extern void governor_exit(perf_stage_e stage, governor_token_t token);
+
+//
+// Hold a level outside of the stage accounting, e.g. for benchmarking.
+//
+extern void governor_hold(governor_level_e level);
+extern void governor_release(governor_level_e level);
+
+extern void governor_get_stats(perf_stage_e stage, governor_stage_stats_t *stats);
+extern void governor_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
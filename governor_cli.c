@@ -0,0 +1,187 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <FreeRTOS_CLI.h>
+
+#include "governor.h"
+#include "governor_cli.h"
+#include "perf.h"
+
+static portBASE_TYPE governor_cli_entry(char *pui8OutBuffer,
+                                        size_t ui32OutBufferLength,
+                                        const char *pui8Command);
+
+static CLI_Command_Definition_t governor_cli_definition = {
+    (const char *const) "gov",
+    (const char *const) "gov    :  Per Stage Performance Governor.\r\n",
+    governor_cli_entry,
+    -1};
+
+void governor_cli_register()
+{
+    FreeRTOS_CLIRegisterCommand(&governor_cli_definition);
+}
+
+static void help(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    strcat(pui8OutBuffer, "\r\nusage: gov [command]\r\n");
+    strcat(pui8OutBuffer, "\r\n");
+    strcat(pui8OutBuffer, "supported commands are:\r\n");
+    strcat(pui8OutBuffer, "  fixed                  run every stage at its assigned level\r\n");
+    strcat(pui8OutBuffer, "  profile                try both levels per stage and keep the\r\n");
+    strcat(pui8OutBuffer, "                         one with the lower energy\r\n");
+    strcat(pui8OutBuffer, "  set <stage> <level>    assign normal or burst to a stage\r\n");
+    strcat(pui8OutBuffer, "  reset                  clear the time and energy totals\r\n");
+    strcat(pui8OutBuffer, "\r\n");
+    strcat(pui8OutBuffer, "without a command the levels, time and estimated energy are shown\r\n");
+}
+
+static void show(void)
+{
+    governor_stage_stats_t stats;
+    governor_mode_e mode = governor_get_mode();
+
+    am_util_stdio_printf("\r\nmode: %s, burst %savailable\r\n",
+                         mode == GOVERNOR_MODE_PROFILE ? "profile" : "fixed",
+                         governor_burst_available() ? "" : "not ");
+    am_util_stdio_printf("stage        level    runs  normal us   burst us  energy uJ\r\n");
+
+    for (uint32_t stage = 0; stage < PERF_STAGE_MAX; stage++)
+    {
+        governor_get_stats((perf_stage_e)stage, &stats);
+
+        uint32_t runs = stats.count[GOVERNOR_LEVEL_NORMAL] + stats.count[GOVERNOR_LEVEL_BURST];
+        uint64_t energy = stats.energy_nj[GOVERNOR_LEVEL_NORMAL] + stats.energy_nj[GOVERNOR_LEVEL_BURST];
+        uint32_t mean[GOVERNOR_LEVEL_MAX];
+        for (uint32_t level = 0; level < GOVERNOR_LEVEL_MAX; level++)
+        {
+            mean[level] = stats.count[level] ? (uint32_t)(stats.time_us[level] / stats.count[level]) : 0;
+        }
+
+        am_util_stdio_printf("%-11s  %-6s%c  %5d  %9d  %9d  %9d\r\n",
+                             perf_stage_name((perf_stage_e)stage),
+                             governor_level_name(stats.level),
+                             (mode == GOVERNOR_MODE_PROFILE && !stats.profiled) ? '?' : ' ',
+                             runs,
+                             mean[GOVERNOR_LEVEL_NORMAL],
+                             mean[GOVERNOR_LEVEL_BURST],
+                             (uint32_t)(energy / 1000));
+    }
+    am_util_stdio_printf("times are means per run, energy is estimated from GOVERNOR_POWER_*_UW\r\n");
+}
+
+static void set(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    uint32_t stage;
+    governor_level_e level;
+
+    if (argc < 4)
+    {
+        strcat(pui8OutBuffer, "\r\nusage: gov set <stage> <normal|burst>\r\n");
+        return;
+    }
+
+    for (stage = 0; stage < PERF_STAGE_MAX; stage++)
+    {
+        if (strcmp(argv[2], perf_stage_name((perf_stage_e)stage)) == 0)
+        {
+            break;
+        }
+    }
+    if (stage == PERF_STAGE_MAX)
+    {
+        strcat(pui8OutBuffer, "\r\nunknown stage\r\n");
+        return;
+    }
+
+    if (strcmp(argv[3], "normal") == 0)
+    {
+        level = GOVERNOR_LEVEL_NORMAL;
+    }
+    else if (strcmp(argv[3], "burst") == 0)
+    {
+        level = GOVERNOR_LEVEL_BURST;
+    }
+    else
+    {
+        strcat(pui8OutBuffer, "\r\nunknown level\r\n");
+        return;
+    }
+
+    governor_set_level((perf_stage_e)stage, level);
+}
+
+portBASE_TYPE
+governor_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const char *pui8Command)
+{
+    size_t argc;
+    char *argv[8];
+    char argz[128];
+
+    pui8OutBuffer[0] = 0;
+
+    strcpy(argz, pui8Command);
+    FreeRTOS_CLIExtractParameters(argz, &argc, argv);
+
+    if (argc < 2)
+    {
+        show();
+    }
+    else if (strcmp(argv[1], "help") == 0)
+    {
+        help(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "fixed") == 0)
+    {
+        governor_set_mode(GOVERNOR_MODE_FIXED);
+    }
+    else if (strcmp(argv[1], "profile") == 0)
+    {
+        governor_set_mode(GOVERNOR_MODE_PROFILE);
+    }
+    else if (strcmp(argv[1], "set") == 0)
+    {
+        set(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "reset") == 0)
+    {
+        governor_reset();
+    }
+
+    return pdFALSE;
+}
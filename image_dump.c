@@ -0,0 +1,239 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include <am_util.h>
+
+#include "console_task.h"
+#include "image_dump.h"
+#include "rpc_protocol.h"
+
+//
+// Images are streamed straight from the caller's buffer through a small line
+// buffer instead of formatting every pixel with printf.  The dump is framed
+// by the same \x01\x01 / \x02\x02 markers used for the inference results:
+//
+//   \x01\x01image width=W height=H channels=C encoding=E rle=R size=N crc=X\r\n
+//   <payload>
+//   \x02\x02\r\n
+//
+// With base64 encoding the payload is CRLF terminated lines of at most 76
+// characters.  With binary encoding it is a sequence of chunks made of a
+// length byte followed by that many bytes, ended by a zero length chunk.
+//
+// When rle is enabled the image goes through PackBits on whole pixels: a
+// control byte n < 128 is followed by n + 1 literal pixels and n > 128 by a
+// single pixel repeated 257 - n times.  The crc is a CRC-16/CCITT-FALSE of
+// the decoded image.
+//
+#define IMAGE_DUMP_LINE_BYTES (57)
+#define IMAGE_DUMP_CHUNK_SIZE (255)
+#define IMAGE_DUMP_RUN_MAX    (128)
+#define IMAGE_DUMP_PIXEL_MAX  (4)
+
+typedef struct image_dump_stream_s
+{
+    image_dump_encoding_e encoding;
+    uint8_t pending[IMAGE_DUMP_CHUNK_SIZE];
+    size_t pending_length;
+    char line[80];
+} image_dump_stream_t;
+
+static const char image_dump_base64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static const char image_dump_start[] = "\x01\x01";
+static const char image_dump_end[] = "\x02\x02\r\n";
+static const char image_dump_crlf[] = "\r\n";
+
+static image_dump_stream_t image_dump_stream;
+
+static void image_dump_flush(image_dump_stream_t *stream)
+{
+    if (stream->pending_length == 0)
+    {
+        return;
+    }
+
+    if (stream->encoding == IMAGE_DUMP_BINARY)
+    {
+        uint8_t length = stream->pending_length;
+        console_write(&length, 1);
+        console_write(stream->pending, stream->pending_length);
+    }
+    else
+    {
+        size_t out = 0;
+        for (size_t i = 0; i < stream->pending_length; i += 3)
+        {
+            uint32_t remaining = stream->pending_length - i;
+            uint32_t triple = stream->pending[i] << 16;
+            if (remaining > 1)
+            {
+                triple |= stream->pending[i + 1] << 8;
+            }
+            if (remaining > 2)
+            {
+                triple |= stream->pending[i + 2];
+            }
+
+            stream->line[out++] = image_dump_base64[(triple >> 18) & 0x3F];
+            stream->line[out++] = image_dump_base64[(triple >> 12) & 0x3F];
+            stream->line[out++] = (remaining > 1) ? image_dump_base64[(triple >> 6) & 0x3F] : '=';
+            stream->line[out++] = (remaining > 2) ? image_dump_base64[triple & 0x3F] : '=';
+        }
+        stream->line[out++] = '\r';
+        stream->line[out++] = '\n';
+        console_write((const uint8_t *)stream->line, out);
+    }
+
+    stream->pending_length = 0;
+}
+
+static void image_dump_put(image_dump_stream_t *stream, const uint8_t *data, size_t length)
+{
+    size_t capacity =
+        (stream->encoding == IMAGE_DUMP_BINARY) ? IMAGE_DUMP_CHUNK_SIZE : IMAGE_DUMP_LINE_BYTES;
+
+    while (length > 0)
+    {
+        size_t count = capacity - stream->pending_length;
+        if (count > length)
+        {
+            count = length;
+        }
+
+        memcpy(&stream->pending[stream->pending_length], data, count);
+        stream->pending_length += count;
+        data += count;
+        length -= count;
+
+        if (stream->pending_length == capacity)
+        {
+            image_dump_flush(stream);
+        }
+    }
+}
+
+static void image_dump_rle(image_dump_stream_t *stream,
+                           const uint8_t *image,
+                           size_t pixels,
+                           uint8_t channels)
+{
+    size_t i = 0;
+
+    while (i < pixels)
+    {
+        const uint8_t *pixel = &image[i * channels];
+        size_t run = 1;
+
+        while (((i + run) < pixels) && (run < IMAGE_DUMP_RUN_MAX) &&
+               (memcmp(pixel, &image[(i + run) * channels], channels) == 0))
+        {
+            run++;
+        }
+
+        if (run > 1)
+        {
+            uint8_t control = 257 - run;
+            image_dump_put(stream, &control, 1);
+            image_dump_put(stream, pixel, channels);
+            i += run;
+            continue;
+        }
+
+        size_t literal = 1;
+        while (((i + literal) < pixels) && (literal < IMAGE_DUMP_RUN_MAX))
+        {
+            const uint8_t *next = &image[(i + literal) * channels];
+            if (((i + literal + 1) < pixels) && (memcmp(next, next + channels, channels) == 0))
+            {
+                break;
+            }
+            literal++;
+        }
+
+        uint8_t control = literal - 1;
+        image_dump_put(stream, &control, 1);
+        image_dump_put(stream, pixel, literal * channels);
+        i += literal;
+    }
+}
+
+void image_dump(const uint8_t *image,
+                uint16_t width,
+                uint16_t height,
+                uint8_t channels,
+                image_dump_encoding_e encoding,
+                bool rle)
+{
+    image_dump_stream_t *stream = &image_dump_stream;
+    size_t pixels = width * height;
+    size_t size = pixels * channels;
+
+    if ((channels == 0) || (channels > IMAGE_DUMP_PIXEL_MAX))
+    {
+        return;
+    }
+
+    stream->encoding = encoding;
+    stream->pending_length = 0;
+
+    am_util_stdio_printf("%simage width=%d height=%d channels=%d encoding=%s rle=%d size=%d crc=0x%04x%s",
+                         image_dump_start,
+                         width,
+                         height,
+                         channels,
+                         (encoding == IMAGE_DUMP_BINARY) ? "binary" : "base64",
+                         rle ? 1 : 0,
+                         size,
+                         rpc_crc16(RPC_CRC_INIT, image, size),
+                         image_dump_crlf);
+
+    if (rle)
+    {
+        image_dump_rle(stream, image, pixels, channels);
+    }
+    else
+    {
+        image_dump_put(stream, image, size);
+    }
+    image_dump_flush(stream);
+
+    if (encoding == IMAGE_DUMP_BINARY)
+    {
+        uint8_t terminator = 0;
+        console_write(&terminator, 1);
+    }
+
+    am_util_stdio_printf(image_dump_end);
+}
@@ -0,0 +1,113 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include "image_preprocess.h"
+
+void image_preprocess_init(image_preprocess_t *context, uint8_t *output)
+{
+    context->output = output;
+    context->index = 0;
+    context->row = 0;
+    context->r_max = 0;
+    context->g_max = 0;
+    context->b_max = 0;
+    memset(output, 0, IMAGE_SIZE);
+}
+
+void image_preprocess_row(image_preprocess_t *context, const uint8_t *row, size_t length)
+{
+    uint32_t row_index = context->row++;
+
+    if ((row_index % IMAGE_DECIMATION) != 0)
+    {
+        return;
+    }
+
+    for (size_t i = 0; (i + 1) < length; i += IMAGE_SOURCE_BPP * IMAGE_DECIMATION)
+    {
+        if ((context->index + IMAGE_CHANNEL) > IMAGE_SIZE)
+        {
+            return;
+        }
+
+        uint8_t r_raw = (row[i] & 0b11111000) >> 3;
+        uint8_t b_raw = (row[i + 1] & 0b00011111);
+        uint8_t g_upper = (row[i] & 0b00000111) << 3;
+        uint8_t g_lower = (row[i + 1] & 0b11100000) >> 5;
+        uint8_t g_raw = g_upper | g_lower;
+
+        context->output[context->index++] = r_raw;
+        context->output[context->index++] = g_raw;
+        context->output[context->index++] = b_raw;
+
+        if (r_raw > context->r_max)
+        {
+            context->r_max = r_raw;
+        }
+
+        if (g_raw > context->g_max)
+        {
+            context->g_max = g_raw;
+        }
+
+        if (b_raw > context->b_max)
+        {
+            context->b_max = b_raw;
+        }
+    }
+}
+
+void image_preprocess_normalize(image_preprocess_t *context)
+{
+    uint8_t *image = context->output;
+
+    // scale each channel to [0, 127] so that the buffer can be handed to the
+    // model as an int8 tensor without further conversion.
+    for (int i = 0; i < IMAGE_SIZE; i += IMAGE_CHANNEL)
+    {
+        if (context->r_max)
+        {
+            image[i] = image[i] * 127 / context->r_max;
+        }
+
+        if (context->g_max)
+        {
+            image[i + 1] = image[i + 1] * 127 / context->g_max;
+        }
+
+        if (context->b_max)
+        {
+            image[i + 2] = image[i + 2] * 127 / context->b_max;
+        }
+    }
+}
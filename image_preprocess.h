@@ -0,0 +1,84 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _IMAGE_PREPROCESS_H_
+#define _IMAGE_PREPROCESS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// The camera delivers a 96x96 RGB565 frame (big endian, two bytes per pixel)
+// which is decimated by three in both directions to produce the 32x32 RGB
+// tensor consumed by the model.  A frame model (TFLM_FRAME) reads digits
+// anywhere in the frame and takes it at full resolution instead.
+//
+#define IMAGE_SOURCE_WIDTH    (96)
+#define IMAGE_SOURCE_HEIGHT   (96)
+#define IMAGE_SOURCE_BPP      (2)
+#define IMAGE_SOURCE_ROW_SIZE (IMAGE_SOURCE_WIDTH * IMAGE_SOURCE_BPP)
+#define IMAGE_SOURCE_SIZE     (IMAGE_SOURCE_ROW_SIZE * IMAGE_SOURCE_HEIGHT)
+
+#if defined(TFLM_FRAME)
+#define IMAGE_DECIMATION (1)
+#define IMAGE_WIDTH      (96)
+#define IMAGE_HEIGHT     (96)
+#else
+#define IMAGE_DECIMATION (3)
+#define IMAGE_WIDTH      (32)
+#define IMAGE_HEIGHT     (32)
+#endif
+#define IMAGE_CHANNEL    (3)
+#define IMAGE_SIZE       (IMAGE_WIDTH * IMAGE_HEIGHT * IMAGE_CHANNEL)
+
+typedef struct image_preprocess_s
+{
+    uint8_t *output;
+    uint32_t index;
+    uint32_t row;
+    uint8_t r_max;
+    uint8_t g_max;
+    uint8_t b_max;
+} image_preprocess_t;
+
+extern void image_preprocess_init(image_preprocess_t *context, uint8_t *output);
+extern void image_preprocess_row(image_preprocess_t *context, const uint8_t *row, size_t length);
+extern void image_preprocess_normalize(image_preprocess_t *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,319 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "tflm.h"
+
+#include "governor.h"
+#include "inference_task.h"
+#include "inference_task_cli.h"
+#include "logger.h"
+#include "perf.h"
+#include "rtos_alloc.h"
+
+typedef struct inference_entry_s
+{
+    inference_request_t request;
+    uint32_t sequence;
+    uint32_t submitted;         // perf timestamp, for the wait statistics
+    TickType_t submitted_ticks; // for the deadline
+} inference_entry_t;
+
+#define INFERENCE_TASK_STACK_SIZE (512)
+
+RTOS_TASK_STORAGE(inference_task, INFERENCE_TASK_STACK_SIZE)
+
+static TaskHandle_t inference_task_handle;
+
+// Requests are kept in arrival order only through their sequence number; the
+// queue is short, so picking the next one or a victim is a linear scan.
+static inference_entry_t inference_queue[INFERENCE_QUEUE_LENGTH];
+static uint32_t inference_queued;
+static uint32_t inference_sequence;
+static volatile uint32_t inference_policy = INFERENCE_POLICY;
+
+static inference_stats_t inference_stats;
+static uint64_t inference_wait_total;
+
+static bool inference_older(const inference_entry_t *a, const inference_entry_t *b)
+{
+    return (int32_t)(a->sequence - b->sequence) < 0;
+}
+
+// highest priority first, oldest first within a priority
+static uint32_t inference_next(void)
+{
+    uint32_t next = 0;
+
+    for (uint32_t i = 1; i < inference_queued; i++)
+    {
+        const inference_entry_t *entry = &inference_queue[i];
+        const inference_entry_t *best = &inference_queue[next];
+        if ((entry->request.priority > best->request.priority) ||
+            ((entry->request.priority == best->request.priority) && inference_older(entry, best)))
+        {
+            next = i;
+        }
+    }
+
+    return next;
+}
+
+// lowest priority first, oldest first within a priority
+static uint32_t inference_victim(void)
+{
+    uint32_t victim = 0;
+
+    for (uint32_t i = 1; i < inference_queued; i++)
+    {
+        const inference_entry_t *entry = &inference_queue[i];
+        const inference_entry_t *worst = &inference_queue[victim];
+        if ((entry->request.priority < worst->request.priority) ||
+            ((entry->request.priority == worst->request.priority) && inference_older(entry, worst)))
+        {
+            victim = i;
+        }
+    }
+
+    return victim;
+}
+
+static void inference_reply(const inference_request_t *request, uint32_t value, uint32_t wait_us)
+{
+    inference_result_t result;
+
+    memset(&result, 0, sizeof(result));
+    result.value = value;
+    result.wait_us = wait_us;
+    if (request->callback)
+    {
+        request->callback(&result, request->context);
+    }
+}
+
+static bool inference_take(inference_entry_t *entry)
+{
+    bool taken = false;
+
+    taskENTER_CRITICAL();
+    if (inference_queued > 0)
+    {
+        uint32_t next = inference_next();
+        *entry = inference_queue[next];
+        inference_queue[next] = inference_queue[--inference_queued];
+        taken = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return taken;
+}
+
+static void inference_run(const inference_entry_t *entry)
+{
+    const inference_request_t *request = &entry->request;
+    inference_result_t result;
+    tflm_info_t model;
+
+    memset(&result, 0, sizeof(result));
+    result.value = TFLM_INFERENCE_FAILED;
+    result.wait_us = perf_elapsed_us(entry->submitted);
+
+    taskENTER_CRITICAL();
+    inference_wait_total += result.wait_us;
+    if (result.wait_us > inference_stats.wait_max_us)
+    {
+        inference_stats.wait_max_us = result.wait_us;
+    }
+    taskEXIT_CRITICAL();
+
+    if ((inference_policy & INFERENCE_POLICY_SKIP_STALE) && (request->deadline_ms != 0) &&
+        ((xTaskGetTickCount() - entry->submitted_ticks) > pdMS_TO_TICKS(request->deadline_ms)))
+    {
+        taskENTER_CRITICAL();
+        inference_stats.stale++;
+        taskEXIT_CRITICAL();
+        inference_reply(request, INFERENCE_STALE, result.wait_us);
+        return;
+    }
+
+    tflm_get_info(&model);
+    if ((request->model != 0) && (request->model != model.model_version))
+    {
+        LOG_WARN("Inference request for model %d, model %d is loaded.", request->model, model.model_version);
+    }
+    else
+    {
+        governor_token_t token = governor_enter(PERF_STAGE_INFERENCE);
+        result.value =
+            tflm_inference((uint8_t *)request->tensor, request->size, result.scores, &result.count);
+        result.ticks = tflm_inference_ticks();
+        perf_record(PERF_STAGE_INFERENCE, perf_elapsed_us(token.start));
+        governor_exit(PERF_STAGE_INFERENCE, token);
+    }
+
+    taskENTER_CRITICAL();
+    inference_stats.completed++;
+    taskEXIT_CRITICAL();
+
+    if (request->callback)
+    {
+        request->callback(&result, request->context);
+    }
+}
+
+static void inference_task(void *parameter)
+{
+    inference_entry_t entry;
+
+    logger_register_task();
+    inference_task_cli_register();
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (inference_take(&entry))
+        {
+            inference_run(&entry);
+        }
+    }
+}
+
+void inference_task_create(uint32_t priority)
+{
+    RTOS_TASK_CREATE(inference_task,
+                     inference_task,
+                     "inference",
+                     INFERENCE_TASK_STACK_SIZE,
+                     0,
+                     priority,
+                     &inference_task_handle);
+}
+
+//
+// Queue an inference.  When the queue is full either the oldest request of
+// the lowest priority or, if everything queued outranks it, the new request
+// is dropped; both are reported as INFERENCE_DROPPED on the submitting task.
+// Returns false when the new request was the one dropped.
+//
+bool inference_submit(const inference_request_t *request)
+{
+    inference_request_t dropped;
+    bool evicted = false;
+    bool accepted = true;
+
+    taskENTER_CRITICAL();
+    inference_stats.submitted++;
+    if (inference_queued == INFERENCE_QUEUE_LENGTH)
+    {
+        uint32_t victim = inference_victim();
+        if ((inference_policy & INFERENCE_POLICY_DROP_OLDEST) &&
+            (inference_queue[victim].request.priority <= request->priority))
+        {
+            dropped = inference_queue[victim].request;
+            inference_queue[victim] = inference_queue[--inference_queued];
+            evicted = true;
+        }
+        else
+        {
+            accepted = false;
+        }
+        inference_stats.dropped++;
+    }
+
+    if (accepted)
+    {
+        inference_entry_t *entry = &inference_queue[inference_queued++];
+        entry->request = *request;
+        entry->sequence = inference_sequence++;
+        entry->submitted = perf_timestamp();
+        entry->submitted_ticks = xTaskGetTickCount();
+        if (inference_queued > inference_stats.high_water)
+        {
+            inference_stats.high_water = inference_queued;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (evicted)
+    {
+        inference_reply(&dropped, INFERENCE_DROPPED, 0);
+    }
+
+    if (!accepted)
+    {
+        inference_reply(request, INFERENCE_DROPPED, 0);
+        return false;
+    }
+
+    xTaskNotifyGive(inference_task_handle);
+    return true;
+}
+
+void inference_set_policy(uint32_t policy)
+{
+    inference_policy = policy;
+}
+
+uint32_t inference_get_policy(void)
+{
+    return inference_policy;
+}
+
+void inference_get_stats(inference_stats_t *stats)
+{
+    uint64_t wait_total;
+    uint32_t waited;
+
+    taskENTER_CRITICAL();
+    *stats = inference_stats;
+    stats->depth = inference_queued;
+    wait_total = inference_wait_total;
+    taskEXIT_CRITICAL();
+
+    waited = stats->completed + stats->stale;
+    stats->wait_mean_us = waited ? (uint32_t)(wait_total / waited) : 0;
+}
+
+void inference_reset(void)
+{
+    taskENTER_CRITICAL();
+    memset(&inference_stats, 0, sizeof(inference_stats));
+    inference_stats.high_water = inference_queued;
+    inference_wait_total = 0;
+    taskEXIT_CRITICAL();
+}
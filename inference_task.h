@@ -0,0 +1,110 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _INFERENCE_TASK_H_
+#define _INFERENCE_TASK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// requests waiting for the inference task
+#ifndef INFERENCE_QUEUE_LENGTH
+#define INFERENCE_QUEUE_LENGTH (4)
+#endif
+
+// a full queue drops its oldest request instead of refusing the new one
+#define INFERENCE_POLICY_DROP_OLDEST (0x01)
+// a request past its deadline is skipped instead of run
+#define INFERENCE_POLICY_SKIP_STALE  (0x02)
+
+#ifndef INFERENCE_POLICY
+#define INFERENCE_POLICY (INFERENCE_POLICY_DROP_OLDEST | INFERENCE_POLICY_SKIP_STALE)
+#endif
+
+#define INFERENCE_MAX_SCORES (16)
+
+// reported instead of a prediction for requests that never ran
+#define INFERENCE_DROPPED (0xD)
+#define INFERENCE_STALE   (0xC)
+
+typedef struct inference_result_s
+{
+    uint32_t value;  // prediction, TFLM_INFERENCE_FAILED or one of the above
+    size_t count;
+    uint32_t ticks;
+    uint32_t wait_us; // time spent in the queue
+    int8_t scores[INFERENCE_MAX_SCORES];
+} inference_result_t;
+
+// called on the inference task, or on the submitting task for a request
+// dropped from a full queue
+typedef void (*inference_callback_t)(const inference_result_t *result, void *context);
+
+typedef struct inference_request_s
+{
+    const uint8_t *tensor; // must stay valid until the callback
+    size_t size;
+    uint32_t model;        // model version the tensor is for, 0 for any
+    uint32_t priority;     // higher runs first, equal priorities in order
+    uint32_t deadline_ms;  // after submission, 0 for none
+    inference_callback_t callback;
+    void *context;
+} inference_request_t;
+
+typedef struct inference_stats_s
+{
+    uint32_t submitted;
+    uint32_t completed;   // ran, successfully or not
+    uint32_t dropped;     // refused or pushed out of a full queue
+    uint32_t stale;       // skipped past their deadline
+    uint32_t depth;       // requests waiting right now
+    uint32_t high_water;  // most requests ever waiting
+    uint32_t wait_max_us;
+    uint32_t wait_mean_us;
+} inference_stats_t;
+
+extern void inference_task_create(uint32_t priority);
+extern bool inference_submit(const inference_request_t *request);
+extern void inference_set_policy(uint32_t policy);
+extern uint32_t inference_get_policy(void);
+extern void inference_get_stats(inference_stats_t *stats);
+extern void inference_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
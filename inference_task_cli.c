@@ -0,0 +1,135 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <FreeRTOS_CLI.h>
+
+#include "inference_task.h"
+#include "inference_task_cli.h"
+
+static portBASE_TYPE inference_task_cli_entry(char *pui8OutBuffer,
+                                              size_t ui32OutBufferLength,
+                                              const char *pui8Command);
+
+static CLI_Command_Definition_t inference_task_cli_definition = {
+    (const char *const) "infer",
+    (const char *const) "infer  :  Inference Request Queue.\r\n",
+    inference_task_cli_entry,
+    -1};
+
+void inference_task_cli_register()
+{
+    FreeRTOS_CLIRegisterCommand(&inference_task_cli_definition);
+}
+
+static void help(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    strcat(pui8OutBuffer, "\r\nusage: infer [command]\r\n");
+    strcat(pui8OutBuffer, "\r\n");
+    strcat(pui8OutBuffer, "supported commands are:\r\n");
+    strcat(pui8OutBuffer, "  drop <oldest|new>\r\n");
+    strcat(pui8OutBuffer, "         which request a full queue drops\r\n");
+    strcat(pui8OutBuffer, "  stale <skip|run>\r\n");
+    strcat(pui8OutBuffer, "         what to do with a request past its deadline\r\n");
+    strcat(pui8OutBuffer, "  reset  clear the counters\r\n");
+    strcat(pui8OutBuffer, "\r\n");
+    strcat(pui8OutBuffer, "without a command the queue counters are shown\r\n");
+}
+
+static void show(void)
+{
+    inference_stats_t stats;
+    uint32_t policy = inference_get_policy();
+
+    inference_get_stats(&stats);
+
+    am_util_stdio_printf("\r\nqueue: %d of %d waiting, at most %d, drop %s, %s stale requests\r\n",
+                         stats.depth,
+                         INFERENCE_QUEUE_LENGTH,
+                         stats.high_water,
+                         (policy & INFERENCE_POLICY_DROP_OLDEST) ? "oldest" : "new",
+                         (policy & INFERENCE_POLICY_SKIP_STALE) ? "skip" : "run");
+    am_util_stdio_printf("requests: %d submitted, %d completed, %d dropped, %d stale\r\n",
+                         stats.submitted,
+                         stats.completed,
+                         stats.dropped,
+                         stats.stale);
+    am_util_stdio_printf("wait: %d us mean, %d us max\r\n", stats.wait_mean_us, stats.wait_max_us);
+}
+
+static void set_policy(uint32_t flag, bool enable)
+{
+    uint32_t policy = inference_get_policy();
+
+    inference_set_policy(enable ? (policy | flag) : (policy & ~flag));
+}
+
+portBASE_TYPE
+inference_task_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const char *pui8Command)
+{
+    size_t argc;
+    char *argv[8];
+    char argz[128];
+
+    pui8OutBuffer[0] = 0;
+
+    strcpy(argz, pui8Command);
+    FreeRTOS_CLIExtractParameters(argz, &argc, argv);
+
+    if (argc < 2)
+    {
+        show();
+    }
+    else if (strcmp(argv[1], "help") == 0)
+    {
+        help(pui8OutBuffer, argc, argv);
+    }
+    else if ((strcmp(argv[1], "drop") == 0) && (argc > 2))
+    {
+        set_policy(INFERENCE_POLICY_DROP_OLDEST, strcmp(argv[2], "oldest") == 0);
+    }
+    else if ((strcmp(argv[1], "stale") == 0) && (argc > 2))
+    {
+        set_policy(INFERENCE_POLICY_SKIP_STALE, strcmp(argv[2], "skip") == 0);
+    }
+    else if (strcmp(argv[1], "reset") == 0)
+    {
+        inference_reset();
+    }
+
+    return pdFALSE;
+}
@@ -0,0 +1,307 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "logger.h"
+#include "rtos_alloc.h"
+
+//
+// Every registered task owns a single producer, single consumer ring so that
+// recording a message never takes a lock.  Interrupts and tasks that have not
+// registered share one extra ring guarded by a short critical section.  The
+// logger task drains the rings in the order the messages were recorded.
+//
+// application, button, camera, console, inference and the four pipeline
+// stages, with one to spare
+#define LOGGER_MAX_TASKS       (10)
+#define LOGGER_SHARED_RING     (LOGGER_MAX_TASKS)
+#define LOGGER_RING_SIZE       (32)
+#define LOGGER_DRAIN_PERIOD_MS (100)
+
+typedef struct logger_entry_s
+{
+    const char *format;
+    uint32_t sequence;
+    uint8_t level;
+    uint8_t argc;
+    uint32_t args[LOGGER_MAX_ARGS];
+} logger_entry_t;
+
+typedef struct logger_ring_s
+{
+    TaskHandle_t owner;
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;
+    uint32_t reported;
+    logger_entry_t entries[LOGGER_RING_SIZE];
+} logger_ring_t;
+
+static logger_ring_t logger_rings[LOGGER_MAX_TASKS + 1];
+static volatile uint32_t logger_ring_count;
+static volatile uint32_t logger_sequence;
+static volatile uint32_t logger_recorded;
+static volatile uint32_t logger_high_water_mark;
+
+#define LOGGER_TASK_STACK_SIZE (512)
+
+static TaskHandle_t logger_task_handle;
+
+RTOS_TASK_STORAGE(logger_task, LOGGER_TASK_STACK_SIZE)
+
+static const char logger_crlf[] = "\r\n";
+
+static logger_ring_t *logger_find_ring(bool isr)
+{
+    if (!isr)
+    {
+        TaskHandle_t task = xTaskGetCurrentTaskHandle();
+        uint32_t count = logger_ring_count;
+
+        for (uint32_t i = 0; (i < count) && (i < LOGGER_MAX_TASKS); i++)
+        {
+            if (logger_rings[i].owner == task)
+            {
+                return &logger_rings[i];
+            }
+        }
+    }
+
+    return &logger_rings[LOGGER_SHARED_RING];
+}
+
+static void logger_print(const logger_entry_t *entry)
+{
+    am_util_stdio_printf(
+        entry->format, entry->args[0], entry->args[1], entry->args[2], entry->args[3]);
+    am_util_stdio_printf(logger_crlf);
+}
+
+static void logger_drain(void)
+{
+    uint32_t count = logger_ring_count;
+    if (count > LOGGER_MAX_TASKS)
+    {
+        count = LOGGER_MAX_TASKS;
+    }
+
+    while (1)
+    {
+        logger_ring_t *next = NULL;
+        uint32_t sequence = 0;
+
+        for (uint32_t i = 0; i <= LOGGER_MAX_TASKS; i++)
+        {
+            if ((i >= count) && (i != LOGGER_SHARED_RING))
+            {
+                continue;
+            }
+
+            logger_ring_t *ring = &logger_rings[i];
+            uint32_t tail = ring->tail;
+            if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+            {
+                continue;
+            }
+
+            uint32_t candidate = ring->entries[tail % LOGGER_RING_SIZE].sequence;
+            if ((next == NULL) || ((int32_t)(candidate - sequence) < 0))
+            {
+                next = ring;
+                sequence = candidate;
+            }
+        }
+
+        if (next == NULL)
+        {
+            break;
+        }
+
+        logger_print(&next->entries[next->tail % LOGGER_RING_SIZE]);
+        __atomic_store_n(&next->tail, next->tail + 1, __ATOMIC_RELEASE);
+    }
+
+    for (uint32_t i = 0; i <= LOGGER_MAX_TASKS; i++)
+    {
+        logger_ring_t *ring = &logger_rings[i];
+        uint32_t dropped = ring->dropped;
+        if (dropped != ring->reported)
+        {
+            am_util_stdio_printf("logger: %d messages dropped by %s\r\n",
+                                 dropped - ring->reported,
+                                 (i == LOGGER_SHARED_RING) ? "isr" : pcTaskGetName(ring->owner));
+            ring->reported = dropped;
+        }
+    }
+}
+
+static void logger_task(void *parameter)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOGGER_DRAIN_PERIOD_MS));
+        logger_drain();
+    }
+}
+
+void logger_task_create(uint32_t priority)
+{
+    RTOS_TASK_CREATE(logger_task,
+                     logger_task,
+                     "logger",
+                     LOGGER_TASK_STACK_SIZE,
+                     0,
+                     priority,
+                     &logger_task_handle);
+}
+
+//
+// Give the calling task a private ring.  Must be called from the task itself,
+// typically first thing in its task function.
+//
+void logger_register_task(void)
+{
+    uint32_t index = __atomic_fetch_add(&logger_ring_count, 1, __ATOMIC_RELAXED);
+    if (index < LOGGER_MAX_TASKS)
+    {
+        logger_rings[index].owner = xTaskGetCurrentTaskHandle();
+        return;
+    }
+
+    // the task would take the lock of the shared ring on every message
+    LOG_WARN("logger: %s has no ring of its own, raise LOGGER_MAX_TASKS", pcTaskGetName(NULL));
+    configASSERT(index < LOGGER_MAX_TASKS);
+}
+
+void logger_record(uint8_t level, const char *format, uint32_t argc, ...)
+{
+    bool isr = (xPortIsInsideInterrupt() == pdTRUE);
+    logger_ring_t *ring = logger_find_ring(isr);
+    bool shared = (ring == &logger_rings[LOGGER_SHARED_RING]);
+    UBaseType_t interrupt_status = 0;
+
+    if (shared)
+    {
+        if (isr)
+        {
+            interrupt_status = taskENTER_CRITICAL_FROM_ISR();
+        }
+        else
+        {
+            taskENTER_CRITICAL();
+        }
+    }
+
+    uint32_t head = ring->head;
+    uint32_t used = head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    bool was_empty = (used == 0);
+
+    if (used >= LOGGER_RING_SIZE)
+    {
+        ring->dropped++;
+    }
+    else
+    {
+        logger_entry_t *entry = &ring->entries[head % LOGGER_RING_SIZE];
+        va_list args;
+
+        entry->format = format;
+        entry->level = level;
+        entry->argc = (argc > LOGGER_MAX_ARGS) ? LOGGER_MAX_ARGS : argc;
+        entry->sequence = __atomic_fetch_add(&logger_sequence, 1, __ATOMIC_RELAXED);
+
+        va_start(args, argc);
+        for (uint32_t i = 0; i < LOGGER_MAX_ARGS; i++)
+        {
+            entry->args[i] = (i < entry->argc) ? va_arg(args, uint32_t) : 0;
+        }
+        va_end(args);
+
+        __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&logger_recorded, 1, __ATOMIC_RELAXED);
+
+        if ((used + 1) > logger_high_water_mark)
+        {
+            logger_high_water_mark = used + 1;
+        }
+    }
+
+    if (shared)
+    {
+        if (isr)
+        {
+            taskEXIT_CRITICAL_FROM_ISR(interrupt_status);
+        }
+        else
+        {
+            taskEXIT_CRITICAL();
+        }
+    }
+
+    // the logger task only needs waking when its rings go from idle to busy,
+    // anything recorded in the meantime is picked up by the same drain pass.
+    if (was_empty && logger_task_handle)
+    {
+        if (isr)
+        {
+            BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+            vTaskNotifyGiveFromISR(logger_task_handle, &xHigherPriorityTaskWoken);
+            portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+        }
+        else
+        {
+            xTaskNotifyGive(logger_task_handle);
+        }
+    }
+}
+
+void logger_get_stats(logger_stats_t *stats)
+{
+    uint32_t dropped = 0;
+
+    for (uint32_t i = 0; i <= LOGGER_MAX_TASKS; i++)
+    {
+        dropped += logger_rings[i].dropped;
+    }
+
+    stats->recorded = logger_recorded;
+    stats->dropped = dropped;
+    stats->high_water_mark = logger_high_water_mark;
+}
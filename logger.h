@@ -0,0 +1,108 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _LOGGER_H_
+#define _LOGGER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LOG_LEVEL_NONE  (0)
+#define LOG_LEVEL_ERROR (1)
+#define LOG_LEVEL_WARN  (2)
+#define LOG_LEVEL_INFO  (3)
+#define LOG_LEVEL_DEBUG (4)
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOGGER_MAX_ARGS (4)
+
+//
+// Deferred logging.  Only the format string pointer and up to
+// LOGGER_MAX_ARGS 32-bit arguments are recorded by the caller; formatting is
+// done later by the low priority logger task.  Consequently the format string
+// and any %s argument must point to storage that outlives the call (string
+// literals or static data), and floating point arguments are not supported.
+// Each line is terminated with CRLF by the logger.  A call with more than
+// LOGGER_MAX_ARGS arguments (up to eight) fails to compile on the undeclared
+// logger_too_many_arguments rather than passing an argument as the count.
+//
+#define LOGGER_NARGS(...)                                                                                   \
+    LOGGER_NARGS_(0, ##__VA_ARGS__, logger_too_many_arguments, logger_too_many_arguments,                  \
+                  logger_too_many_arguments, logger_too_many_arguments, 4, 3, 2, 1, 0)
+#define LOGGER_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) logger_record(LOG_LEVEL_ERROR, fmt, LOGGER_NARGS(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...) logger_record(LOG_LEVEL_WARN, fmt, LOGGER_NARGS(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...) logger_record(LOG_LEVEL_INFO, fmt, LOGGER_NARGS(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) logger_record(LOG_LEVEL_DEBUG, fmt, LOGGER_NARGS(__VA_ARGS__), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) do {} while (0)
+#endif
+
+typedef struct logger_stats_s
+{
+    uint32_t recorded;
+    uint32_t dropped;
+    uint32_t high_water_mark;
+} logger_stats_t;
+
+extern void logger_task_create(uint32_t priority);
+extern void logger_register_task(void);
+extern void logger_record(uint8_t level, const char *format, uint32_t argc, ...);
+extern void logger_get_stats(logger_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
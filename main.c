@@ -45,6 +45,13 @@
 #include "button_task.h"
 #include "camera_task.h"
 #include "console_task.h"
+#include "governor.h"
+#include "inference_task.h"
+#include "logger.h"
+#include "overlay.h"
+#include "perf.h"
+#include "pipeline.h"
+#include "rtos_alloc.h"
 
 //*****************************************************************************
 //
@@ -124,6 +131,35 @@ void vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName)
     }
 }
 
+#if defined(STATIC_ALLOCATION)
+//*****************************************************************************
+//
+// Memory for the idle and timer service tasks, which the kernel creates
+// itself when static allocation is supported.
+//
+//*****************************************************************************
+RTOS_TASK_STORAGE(idle_task, configMINIMAL_STACK_SIZE)
+RTOS_TASK_STORAGE(timer_task, configTIMER_TASK_STACK_DEPTH)
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+    *ppxIdleTaskTCBBuffer = &idle_task_tcb;
+    *ppxIdleTaskStackBuffer = idle_task_stack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+    *ppxTimerTaskTCBBuffer = &timer_task_tcb;
+    *ppxTimerTaskStackBuffer = timer_task_stack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+
 void system_setup(void)
 {
     //
@@ -160,10 +196,17 @@ void system_setup(void)
 
 void system_start(void)
 {
+    perf_setup();
+    governor_setup();
+    overlay_setup();
+
     button_task_create(4);
     console_task_create(3, CONSOLE_OUTPUT_UART);
     camera_task_create(2);
+    pipeline_create();
+    inference_task_create(1);
     application_task_create(1);
+    logger_task_create(tskIDLE_PRIORITY);
 
     //
     // Start the scheduler.
@@ -0,0 +1,91 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stddef.h>
+
+#include "am_bootloader.h"
+#include "logger.h"
+#include "model_partition.h"
+
+static bool model_partition_header_check(const model_partition_header_t *header)
+{
+    uint32_t crc = 0;
+
+    if ((header->magic != MODEL_PARTITION_MAGIC) || (header->format != MODEL_PARTITION_FORMAT))
+    {
+        return false;
+    }
+
+    am_bootloader_partial_slice8_crc32(header, offsetof(model_partition_header_t, header_crc), &crc);
+    if (crc != header->header_crc)
+    {
+        LOG_WARN("model partition header is corrupt");
+        return false;
+    }
+
+    if ((header->header_size < sizeof(model_partition_header_t)) ||
+        (header->header_size & 0xF) ||
+        (header->size > (MODEL_PARTITION_SIZE - (uint32_t)header->header_size)) ||
+        (header->categories > MODEL_PARTITION_LABELS))
+    {
+        LOG_WARN("model partition header is out of range");
+        return false;
+    }
+
+    return true;
+}
+
+// Returns the header of the model in the partition, or NULL when the
+// partition is erased or does not hold a complete and intact model.  The model
+// is checked in place and never copied.
+const model_partition_header_t *model_partition_find(void)
+{
+    const model_partition_header_t *header =
+        (const model_partition_header_t *)MODEL_PARTITION_ADDRESS;
+
+    if (!model_partition_header_check(header))
+    {
+        return NULL;
+    }
+
+    if (am_bootloader_slice8_crc32(model_partition_data(header), header->size) != header->crc)
+    {
+        LOG_WARN("model partition version %d fails its CRC", header->version);
+        return NULL;
+    }
+
+    return header;
+}
+
+const uint8_t *model_partition_data(const model_partition_header_t *header)
+{
+    return (const uint8_t *)header + header->header_size;
+}
@@ -0,0 +1,90 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _MODEL_PARTITION_H_
+#define _MODEL_PARTITION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Flash partition holding a model that can be replaced without rebuilding or
+// updating the firmware.  The firmware must link below the partition; the
+// build checks this when MODEL_PARTITION is on.  Keep these in step with the
+// boot loader settings of the same name.
+//
+#ifndef MODEL_PARTITION_ADDRESS
+#define MODEL_PARTITION_ADDRESS (0x00080000)
+#endif
+
+#ifndef MODEL_PARTITION_SIZE
+#define MODEL_PARTITION_SIZE (0x00080000)
+#endif
+
+#define MODEL_PARTITION_MAGIC   (0x504D4654) // "TFMP"
+#define MODEL_PARTITION_FORMAT  (1)
+#define MODEL_PARTITION_LABELS  (16)
+
+//
+// The blob written by tools/create_model_blob.py.  The model follows the
+// header, which is a multiple of 16 bytes so the flatbuffer stays aligned.
+// Both CRCs use the boot loader CRC-32 so the OTA path can check them too.
+//
+typedef struct model_partition_header_s
+{
+    uint32_t magic;
+    uint16_t header_size;
+    uint16_t format;
+    uint32_t version;    // model version, chosen by whoever builds the blob
+    uint32_t size;       // bytes of model following the header
+    uint32_t crc;        // CRC-32 of the model
+    uint32_t arena_size; // tensor arena the model needs, 0 if unknown
+    uint8_t rows;
+    uint8_t columns;
+    uint8_t channels;
+    uint8_t categories;
+    char labels[MODEL_PARTITION_LABELS];
+    uint32_t reserved[4];
+    uint32_t header_crc; // CRC-32 of everything above
+} model_partition_header_t;
+
+extern const model_partition_header_t *model_partition_find(void);
+extern const uint8_t *model_partition_data(const model_partition_header_t *header);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
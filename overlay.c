@@ -0,0 +1,253 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+
+#include "overlay.h"
+#include "rtos_alloc.h"
+
+#define OVERLAY_ALIGNMENT (8)
+
+typedef struct overlay_lease_s
+{
+    uint8_t *buffer;
+    size_t size;
+} overlay_lease_t;
+
+RTOS_SEMAPHORE_STORAGE(overlay)
+
+// held by the task with leases out, or by the model during an inference
+static SemaphoreHandle_t overlay_mutex;
+
+static uint8_t *overlay_region;
+static size_t overlay_size;
+static size_t overlay_used;
+static TaskHandle_t overlay_owner;
+static TaskHandle_t overlay_last_owner;
+static overlay_lease_t overlay_leases[OVERLAY_MAX_LEASES];
+static uint32_t overlay_lease_count;
+static volatile uint32_t overlay_generation_count;
+static overlay_stats_t overlay_stats;
+
+#if defined(OVERLAY_CHECKS)
+// line of the failed check, for the debugger
+static volatile uint32_t overlay_failed_line;
+
+static void overlay_fail(uint32_t line)
+{
+    overlay_failed_line = line;
+    while (1)
+    {
+        __asm("BKPT #0\n"); // Break into the debugger
+    }
+}
+
+#define OVERLAY_ASSERT(condition)                                                                  \
+    do                                                                                             \
+    {                                                                                              \
+        if (!(condition))                                                                          \
+        {                                                                                          \
+            overlay_fail(__LINE__);                                                                \
+        }                                                                                          \
+    } while (0)
+#else
+#define OVERLAY_ASSERT(condition) do {} while (0)
+#endif
+
+// called with the mutex held once the last lease is back
+static void overlay_give_back(void)
+{
+    overlay_used = 0;
+    overlay_owner = NULL;
+    xSemaphoreGive(overlay_mutex);
+}
+
+void overlay_setup(void)
+{
+    overlay_mutex = RTOS_MUTEX_CREATE(overlay);
+}
+
+void overlay_set_region(uint8_t *region, size_t size)
+{
+    xSemaphoreTake(overlay_mutex, portMAX_DELAY);
+    OVERLAY_ASSERT(overlay_lease_count == 0);
+    overlay_region = region;
+    overlay_size = size;
+    overlay_generation_count++;
+    xSemaphoreGive(overlay_mutex);
+
+    taskENTER_CRITICAL();
+    overlay_stats.size = size;
+    taskEXIT_CRITICAL();
+}
+
+//
+// Lease size bytes, waiting up to timeout for the model or another task to
+// give the region back.  Returns NULL if the region could not be had in time
+// or the lease does not fit next to the ones already out.
+//
+void *overlay_lease(size_t size, TickType_t timeout)
+{
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    size_t aligned = (size + OVERLAY_ALIGNMENT - 1) & ~(size_t)(OVERLAY_ALIGNMENT - 1);
+
+    if (overlay_owner != task)
+    {
+        if (xSemaphoreTake(overlay_mutex, timeout) != pdTRUE)
+        {
+            taskENTER_CRITICAL();
+            overlay_stats.refused++;
+            taskEXIT_CRITICAL();
+            return NULL;
+        }
+
+        OVERLAY_ASSERT((overlay_lease_count == 0) && (overlay_used == 0));
+        overlay_owner = task;
+        if (overlay_last_owner != task)
+        {
+            overlay_generation_count++;
+            overlay_last_owner = task;
+        }
+    }
+
+    if ((overlay_lease_count == OVERLAY_MAX_LEASES) || ((overlay_used + aligned) > overlay_size))
+    {
+        taskENTER_CRITICAL();
+        overlay_stats.refused++;
+        taskEXIT_CRITICAL();
+        if (overlay_lease_count == 0)
+        {
+            overlay_give_back();
+        }
+        return NULL;
+    }
+
+    uint8_t *buffer = &overlay_region[overlay_used];
+
+#if defined(OVERLAY_CHECKS)
+    for (uint32_t i = 0; i < overlay_lease_count; i++)
+    {
+        const overlay_lease_t *lease = &overlay_leases[i];
+        OVERLAY_ASSERT(((buffer + aligned) <= lease->buffer) ||
+                       (buffer >= (lease->buffer + lease->size)));
+    }
+    OVERLAY_ASSERT((buffer + aligned) <= (overlay_region + overlay_size));
+#endif
+
+    overlay_leases[overlay_lease_count].buffer = buffer;
+    overlay_leases[overlay_lease_count].size = aligned;
+    overlay_lease_count++;
+    overlay_used += aligned;
+
+    taskENTER_CRITICAL();
+    overlay_stats.leases++;
+    overlay_stats.leased += aligned;
+    if (overlay_used > overlay_stats.high_water)
+    {
+        overlay_stats.high_water = overlay_used;
+    }
+    taskEXIT_CRITICAL();
+
+    return buffer;
+}
+
+//
+// Return a lease.  The space is only reused once every lease of the task has
+// come back, and then the region is free for the model again.
+//
+void overlay_return(void *buffer)
+{
+    uint32_t i;
+
+    OVERLAY_ASSERT(overlay_owner == xTaskGetCurrentTaskHandle());
+    if (overlay_owner != xTaskGetCurrentTaskHandle())
+    {
+        return;
+    }
+
+    for (i = 0; i < overlay_lease_count; i++)
+    {
+        if (overlay_leases[i].buffer == buffer)
+        {
+            break;
+        }
+    }
+
+    OVERLAY_ASSERT(i < overlay_lease_count);
+    if (i == overlay_lease_count)
+    {
+        return;
+    }
+
+#if defined(OVERLAY_CHECKS)
+    // a buffer used after it has been returned shows up as this pattern
+    memset(overlay_leases[i].buffer, 0xA5, overlay_leases[i].size);
+#endif
+
+    taskENTER_CRITICAL();
+    overlay_stats.leased -= overlay_leases[i].size;
+    taskEXIT_CRITICAL();
+
+    overlay_leases[i] = overlay_leases[--overlay_lease_count];
+    if (overlay_lease_count == 0)
+    {
+        overlay_give_back();
+    }
+}
+
+void overlay_claim(void)
+{
+    xSemaphoreTake(overlay_mutex, portMAX_DELAY);
+    OVERLAY_ASSERT((overlay_lease_count == 0) && (overlay_owner == NULL));
+    overlay_generation_count++;
+    overlay_last_owner = NULL;
+}
+
+void overlay_release(void)
+{
+    xSemaphoreGive(overlay_mutex);
+}
+
+uint32_t overlay_generation(void)
+{
+    return overlay_generation_count;
+}
+
+void overlay_get_stats(overlay_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = overlay_stats;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,91 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _OVERLAY_H_
+#define _OVERLAY_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Memory that the model only needs while an inference runs, lent out in
+// between.  The compiled model (TFLM_AOT) keeps nothing in its arena from one
+// inference to the next, so tflm_setup() hands the whole arena over here.  The
+// interpreter keeps its bookkeeping in the persistent section at the end of
+// its arena, so only the head before it is handed over.  Until tflm_setup()
+// has run the region is empty and every lease is refused.
+//
+// A task leases buffers, uses them and returns them.  While any lease is out
+// the region belongs to that task and an inference waits for the last one to
+// come back; leases are handed out from the start of the region in order and
+// must be returned by the task that took them.
+//
+
+// leases one task can hold at a time
+#define OVERLAY_MAX_LEASES (4)
+
+typedef struct overlay_stats_s
+{
+    uint32_t size;       // bytes in the region
+    uint32_t leased;     // bytes leased right now
+    uint32_t high_water; // most bytes ever leased at once
+    uint32_t leases;     // leases granted
+    uint32_t refused;    // leases that timed out or did not fit
+} overlay_stats_t;
+
+extern void overlay_setup(void);
+extern void overlay_set_region(uint8_t *region, size_t size);
+
+extern void *overlay_lease(size_t size, TickType_t timeout);
+extern void overlay_return(void *buffer);
+
+// The model takes the region for an inference, waiting for every lease.
+extern void overlay_claim(void);
+extern void overlay_release(void);
+
+// Changes every time the model has used the region, so a task can tell
+// whether what it left there is still intact.
+extern uint32_t overlay_generation(void);
+
+extern void overlay_get_stats(overlay_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,156 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "perf.h"
+#include "perf_cli.h"
+
+//
+// Timestamps come from the system timer which keeps running in deep sleep and
+// is not affected by burst mode.  The FreeRTOS port clocks it from the 32 kHz
+// crystal unless configured otherwise.
+//
+#ifndef configSTIMER_CLOCK_HZ
+#define configSTIMER_CLOCK_HZ (32768)
+#endif
+
+static perf_stage_stats_t perf_stages[PERF_STAGE_MAX];
+
+static const char *perf_stage_names[PERF_STAGE_MAX] = {
+    "capture",
+    "preprocess",
+    "inference",
+    "report",
+};
+
+static uint32_t perf_bucket(uint32_t us)
+{
+    uint32_t bucket = 0;
+    uint32_t bound = PERF_HISTOGRAM_BASE_US;
+
+    while ((us >= bound) && (bucket < (PERF_HISTOGRAM_BUCKETS - 1)))
+    {
+        bound <<= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void perf_setup(void)
+{
+    perf_reset();
+    perf_cli_register();
+}
+
+void perf_reset(void)
+{
+    taskENTER_CRITICAL();
+    memset(perf_stages, 0, sizeof(perf_stages));
+    for (uint32_t i = 0; i < PERF_STAGE_MAX; i++)
+    {
+        perf_stages[i].min_us = UINT32_MAX;
+    }
+    taskEXIT_CRITICAL();
+}
+
+uint32_t perf_timestamp(void)
+{
+    return am_hal_stimer_counter_get();
+}
+
+uint32_t perf_elapsed_us(uint32_t start)
+{
+    return perf_interval_us(start, am_hal_stimer_counter_get());
+}
+
+uint32_t perf_interval_us(uint32_t start, uint32_t end)
+{
+    return (uint32_t)(((uint64_t)(end - start) * 1000000) / configSTIMER_CLOCK_HZ);
+}
+
+void perf_record(perf_stage_e stage, uint32_t us)
+{
+    if (stage >= PERF_STAGE_MAX)
+    {
+        return;
+    }
+
+    uint32_t bucket = perf_bucket(us);
+    perf_stage_stats_t *stats = &perf_stages[stage];
+
+    taskENTER_CRITICAL();
+    stats->count++;
+    stats->total_us += us;
+    if (us < stats->min_us)
+    {
+        stats->min_us = us;
+    }
+    if (us > stats->max_us)
+    {
+        stats->max_us = us;
+    }
+    stats->histogram[bucket]++;
+    taskEXIT_CRITICAL();
+}
+
+//
+// Only the copy of one stage is done with interrupts masked, which takes a
+// few dozen cycles.
+//
+void perf_get_stage(perf_stage_e stage, perf_stage_stats_t *stats)
+{
+    if (stage >= PERF_STAGE_MAX)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    *stats = perf_stages[stage];
+    taskEXIT_CRITICAL();
+}
+
+const char *perf_stage_name(perf_stage_e stage)
+{
+    return (stage < PERF_STAGE_MAX) ? perf_stage_names[stage] : "unknown";
+}
+
+uint32_t perf_runtime_counter(void)
+{
+    return am_hal_stimer_counter_get();
+}
@@ -0,0 +1,89 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _PERF_H_
+#define _PERF_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum perf_stage_e
+{
+    PERF_STAGE_CAPTURE,    // exposure and retrieval from the camera
+    PERF_STAGE_PREPROCESS, // decimation and normalization of a frame
+    PERF_STAGE_INFERENCE,  // tflm_inference() including burst mode switching
+    PERF_STAGE_REPORT,     // publishing the result
+    PERF_STAGE_MAX
+} perf_stage_e;
+
+//
+// Latencies are binned on a log2 scale.  Bucket 0 holds samples below
+// PERF_HISTOGRAM_BASE_US, bucket n holds [BASE << (n - 1), BASE << n) and the
+// last bucket also collects everything above its lower bound.
+//
+#define PERF_HISTOGRAM_BUCKETS (16)
+#define PERF_HISTOGRAM_BASE_US (64)
+
+typedef struct perf_stage_stats_s
+{
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t histogram[PERF_HISTOGRAM_BUCKETS];
+} perf_stage_stats_t;
+
+extern void perf_setup(void);
+extern void perf_reset(void);
+
+extern uint32_t perf_timestamp(void);
+extern uint32_t perf_elapsed_us(uint32_t start);
+extern uint32_t perf_interval_us(uint32_t start, uint32_t end);
+extern void perf_record(perf_stage_e stage, uint32_t us);
+extern void perf_get_stage(perf_stage_e stage, perf_stage_stats_t *stats);
+extern const char *perf_stage_name(perf_stage_e stage);
+
+//
+// Free running counter for the FreeRTOS run-time statistics.  To get per task
+// CPU load set configGENERATE_RUN_TIME_STATS to 1 in FreeRTOSConfig.h, define
+// portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() as empty and point
+// portGET_RUN_TIME_COUNTER_VALUE() at this function.
+//
+extern uint32_t perf_runtime_counter(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
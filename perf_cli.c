@@ -0,0 +1,268 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <FreeRTOS_CLI.h>
+#include <task.h>
+
+#include "tflm.h"
+
+#include "console_task.h"
+#include "logger.h"
+#include "overlay.h"
+#include "perf.h"
+#include "perf_cli.h"
+
+// 12 tasks with the pipeline and the inference task, including IDLE and the
+// timer task, with room for a few more
+#define PERF_MAX_TASKS (16)
+
+static portBASE_TYPE perf_cli_entry(char *pui8OutBuffer,
+                                    size_t ui32OutBufferLength,
+                                    const char *pui8Command);
+
+static CLI_Command_Definition_t perf_cli_definition = {
+    (const char *const) "perf",
+    (const char *const) "perf   :  Performance Statistics.\r\n",
+    perf_cli_entry,
+    -1};
+
+#if (configUSE_TRACE_FACILITY == 1)
+static TaskStatus_t perf_task_status[PERF_MAX_TASKS];
+#endif
+
+void perf_cli_register()
+{
+    FreeRTOS_CLIRegisterCommand(&perf_cli_definition);
+}
+
+static void help(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    strcat(pui8OutBuffer, "\r\nusage: perf [command]\r\n");
+    strcat(pui8OutBuffer, "\r\n");
+    strcat(pui8OutBuffer, "supported commands are:\r\n");
+    strcat(pui8OutBuffer, "  tasks   per task state, stack high water mark and cpu load\r\n");
+    strcat(pui8OutBuffer, "  memory  heap, tensor arena, logger and console usage\r\n");
+    strcat(pui8OutBuffer, "  stages  per stage latency histograms\r\n");
+    strcat(pui8OutBuffer, "  reset   clear the latency histograms and console latency\r\n");
+    strcat(pui8OutBuffer, "\r\n");
+    strcat(pui8OutBuffer, "without a command all statistics are shown\r\n");
+}
+
+static void tasks(void)
+{
+#if (configUSE_TRACE_FACILITY == 1)
+    static const char states[] = "XRBSD?";
+    uint32_t total_runtime;
+    UBaseType_t count;
+
+    // the scheduler is suspended while the task list is walked, interrupts
+    // stay enabled
+    count = uxTaskGetSystemState(perf_task_status, PERF_MAX_TASKS, &total_runtime);
+    if (count == 0)
+    {
+        am_util_stdio_printf("%d tasks, more than %d, increase PERF_MAX_TASKS\r\n",
+                             uxTaskGetNumberOfTasks(),
+                             PERF_MAX_TASKS);
+        return;
+    }
+
+    am_util_stdio_printf("\r\ntask          state  prio  stack free (words)  cpu\r\n");
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        TaskStatus_t *task = &perf_task_status[i];
+        uint32_t state = task->eCurrentState;
+
+        am_util_stdio_printf("%-12s  %c      %4d  %17d  ",
+                             task->pcTaskName,
+                             states[state < (sizeof(states) - 1) ? state : (sizeof(states) - 2)],
+                             task->uxCurrentPriority,
+                             task->usStackHighWaterMark);
+#if (configGENERATE_RUN_TIME_STATS == 1)
+        if (total_runtime > 0)
+        {
+            uint32_t permille = (uint32_t)(((uint64_t)task->ulRunTimeCounter * 1000) / total_runtime);
+            am_util_stdio_printf("%3d.%d%%\r\n", permille / 10, permille % 10);
+        }
+        else
+        {
+            am_util_stdio_printf("-\r\n");
+        }
+#else
+        am_util_stdio_printf("-\r\n");
+#endif
+    }
+#if (configGENERATE_RUN_TIME_STATS != 1)
+    am_util_stdio_printf("cpu load requires configGENERATE_RUN_TIME_STATS, see perf.h\r\n");
+#endif
+#else
+    am_util_stdio_printf("task statistics require configUSE_TRACE_FACILITY\r\n");
+#endif
+}
+
+static void memory(void)
+{
+    tflm_info_t model;
+    logger_stats_t logger;
+    console_stats_t console;
+    overlay_stats_t overlay;
+
+    tflm_get_info(&model);
+    overlay_get_stats(&overlay);
+    logger_get_stats(&logger);
+    console_get_stats(&console);
+
+    am_util_stdio_printf("\r\nheap: %d free, %d minimum ever free of %d bytes\r\n",
+                         xPortGetFreeHeapSize(),
+                         xPortGetMinimumEverFreeHeapSize(),
+                         configTOTAL_HEAP_SIZE);
+    am_util_stdio_printf("tensor arena: %d of %d bytes used\r\n", model.arena_used, model.arena_size);
+    am_util_stdio_printf("overlay: %d of %d bytes leased, %d at most, %d leases, %d refused\r\n",
+                         overlay.leased,
+                         overlay.size,
+                         overlay.high_water,
+                         overlay.leases,
+                         overlay.refused);
+    am_util_stdio_printf("model: %d bytes, version %d, %s\r\n",
+                         model.model_size,
+                         model.model_version,
+                         model.model_in_partition ? "partition" : "built in");
+    am_util_stdio_printf("model setup: %d us, %s\r\n",
+                         model.setup_us,
+                         model.setup_restored ? "restored" : "planned");
+    am_util_stdio_printf("logger: %d recorded, %d dropped, ring high water mark %d\r\n",
+                         logger.recorded,
+                         logger.dropped,
+                         logger.high_water_mark);
+    am_util_stdio_printf("console: %d bytes received in %d reads, %d dropped, %d overruns\r\n",
+                         console.rx_bytes,
+                         console.rx_batches,
+                         console.rx_dropped,
+                         console.rx_overruns);
+    am_util_stdio_printf("console latency: %d us mean, %d us max\r\n",
+                         console.rx_latency_mean_us,
+                         console.rx_latency_max_us);
+    am_util_stdio_printf("inference slice: %d layers, longest %d ticks\r\n",
+                         model.slice_layers,
+                         model.slice_ticks);
+}
+
+static void stages(void)
+{
+    perf_stage_stats_t stats;
+
+    for (uint32_t stage = 0; stage < PERF_STAGE_MAX; stage++)
+    {
+        perf_get_stage((perf_stage_e)stage, &stats);
+
+        am_util_stdio_printf("\r\n%s: %d samples", perf_stage_name((perf_stage_e)stage), stats.count);
+        if (stats.count == 0)
+        {
+            am_util_stdio_printf("\r\n");
+            continue;
+        }
+        am_util_stdio_printf(", min %d us, mean %d us, max %d us\r\n",
+                             stats.min_us,
+                             (uint32_t)(stats.total_us / stats.count),
+                             stats.max_us);
+
+        for (uint32_t bucket = 0; bucket < PERF_HISTOGRAM_BUCKETS; bucket++)
+        {
+            if (stats.histogram[bucket] == 0)
+            {
+                continue;
+            }
+
+            uint32_t upper = PERF_HISTOGRAM_BASE_US << bucket;
+            if (bucket == 0)
+            {
+                am_util_stdio_printf("  %9s < %8d us: %d\r\n", "", upper, stats.histogram[bucket]);
+            }
+            else if (bucket == (PERF_HISTOGRAM_BUCKETS - 1))
+            {
+                am_util_stdio_printf("  %9d+ %8s us: %d\r\n", upper >> 1, "", stats.histogram[bucket]);
+            }
+            else
+            {
+                am_util_stdio_printf("  %9d - %8d us: %d\r\n", upper >> 1, upper, stats.histogram[bucket]);
+            }
+        }
+    }
+}
+
+portBASE_TYPE
+perf_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const char *pui8Command)
+{
+    size_t argc;
+    char *argv[8];
+    char argz[128];
+
+    pui8OutBuffer[0] = 0;
+
+    strcpy(argz, pui8Command);
+    FreeRTOS_CLIExtractParameters(argz, &argc, argv);
+
+    if (argc < 2)
+    {
+        tasks();
+        memory();
+        stages();
+    }
+    else if (strcmp(argv[1], "help") == 0)
+    {
+        help(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "tasks") == 0)
+    {
+        tasks();
+    }
+    else if (strcmp(argv[1], "memory") == 0)
+    {
+        memory();
+    }
+    else if (strcmp(argv[1], "stages") == 0)
+    {
+        stages();
+    }
+    else if (strcmp(argv[1], "reset") == 0)
+    {
+        perf_reset();
+        console_reset_latency();
+    }
+
+    return pdFALSE;
+}
@@ -0,0 +1,346 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <semphr.h>
+#include <task.h>
+
+#include "tflm.h"
+
+#include "camera_task.h"
+#include "governor.h"
+#include "logger.h"
+#include "perf.h"
+#include "pipeline.h"
+#include "pipeline_cli.h"
+#include "rtos_alloc.h"
+
+typedef bool (*pipeline_process_t)(pipeline_frame_t *frame);
+
+typedef struct pipeline_stage_s
+{
+    const char *name;
+    uint32_t priority;
+    pipeline_process_t process;
+    QueueHandle_t input;
+    QueueHandle_t output;
+    TaskHandle_t task;
+    pipeline_stage_stats_t stats;
+} pipeline_stage_t;
+
+static bool pipeline_capture(pipeline_frame_t *frame);
+static bool pipeline_preprocess(pipeline_frame_t *frame);
+static bool pipeline_inference(pipeline_frame_t *frame);
+static bool pipeline_publish(pipeline_frame_t *frame);
+
+static pipeline_frame_t pipeline_frames[PIPELINE_FRAMES];
+
+// free frames feed capture, publish returns frames to the free queue
+static QueueHandle_t pipeline_queues[PIPELINE_STAGE_MAX];
+
+static pipeline_stage_t pipeline_stages[PIPELINE_STAGE_MAX] = {
+    {"capture", PIPELINE_CAPTURE_PRIORITY, pipeline_capture},
+    {"preprocess", PIPELINE_PREPROCESS_PRIORITY, pipeline_preprocess},
+    {"inference", PIPELINE_INFERENCE_PRIORITY, pipeline_inference},
+    {"publish", PIPELINE_PUBLISH_PRIORITY, pipeline_publish},
+};
+
+static SemaphoreHandle_t pipeline_trigger_handle;
+
+#define PIPELINE_TASK_STACK_SIZE (512)
+
+RTOS_QUEUE_STORAGE(pipeline_free, PIPELINE_FRAMES, sizeof(pipeline_frame_t *))
+RTOS_QUEUE_STORAGE(pipeline_preprocess_input, PIPELINE_QUEUE_DEPTH, sizeof(pipeline_frame_t *))
+RTOS_QUEUE_STORAGE(pipeline_inference_input, PIPELINE_QUEUE_DEPTH, sizeof(pipeline_frame_t *))
+RTOS_QUEUE_STORAGE(pipeline_publish_input, PIPELINE_QUEUE_DEPTH, sizeof(pipeline_frame_t *))
+RTOS_SEMAPHORE_STORAGE(pipeline_trigger)
+RTOS_TASK_STORAGE(pipeline_capture_task, PIPELINE_TASK_STACK_SIZE)
+RTOS_TASK_STORAGE(pipeline_preprocess_task, PIPELINE_TASK_STACK_SIZE)
+RTOS_TASK_STORAGE(pipeline_inference_task, PIPELINE_TASK_STACK_SIZE)
+RTOS_TASK_STORAGE(pipeline_publish_task, PIPELINE_TASK_STACK_SIZE)
+static volatile bool pipeline_continuous;
+static volatile bool pipeline_preempt;
+static uint32_t pipeline_sequence;
+static pipeline_publish_t pipeline_publish_handler;
+
+static bool pipeline_capture(pipeline_frame_t *frame)
+{
+    if (!pipeline_continuous)
+    {
+        xSemaphoreTake(pipeline_trigger_handle, portMAX_DELAY);
+    }
+
+    if (!camera_capture_raw(frame->raw, sizeof(frame->raw)))
+    {
+        LOG_ERROR("pipeline capture failed");
+        return false;
+    }
+
+    frame->sequence = pipeline_sequence++;
+    return true;
+}
+
+static bool pipeline_preprocess(pipeline_frame_t *frame)
+{
+    image_preprocess_t context;
+
+    governor_token_t token = governor_enter(PERF_STAGE_PREPROCESS);
+    image_preprocess_init(&context, frame->tensor);
+    for (uint32_t row = 0; row < IMAGE_SOURCE_HEIGHT; row++)
+    {
+        image_preprocess_row(&context, &frame->raw[row * IMAGE_SOURCE_ROW_SIZE], IMAGE_SOURCE_ROW_SIZE);
+    }
+    image_preprocess_normalize(&context);
+    perf_record(PERF_STAGE_PREPROCESS, perf_elapsed_us(token.start));
+    governor_exit(PERF_STAGE_PREPROCESS, token);
+
+    // the frame being classified is now stale
+    if (pipeline_preempt)
+    {
+        tflm_cancel(pipeline_stages[PIPELINE_STAGE_INFERENCE].task);
+    }
+
+    return true;
+}
+
+static bool pipeline_inference(pipeline_frame_t *frame)
+{
+    governor_token_t token = governor_enter(PERF_STAGE_INFERENCE);
+    frame->count = 0;
+#if defined(TFLM_FRAME)
+    frame->value = tflm_read_digits(frame->tensor, sizeof(frame->tensor), &frame->digits);
+#else
+    frame->value = tflm_inference(frame->tensor, sizeof(frame->tensor), frame->scores, &frame->count);
+#endif
+    frame->ticks = tflm_inference_ticks();
+    perf_record(PERF_STAGE_INFERENCE, perf_elapsed_us(token.start));
+    governor_exit(PERF_STAGE_INFERENCE, token);
+
+    if (frame->value == TFLM_INFERENCE_CANCELLED)
+    {
+        pipeline_stages[PIPELINE_STAGE_INFERENCE].stats.cancelled++;
+        return false;
+    }
+
+    return true;
+}
+
+static bool pipeline_publish(pipeline_frame_t *frame)
+{
+    if (pipeline_publish_handler)
+    {
+        governor_token_t token = governor_enter(PERF_STAGE_REPORT);
+        pipeline_publish_handler(frame);
+        perf_record(PERF_STAGE_REPORT, perf_elapsed_us(token.start));
+        governor_exit(PERF_STAGE_REPORT, token);
+    }
+
+    return true;
+}
+
+static void pipeline_stage_task(void *parameter)
+{
+    pipeline_stage_t *stage = (pipeline_stage_t *)parameter;
+    pipeline_frame_t *frame;
+
+    logger_register_task();
+
+    while (1)
+    {
+        if (xQueueReceive(stage->input, &frame, 0) != pdPASS)
+        {
+            stage->stats.starved++;
+            xQueueReceive(stage->input, &frame, portMAX_DELAY);
+        }
+
+        uint32_t occupancy = uxQueueMessagesWaiting(stage->input);
+        stage->stats.occupancy = occupancy;
+        if (occupancy > stage->stats.high_water)
+        {
+            stage->stats.high_water = occupancy;
+        }
+
+        uint32_t start = perf_timestamp();
+        bool forward = stage->process(frame);
+        stage->stats.busy_us += perf_elapsed_us(start);
+
+        // a frame that failed goes straight back to the free queue
+        QueueHandle_t output = forward ? stage->output : pipeline_queues[PIPELINE_STAGE_CAPTURE];
+        if (forward)
+        {
+            stage->stats.frames++;
+        }
+
+        if (xQueueSend(output, &frame, 0) != pdPASS)
+        {
+            stage->stats.stalled++;
+            xQueueSend(output, &frame, portMAX_DELAY);
+        }
+    }
+}
+
+void pipeline_create(void)
+{
+    // the free queue can hold every frame so publish never blocks, which
+    // guarantees every other stage eventually drains
+    pipeline_queues[PIPELINE_STAGE_CAPTURE] =
+        RTOS_QUEUE_CREATE(pipeline_free, PIPELINE_FRAMES, sizeof(pipeline_frame_t *));
+    pipeline_queues[PIPELINE_STAGE_PREPROCESS] =
+        RTOS_QUEUE_CREATE(pipeline_preprocess_input, PIPELINE_QUEUE_DEPTH, sizeof(pipeline_frame_t *));
+    pipeline_queues[PIPELINE_STAGE_INFERENCE] =
+        RTOS_QUEUE_CREATE(pipeline_inference_input, PIPELINE_QUEUE_DEPTH, sizeof(pipeline_frame_t *));
+    pipeline_queues[PIPELINE_STAGE_PUBLISH] =
+        RTOS_QUEUE_CREATE(pipeline_publish_input, PIPELINE_QUEUE_DEPTH, sizeof(pipeline_frame_t *));
+
+    for (uint32_t i = 0; i < PIPELINE_FRAMES; i++)
+    {
+        pipeline_frame_t *frame = &pipeline_frames[i];
+        xQueueSend(pipeline_queues[PIPELINE_STAGE_CAPTURE], &frame, 0);
+    }
+
+    pipeline_trigger_handle = RTOS_BINARY_CREATE(pipeline_trigger);
+
+    for (uint32_t i = 0; i < PIPELINE_STAGE_MAX; i++)
+    {
+        pipeline_stage_t *stage = &pipeline_stages[i];
+        stage->input = pipeline_queues[i];
+        stage->output = pipeline_queues[(i + 1) % PIPELINE_STAGE_MAX];
+    }
+
+    pipeline_stage_t *stage = pipeline_stages;
+    RTOS_TASK_CREATE(pipeline_capture_task,
+                     pipeline_stage_task,
+                     stage->name,
+                     PIPELINE_TASK_STACK_SIZE,
+                     stage,
+                     stage->priority,
+                     &stage->task);
+    stage++;
+    RTOS_TASK_CREATE(pipeline_preprocess_task,
+                     pipeline_stage_task,
+                     stage->name,
+                     PIPELINE_TASK_STACK_SIZE,
+                     stage,
+                     stage->priority,
+                     &stage->task);
+    stage++;
+    RTOS_TASK_CREATE(pipeline_inference_task,
+                     pipeline_stage_task,
+                     stage->name,
+                     PIPELINE_TASK_STACK_SIZE,
+                     stage,
+                     stage->priority,
+                     &stage->task);
+    stage++;
+    RTOS_TASK_CREATE(pipeline_publish_task,
+                     pipeline_stage_task,
+                     stage->name,
+                     PIPELINE_TASK_STACK_SIZE,
+                     stage,
+                     stage->priority,
+                     &stage->task);
+
+    pipeline_cli_register();
+}
+
+void pipeline_set_publish(pipeline_publish_t handler)
+{
+    pipeline_publish_handler = handler;
+}
+
+void pipeline_trigger(void)
+{
+    xSemaphoreGive(pipeline_trigger_handle);
+}
+
+void pipeline_set_continuous(bool enable)
+{
+    pipeline_continuous = enable;
+    if (enable)
+    {
+        // release a capture stage waiting for a trigger
+        xSemaphoreGive(pipeline_trigger_handle);
+    }
+    else
+    {
+        xSemaphoreTake(pipeline_trigger_handle, 0);
+    }
+}
+
+bool pipeline_get_continuous(void)
+{
+    return pipeline_continuous;
+}
+
+void pipeline_set_preempt(bool enable)
+{
+    pipeline_preempt = enable;
+}
+
+bool pipeline_get_preempt(void)
+{
+    return pipeline_preempt;
+}
+
+const char *pipeline_stage_name(pipeline_stage_e stage)
+{
+    return (stage < PIPELINE_STAGE_MAX) ? pipeline_stages[stage].name : "unknown";
+}
+
+void pipeline_get_stats(pipeline_stage_e stage, pipeline_stage_stats_t *stats)
+{
+    if (stage >= PIPELINE_STAGE_MAX)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    *stats = pipeline_stages[stage].stats;
+    taskEXIT_CRITICAL();
+    stats->occupancy = uxQueueMessagesWaiting(pipeline_stages[stage].input);
+}
+
+void pipeline_reset(void)
+{
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < PIPELINE_STAGE_MAX; i++)
+    {
+        memset(&pipeline_stages[i].stats, 0, sizeof(pipeline_stages[i].stats));
+    }
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,134 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "digit_reader.h"
+#include "image_preprocess.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Frames in flight.  Every frame carries its own raw and tensor buffers, so
+// with two frames the capture of one overlaps the processing of the other.
+//
+#ifndef PIPELINE_FRAMES
+#define PIPELINE_FRAMES (2)
+#endif
+
+// depth of the queues between stages, the free queue holds every frame
+#ifndef PIPELINE_QUEUE_DEPTH
+#define PIPELINE_QUEUE_DEPTH (1)
+#endif
+
+#ifndef PIPELINE_CAPTURE_PRIORITY
+#define PIPELINE_CAPTURE_PRIORITY (2)
+#endif
+
+#ifndef PIPELINE_PREPROCESS_PRIORITY
+#define PIPELINE_PREPROCESS_PRIORITY (2)
+#endif
+
+#ifndef PIPELINE_INFERENCE_PRIORITY
+#define PIPELINE_INFERENCE_PRIORITY (1)
+#endif
+
+#ifndef PIPELINE_PUBLISH_PRIORITY
+#define PIPELINE_PUBLISH_PRIORITY (2)
+#endif
+
+#define PIPELINE_MAX_SCORES (16)
+
+typedef enum pipeline_stage_e
+{
+    PIPELINE_STAGE_CAPTURE,
+    PIPELINE_STAGE_PREPROCESS,
+    PIPELINE_STAGE_INFERENCE,
+    PIPELINE_STAGE_PUBLISH,
+    PIPELINE_STAGE_MAX
+} pipeline_stage_e;
+
+typedef struct pipeline_frame_s
+{
+    uint32_t sequence;
+    uint32_t value;
+    size_t count;
+    uint32_t ticks;
+    int8_t scores[PIPELINE_MAX_SCORES];
+#if defined(TFLM_FRAME)
+    digit_reader_result_t digits; // every digit read, value is how many
+#endif
+    uint8_t tensor[IMAGE_SIZE];
+    uint8_t raw[IMAGE_SOURCE_SIZE];
+} pipeline_frame_t;
+
+typedef struct pipeline_stage_stats_s
+{
+    uint32_t frames;     // frames the stage has finished
+    uint32_t occupancy;  // frames waiting in the input queue right now
+    uint32_t high_water; // most frames ever waiting in the input queue
+    uint32_t starved;    // times the stage found its input queue empty
+    uint32_t stalled;    // times the stage found its output queue full
+    uint32_t cancelled;  // frames dropped for a newer one, see pipeline_set_preempt()
+    uint64_t busy_us;    // time spent processing
+} pipeline_stage_stats_t;
+
+typedef void (*pipeline_publish_t)(const pipeline_frame_t *frame);
+
+extern void pipeline_create(void);
+extern void pipeline_set_publish(pipeline_publish_t handler);
+
+// capture a single frame, one trigger is latched while a capture is running
+extern void pipeline_trigger(void);
+// keep capturing for as long as a free frame is available
+extern void pipeline_set_continuous(bool enable);
+extern bool pipeline_get_continuous(void);
+// drop the frame being classified as soon as a newer one is preprocessed;
+// needs the inference to be cancellable (TFLM_AOT)
+extern void pipeline_set_preempt(bool enable);
+extern bool pipeline_get_preempt(void);
+
+extern const char *pipeline_stage_name(pipeline_stage_e stage);
+extern void pipeline_get_stats(pipeline_stage_e stage, pipeline_stage_stats_t *stats);
+extern void pipeline_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <FreeRTOS_CLI.h>
+
+#include "pipeline.h"
+#include "pipeline_cli.h"
+
+static portBASE_TYPE pipeline_cli_entry(char *pui8OutBuffer,
+                                        size_t ui32OutBufferLength,
+                                        const char *pui8Command);
+
+static CLI_Command_Definition_t pipeline_cli_definition = {
+    (const char *const) "pipe",
+    (const char *const) "pipe   :  Capture and Inference Pipeline.\r\n",
+    pipeline_cli_entry,
+    -1};
+
+void pipeline_cli_register()
+{
+    FreeRTOS_CLIRegisterCommand(&pipeline_cli_definition);
+}
+
+static void help(char *pui8OutBuffer, size_t argc, char **argv)
+{
+    strcat(pui8OutBuffer, "\r\nusage: pipe [command]\r\n");
+    strcat(pui8OutBuffer, "\r\n");
+    strcat(pui8OutBuffer, "supported commands are:\r\n");
+    strcat(pui8OutBuffer, "  trigger     capture and classify one frame\r\n");
+    strcat(pui8OutBuffer, "  continuous  capture frames back to back\r\n");
+    strcat(pui8OutBuffer, "  single      capture one frame per trigger\r\n");
+    strcat(pui8OutBuffer, "  preempt <on|off>\r\n");
+    strcat(pui8OutBuffer, "              drop the frame being classified when a newer\r\n");
+    strcat(pui8OutBuffer, "              one is ready, needs a TFLM_AOT build\r\n");
+    strcat(pui8OutBuffer, "  reset       clear the stage counters\r\n");
+    strcat(pui8OutBuffer, "\r\n");
+    strcat(pui8OutBuffer, "without a command the stage counters are shown\r\n");
+}
+
+static void show(void)
+{
+    pipeline_stage_stats_t stats;
+
+    am_util_stdio_printf("\r\nmode: %s%s, %d frames, queue depth %d\r\n",
+                         pipeline_get_continuous() ? "continuous" : "single",
+                         pipeline_get_preempt() ? " preempt" : "",
+                         PIPELINE_FRAMES,
+                         PIPELINE_QUEUE_DEPTH);
+    am_util_stdio_printf("stage        frames  queued  max  starved  stalled  cancelled  busy ms\r\n");
+    for (uint32_t stage = 0; stage < PIPELINE_STAGE_MAX; stage++)
+    {
+        pipeline_get_stats((pipeline_stage_e)stage, &stats);
+        am_util_stdio_printf("%-11s  %6d  %6d  %3d  %7d  %7d  %9d  %7d\r\n",
+                             pipeline_stage_name((pipeline_stage_e)stage),
+                             stats.frames,
+                             stats.occupancy,
+                             stats.high_water,
+                             stats.starved,
+                             stats.stalled,
+                             stats.cancelled,
+                             (uint32_t)(stats.busy_us / 1000));
+    }
+}
+
+portBASE_TYPE
+pipeline_cli_entry(char *pui8OutBuffer, size_t ui32OutBufferLength, const char *pui8Command)
+{
+    size_t argc;
+    char *argv[8];
+    char argz[128];
+
+    pui8OutBuffer[0] = 0;
+
+    strcpy(argz, pui8Command);
+    FreeRTOS_CLIExtractParameters(argz, &argc, argv);
+
+    if (argc < 2)
+    {
+        show();
+    }
+    else if (strcmp(argv[1], "help") == 0)
+    {
+        help(pui8OutBuffer, argc, argv);
+    }
+    else if (strcmp(argv[1], "trigger") == 0)
+    {
+        pipeline_trigger();
+    }
+    else if (strcmp(argv[1], "continuous") == 0)
+    {
+        pipeline_set_continuous(true);
+    }
+    else if (strcmp(argv[1], "single") == 0)
+    {
+        pipeline_set_continuous(false);
+    }
+    else if ((strcmp(argv[1], "preempt") == 0) && (argc > 2))
+    {
+        pipeline_set_preempt(strcmp(argv[2], "on") == 0);
+    }
+    else if (strcmp(argv[1], "reset") == 0)
+    {
+        pipeline_reset();
+    }
+
+    return pdFALSE;
+}
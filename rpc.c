@@ -0,0 +1,463 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <am_mcu_apollo.h>
+#include <am_util.h>
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <task.h>
+
+#include "tflm.h"
+
+#include "application_task.h"
+#include "console_task.h"
+#include "governor.h"
+#include "image_preprocess.h"
+#include "inference_task.h"
+#include "perf.h"
+#include "rpc.h"
+#include "rpc_protocol.h"
+#include "rtos_alloc.h"
+
+typedef enum
+{
+    RPC_STATE_SYNC,
+    RPC_STATE_HEADER,
+    RPC_STATE_PAYLOAD,
+} rpc_state_e;
+
+static rpc_state_e rpc_state;
+static uint8_t rpc_frame[RPC_MAX_FRAME];
+static uint16_t rpc_frame_received;
+static uint16_t rpc_frame_expected;
+
+static uint8_t rpc_response[RPC_MAX_FRAME];
+static SemaphoreHandle_t rpc_response_mutex;
+RTOS_SEMAPHORE_STORAGE(rpc_response)
+
+static uint8_t rpc_tensor[IMAGE_SIZE];
+static image_preprocess_t rpc_preprocess;
+static bool rpc_frame_complete;
+static uint32_t rpc_preprocess_ticks;
+static uint32_t rpc_preprocess_us;
+
+static volatile bool rpc_inference_pending;
+static uint8_t rpc_inference_sequence;
+static uint32_t rpc_inference_preprocess_ticks;
+
+static uint32_t rpc_crc_errors;
+
+static uint16_t rpc_get_u16(const uint8_t *buffer)
+{
+    return buffer[0] | (buffer[1] << 8);
+}
+
+static void rpc_put_u16(uint8_t *buffer, uint16_t value)
+{
+    buffer[0] = value & 0xFF;
+    buffer[1] = (value >> 8) & 0xFF;
+}
+
+static void rpc_send(uint8_t command, uint8_t sequence, const void *payload, size_t length)
+{
+    xSemaphoreTake(rpc_response_mutex, portMAX_DELAY);
+
+    rpc_response[0] = RPC_SYNC;
+    rpc_response[1] = RPC_PROTOCOL_VERSION;
+    rpc_response[2] = command | RPC_RESPONSE_FLAG;
+    rpc_response[3] = sequence;
+    rpc_put_u16(&rpc_response[4], length);
+    memcpy(&rpc_response[RPC_HEADER_SIZE], payload, length);
+
+    uint16_t crc = rpc_crc16(RPC_CRC_INIT, &rpc_response[1], RPC_HEADER_SIZE - 1 + length);
+    rpc_put_u16(&rpc_response[RPC_HEADER_SIZE + length], crc);
+
+    console_write(rpc_response, RPC_HEADER_SIZE + length + RPC_CRC_SIZE);
+
+    xSemaphoreGive(rpc_response_mutex);
+}
+
+static void rpc_send_status(uint8_t command, uint8_t sequence, rpc_status_e status)
+{
+    uint8_t payload = status;
+    rpc_send(command, sequence, &payload, 1);
+}
+
+static void rpc_command_info(uint8_t sequence)
+{
+    rpc_info_t info;
+    tflm_info_t model;
+
+    tflm_get_info(&model);
+
+    memset(&info, 0, sizeof(info));
+    info.status = RPC_STATUS_OK;
+    info.version = RPC_PROTOCOL_VERSION;
+    info.rows = model.rows;
+    info.columns = model.columns;
+    info.channels = model.channels;
+    info.categories = model.categories;
+    info.tensor_size = model.input_size;
+    info.frame_width = IMAGE_SOURCE_WIDTH;
+    info.frame_height = IMAGE_SOURCE_HEIGHT;
+    info.tick_rate_hz = configTICK_RATE_HZ;
+    memcpy(info.labels, model.labels, model.categories < sizeof(info.labels) ? model.categories : sizeof(info.labels));
+
+    rpc_send(RPC_COMMAND_INFO, sequence, &info, sizeof(info));
+}
+
+static rpc_status_e rpc_command_tensor_write(const uint8_t *payload, uint16_t length)
+{
+    if (length < 2)
+    {
+        return RPC_STATUS_INVALID_LENGTH;
+    }
+
+    uint16_t offset = rpc_get_u16(payload);
+    length -= 2;
+    if ((offset + length) > IMAGE_SIZE)
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+
+    memcpy(&rpc_tensor[offset], &payload[2], length);
+    rpc_frame_complete = false;
+
+    return RPC_STATUS_OK;
+}
+
+static rpc_status_e rpc_command_frame_write(const uint8_t *payload, uint16_t length)
+{
+    if ((length < 2) || (((length - 2) % IMAGE_SOURCE_ROW_SIZE) != 0))
+    {
+        return RPC_STATUS_INVALID_LENGTH;
+    }
+
+    uint16_t row = rpc_get_u16(payload);
+    uint16_t rows = (length - 2) / IMAGE_SOURCE_ROW_SIZE;
+
+    // rows must be streamed in order, starting a new frame at row 0.
+    if (row == 0)
+    {
+        image_preprocess_init(&rpc_preprocess, rpc_tensor);
+        rpc_frame_complete = false;
+        rpc_preprocess_ticks = 0;
+        rpc_preprocess_us = 0;
+    }
+    if ((row != rpc_preprocess.row) || ((row + rows) > IMAGE_SOURCE_HEIGHT))
+    {
+        return RPC_STATUS_OUT_OF_RANGE;
+    }
+
+    uint32_t start = xTaskGetTickCount();
+    governor_token_t token = governor_enter(PERF_STAGE_PREPROCESS);
+    for (uint16_t i = 0; i < rows; i++)
+    {
+        image_preprocess_row(
+            &rpc_preprocess, &payload[2 + i * IMAGE_SOURCE_ROW_SIZE], IMAGE_SOURCE_ROW_SIZE);
+    }
+    if (rpc_preprocess.row == IMAGE_SOURCE_HEIGHT)
+    {
+        image_preprocess_normalize(&rpc_preprocess);
+        rpc_frame_complete = true;
+    }
+    rpc_preprocess_ticks += xTaskGetTickCount() - start;
+    rpc_preprocess_us += perf_elapsed_us(token.start);
+    governor_exit(PERF_STAGE_PREPROCESS, token);
+    if (rpc_frame_complete)
+    {
+        perf_record(PERF_STAGE_PREPROCESS, rpc_preprocess_us);
+    }
+
+    return RPC_STATUS_OK;
+}
+
+static void rpc_command_tensor_read(uint8_t sequence, const uint8_t *payload, uint16_t length)
+{
+    uint8_t response[RPC_MAX_PAYLOAD];
+
+    if (length != 2)
+    {
+        rpc_send_status(RPC_COMMAND_TENSOR_READ, sequence, RPC_STATUS_INVALID_LENGTH);
+        return;
+    }
+
+    uint16_t offset = rpc_get_u16(payload);
+    if (offset >= IMAGE_SIZE)
+    {
+        rpc_send_status(RPC_COMMAND_TENSOR_READ, sequence, RPC_STATUS_OUT_OF_RANGE);
+        return;
+    }
+
+    size_t count = IMAGE_SIZE - offset;
+    if (count > (RPC_MAX_PAYLOAD - 1))
+    {
+        count = RPC_MAX_PAYLOAD - 1;
+    }
+
+    response[0] = RPC_STATUS_OK;
+    memcpy(&response[1], &rpc_tensor[offset], count);
+    rpc_send(RPC_COMMAND_TENSOR_READ, sequence, response, count + 1);
+}
+
+static void rpc_command_link_stats(uint8_t sequence)
+{
+    rpc_link_stats_t stats;
+    console_stats_t console;
+
+    console_get_stats(&console);
+
+    stats.status = RPC_STATUS_OK;
+    stats.rx_bytes = console.rx_bytes;
+    stats.rx_batches = console.rx_batches;
+    stats.rx_dropped = console.rx_dropped;
+    stats.rx_overruns = console.rx_overruns;
+    stats.crc_errors = rpc_crc_errors;
+
+    rpc_send(RPC_COMMAND_LINK_STATS, sequence, &stats, sizeof(stats));
+}
+
+static void rpc_inference_done(uint32_t value, const int8_t *scores, size_t count, uint32_t ticks)
+{
+    uint8_t response[sizeof(rpc_result_t) + 32];
+    rpc_result_t result;
+    tflm_info_t model;
+
+    tflm_get_info(&model);
+
+    if (count > (sizeof(response) - sizeof(result)))
+    {
+        count = sizeof(response) - sizeof(result);
+    }
+
+    memset(&result, 0, sizeof(result));
+    if ((value == INFERENCE_DROPPED) || (value == INFERENCE_STALE))
+    {
+        // never ran, the host can try again
+        result.status = RPC_STATUS_BUSY;
+    }
+    else
+    {
+        result.status = (value == TFLM_INFERENCE_FAILED) ? RPC_STATUS_INFERENCE_FAILED : RPC_STATUS_OK;
+    }
+    result.categories = count;
+    result.preprocess_ticks = rpc_inference_preprocess_ticks;
+    result.inference_ticks = ticks;
+
+    int max_score = -1;
+    for (size_t i = 0; i < count; i++)
+    {
+        if ((scores[i] + 128) >= max_score)
+        {
+            max_score = scores[i] + 128;
+            result.label = model.labels[i];
+        }
+    }
+    result.confidence = (max_score < 0) ? 0 : max_score;
+
+    memcpy(response, &result, sizeof(result));
+    memcpy(&response[sizeof(result)], scores, count);
+
+    rpc_send(RPC_COMMAND_INFER, rpc_inference_sequence, response, sizeof(result) + count);
+    rpc_inference_pending = false;
+}
+
+static void rpc_command_infer(uint8_t sequence, const uint8_t *payload, uint16_t length)
+{
+    if (length != 1)
+    {
+        rpc_send_status(RPC_COMMAND_INFER, sequence, RPC_STATUS_INVALID_LENGTH);
+        return;
+    }
+
+    if ((payload[0] == RPC_SOURCE_FRAME) && !rpc_frame_complete)
+    {
+        rpc_send_status(RPC_COMMAND_INFER, sequence, RPC_STATUS_OUT_OF_RANGE);
+        return;
+    }
+    else if ((payload[0] != RPC_SOURCE_FRAME) && (payload[0] != RPC_SOURCE_TENSOR))
+    {
+        rpc_send_status(RPC_COMMAND_INFER, sequence, RPC_STATUS_UNSUPPORTED);
+        return;
+    }
+
+    rpc_inference_pending = true;
+    rpc_inference_sequence = sequence;
+    rpc_inference_preprocess_ticks = (payload[0] == RPC_SOURCE_FRAME) ? rpc_preprocess_ticks : 0;
+    application_inference_submit(rpc_tensor, IMAGE_SIZE, rpc_inference_done);
+}
+
+static void rpc_dispatch(void)
+{
+    uint8_t version = rpc_frame[1];
+    uint8_t command = rpc_frame[2];
+    uint8_t sequence = rpc_frame[3];
+    uint16_t length = rpc_get_u16(&rpc_frame[4]);
+    const uint8_t *payload = &rpc_frame[RPC_HEADER_SIZE];
+
+    if (version != RPC_PROTOCOL_VERSION)
+    {
+        rpc_send_status(command, sequence, RPC_STATUS_UNSUPPORTED);
+        return;
+    }
+
+    // the staged tensor belongs to the application task until it reports back
+    if (rpc_inference_pending && (command != RPC_COMMAND_INFO) && (command != RPC_COMMAND_ECHO) &&
+        (command != RPC_COMMAND_LINK_STATS))
+    {
+        rpc_send_status(command, sequence, RPC_STATUS_BUSY);
+        return;
+    }
+
+    switch (command)
+    {
+    case RPC_COMMAND_INFO:
+        rpc_command_info(sequence);
+        break;
+
+    case RPC_COMMAND_TENSOR_WRITE:
+        rpc_send_status(command, sequence, rpc_command_tensor_write(payload, length));
+        break;
+
+    case RPC_COMMAND_FRAME_WRITE:
+        rpc_send_status(command, sequence, rpc_command_frame_write(payload, length));
+        break;
+
+    case RPC_COMMAND_INFER:
+        rpc_command_infer(sequence, payload, length);
+        break;
+
+    case RPC_COMMAND_TENSOR_READ:
+        rpc_command_tensor_read(sequence, payload, length);
+        break;
+
+    case RPC_COMMAND_ECHO:
+        rpc_send(command, sequence, payload, length);
+        break;
+
+    case RPC_COMMAND_LINK_STATS:
+        rpc_command_link_stats(sequence);
+        break;
+
+    default:
+        rpc_send_status(command, sequence, RPC_STATUS_UNSUPPORTED);
+        break;
+    }
+}
+
+//
+// The tensor most recently uploaded with TENSOR_WRITE or FRAME_WRITE.
+//
+const uint8_t *rpc_staged_tensor(void)
+{
+    return rpc_tensor;
+}
+
+void rpc_setup(void)
+{
+    rpc_state = RPC_STATE_SYNC;
+    rpc_frame_received = 0;
+    rpc_frame_complete = false;
+    rpc_inference_pending = false;
+    rpc_crc_errors = 0;
+    rpc_response_mutex = RTOS_MUTEX_CREATE(rpc_response);
+
+    console_register_binary_process(RPC_SYNC, rpc_process);
+}
+
+//
+// Feed one byte received by the console into the frame parser.  Returns true
+// while a frame is in progress so that the console keeps routing bytes here
+// instead of the command line interpreter.
+//
+bool rpc_process(int32_t ch)
+{
+    if (ch == CONSOLE_BINARY_TIMEOUT)
+    {
+        rpc_state = RPC_STATE_SYNC;
+        return false;
+    }
+
+    switch (rpc_state)
+    {
+    case RPC_STATE_SYNC:
+        if (ch != RPC_SYNC)
+        {
+            return false;
+        }
+        rpc_frame[0] = ch;
+        rpc_frame_received = 1;
+        rpc_state = RPC_STATE_HEADER;
+        break;
+
+    case RPC_STATE_HEADER:
+        rpc_frame[rpc_frame_received++] = ch;
+        if (rpc_frame_received == RPC_HEADER_SIZE)
+        {
+            uint16_t length = rpc_get_u16(&rpc_frame[4]);
+            if (length > RPC_MAX_PAYLOAD)
+            {
+                rpc_state = RPC_STATE_SYNC;
+                return false;
+            }
+            rpc_frame_expected = RPC_HEADER_SIZE + length + RPC_CRC_SIZE;
+            rpc_state = RPC_STATE_PAYLOAD;
+        }
+        break;
+
+    case RPC_STATE_PAYLOAD:
+        rpc_frame[rpc_frame_received++] = ch;
+        if (rpc_frame_received == rpc_frame_expected)
+        {
+            uint16_t length = rpc_frame_expected - RPC_HEADER_SIZE - RPC_CRC_SIZE;
+            uint16_t crc = rpc_crc16(RPC_CRC_INIT, &rpc_frame[1], RPC_HEADER_SIZE - 1 + length);
+
+            rpc_state = RPC_STATE_SYNC;
+            if (crc == rpc_get_u16(&rpc_frame[RPC_HEADER_SIZE + length]))
+            {
+                rpc_dispatch();
+            }
+            else
+            {
+                rpc_crc_errors++;
+            }
+            return false;
+        }
+        break;
+    }
+
+    return true;
+}
@@ -0,0 +1,170 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _RPC_PROTOCOL_H_
+#define _RPC_PROTOCOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Binary RPC framing shared between the firmware and the host tools.
+//
+// Every frame, in either direction, has the following layout (little endian):
+//
+//   +------+---------+---------+----------+--------+-----------+-------+
+//   | sync | version | command | sequence | length | payload   | crc16 |
+//   |  1   |    1    |    1    |    1     |   2    | length    |   2   |
+//   +------+---------+---------+----------+--------+-----------+-------+
+//
+// The sync byte is not a printable character so the console can tell an RPC
+// frame apart from CLI input when the command line is empty.  The CRC is a
+// CRC-16/CCITT-FALSE computed over version through the end of the payload.
+// Responses echo the sequence number and set RPC_RESPONSE_FLAG in command.
+//
+#define RPC_PROTOCOL_VERSION (1)
+
+#define RPC_SYNC            (0xA5)
+#define RPC_HEADER_SIZE     (6)
+#define RPC_CRC_SIZE        (2)
+#define RPC_MAX_PAYLOAD     (400)
+#define RPC_MAX_FRAME       (RPC_HEADER_SIZE + RPC_MAX_PAYLOAD + RPC_CRC_SIZE)
+#define RPC_RESPONSE_FLAG   (0x80)
+
+typedef enum rpc_command_e
+{
+    // payload: none
+    // response: rpc_info_t
+    RPC_COMMAND_INFO = 0x01,
+
+    // payload: uint16_t offset, followed by tensor bytes
+    // response: uint8_t status
+    RPC_COMMAND_TENSOR_WRITE = 0x02,
+
+    // payload: uint16_t first row, followed by whole RGB565 source rows
+    // response: uint8_t status
+    RPC_COMMAND_FRAME_WRITE = 0x03,
+
+    // payload: uint8_t source (rpc_source_e)
+    // response: rpc_result_t followed by the int8 output scores
+    RPC_COMMAND_INFER = 0x04,
+
+    // payload: uint16_t offset
+    // response: uint8_t status followed by up to RPC_MAX_PAYLOAD - 1 bytes
+    //           of the staged tensor starting at offset
+    RPC_COMMAND_TENSOR_READ = 0x05,
+
+    // payload: any bytes
+    // response: the same bytes, used to measure link throughput
+    RPC_COMMAND_ECHO = 0x06,
+
+    // payload: none
+    // response: rpc_link_stats_t
+    RPC_COMMAND_LINK_STATS = 0x07,
+} rpc_command_e;
+
+typedef enum rpc_source_e
+{
+    RPC_SOURCE_TENSOR = 0,
+    RPC_SOURCE_FRAME = 1,
+} rpc_source_e;
+
+typedef enum rpc_status_e
+{
+    RPC_STATUS_OK = 0,
+    RPC_STATUS_UNSUPPORTED = 1,
+    RPC_STATUS_INVALID_LENGTH = 2,
+    RPC_STATUS_OUT_OF_RANGE = 3,
+    RPC_STATUS_BUSY = 4,
+    RPC_STATUS_INFERENCE_FAILED = 5,
+} rpc_status_e;
+
+#pragma pack(push, 1)
+typedef struct rpc_info_s
+{
+    uint8_t status;
+    uint8_t version;
+    uint8_t rows;
+    uint8_t columns;
+    uint8_t channels;
+    uint8_t categories;
+    uint16_t tensor_size;
+    uint16_t frame_width;
+    uint16_t frame_height;
+    uint32_t tick_rate_hz;
+    char labels[16];
+} rpc_info_t;
+
+typedef struct rpc_result_s
+{
+    uint8_t status;
+    uint8_t label;
+    uint8_t confidence;
+    uint8_t categories;
+    uint32_t preprocess_ticks;
+    uint32_t inference_ticks;
+} rpc_result_t;
+
+typedef struct rpc_link_stats_s
+{
+    uint8_t status;
+    uint32_t rx_bytes;
+    uint32_t rx_batches;
+    uint32_t rx_dropped;
+    uint32_t rx_overruns;
+    uint32_t crc_errors;
+} rpc_link_stats_t;
+#pragma pack(pop)
+
+static inline uint16_t rpc_crc16(uint16_t crc, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+#define RPC_CRC_INIT (0xFFFF)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _RTOS_ALLOC_H_
+#define _RTOS_ALLOC_H_
+
+//
+// Creation of FreeRTOS objects.  With STATIC_ALLOCATION defined every object
+// gets its buffers from a static declared next to it, so the objects show up
+// in the RAM budget printed after the build and none of them come out of
+// configTOTAL_HEAP_SIZE.  Otherwise the usual heap allocating functions are
+// used.
+//
+// The *_STORAGE macros declare the buffers at file scope and the *_CREATE
+// macros take the same name.
+//
+
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <semphr.h>
+#include <stream_buffer.h>
+#include <task.h>
+#include <timers.h>
+
+#if defined(STATIC_ALLOCATION)
+
+#if (configSUPPORT_STATIC_ALLOCATION != 1)
+#error "STATIC_ALLOCATION requires configSUPPORT_STATIC_ALLOCATION in FreeRTOSConfig.h"
+#endif
+
+#define RTOS_TASK_STORAGE(name, depth)                                                             \
+    static StackType_t name##_stack[depth];                                                        \
+    static StaticTask_t name##_tcb;
+
+#define RTOS_TASK_CREATE(name, code, label, depth, parameter, priority, handle)                    \
+    (*(handle) = xTaskCreateStatic(                                                                \
+         code, label, depth, parameter, priority, name##_stack, &name##_tcb))
+
+#define RTOS_QUEUE_STORAGE(name, length, size)                                                     \
+    static uint8_t name##_storage[(length) * (size)];                                              \
+    static StaticQueue_t name##_queue;
+
+#define RTOS_QUEUE_CREATE(name, length, size)                                                      \
+    xQueueCreateStatic(length, size, name##_storage, &name##_queue)
+
+#define RTOS_TIMER_STORAGE(name) static StaticTimer_t name##_timer;
+
+#define RTOS_TIMER_CREATE(name, label, period, reload, id, callback)                               \
+    xTimerCreateStatic(label, period, reload, id, callback, &name##_timer)
+
+#define RTOS_SEMAPHORE_STORAGE(name) static StaticSemaphore_t name##_semaphore;
+
+#define RTOS_MUTEX_CREATE(name)  xSemaphoreCreateMutexStatic(&name##_semaphore)
+#define RTOS_BINARY_CREATE(name) xSemaphoreCreateBinaryStatic(&name##_semaphore)
+
+// a stream buffer needs one byte more than its capacity
+#define RTOS_STREAM_BUFFER_STORAGE(name, size)                                                     \
+    static uint8_t name##_storage[(size) + 1];                                                     \
+    static StaticStreamBuffer_t name##_stream;
+
+#define RTOS_STREAM_BUFFER_CREATE(name, size, trigger)                                             \
+    xStreamBufferCreateStatic(size, trigger, name##_storage, &name##_stream)
+
+#else
+
+#define RTOS_TASK_STORAGE(name, depth)
+#define RTOS_TASK_CREATE(name, code, label, depth, parameter, priority, handle)                    \
+    xTaskCreate(code, label, depth, parameter, priority, handle)
+
+#define RTOS_QUEUE_STORAGE(name, length, size)
+#define RTOS_QUEUE_CREATE(name, length, size) xQueueCreate(length, size)
+
+#define RTOS_TIMER_STORAGE(name)
+#define RTOS_TIMER_CREATE(name, label, period, reload, id, callback)                               \
+    xTimerCreate(label, period, reload, id, callback)
+
+#define RTOS_SEMAPHORE_STORAGE(name)
+#define RTOS_MUTEX_CREATE(name)  xSemaphoreCreateMutex()
+#define RTOS_BINARY_CREATE(name) xSemaphoreCreateBinary()
+
+#define RTOS_STREAM_BUFFER_STORAGE(name, size)
+#define RTOS_STREAM_BUFFER_CREATE(name, size, trigger) xStreamBufferCreate(size, trigger)
+
+#endif
+
+#endif
@@ -0,0 +1,480 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <string.h>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/add.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/mul.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/pooling.h"
+#include "tensorflow/lite/kernels/internal/reference/softmax.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+#if defined(AOT_CMSIS_NN)
+#include "arm_nnfunctions.h"
+#include "arm_nnsupportfunctions.h"
+#endif
+
+#include "aot_kernels.h"
+
+// The interpreter runs the CMSIS-NN kernels on the target and the reference
+// kernels everywhere else; the compiled model calls the same ones. Broadcast
+// add and multiply always use the reference arithmetic in the interpreter.
+
+namespace
+{
+#if defined(AOT_CMSIS_NN)
+// im2col buffer of the convolutions, checked against what each layer needs
+#ifndef AOT_SCRATCH_SIZE
+#define AOT_SCRATCH_SIZE 4096
+#endif
+alignas(4) int8_t scratch[AOT_SCRATCH_SIZE];
+
+// ARM_MATH_SUCCESS or ARM_CMSIS_NN_SUCCESS depending on the CMSIS-NN release
+constexpr int kCmsisSuccess = 0;
+#endif
+
+// Dot product of a packed filter row with groups x 4 input channels, starting
+// at the given group of the filter.
+inline int32_t sparse_dot(const int8_t *filter, const uint8_t *positions, uint32_t group,
+                          uint32_t groups, const int8_t *input, int32_t input_offset)
+{
+    const int8_t *weights = &filter[group * 2];
+    int32_t acc = 0;
+
+    for (uint32_t i = 0; i < groups; i++, group++, input += 4, weights += 2)
+    {
+        uint32_t nibble = positions[group >> 1] >> ((group & 1) * 4);
+        acc += weights[0] * (input[nibble & 3] + input_offset);
+        acc += weights[1] * (input[(nibble >> 2) & 3] + input_offset);
+    }
+    return acc;
+}
+
+// Transformed input tile of aot_winograd_conv(), 16 x input depth
+int16_t winograd_tile[16 * AOT_WINOGRAD_MAX_DEPTH];
+
+// B^T d B of the 4x4 input patch at (in_y, in_x) for every channel; the
+// padding is zero after the input offset, which leaves it out of the sums the
+// way the reference kernel skips it.
+void winograd_input(const aot_conv_t *conv, const int8_t *input, int32_t in_y, int32_t in_x)
+{
+    const int32_t depth = conv->input_depth;
+
+    for (int32_t channel = 0; channel < depth; channel++)
+    {
+        int32_t d[4][4];
+        for (int32_t row = 0; row < 4; row++)
+        {
+            for (int32_t col = 0; col < 4; col++)
+            {
+                const int32_t y = in_y + row;
+                const int32_t x = in_x + col;
+                d[row][col] = ((y < 0) || (y >= conv->input_height) || (x < 0) || (x >= conv->input_width))
+                                  ? 0
+                                  : input[(y * conv->input_width + x) * depth + channel] + conv->input_offset;
+            }
+        }
+
+        int32_t t[4][4];
+        for (int32_t col = 0; col < 4; col++)
+        {
+            t[0][col] = d[0][col] - d[2][col];
+            t[1][col] = d[1][col] + d[2][col];
+            t[2][col] = d[2][col] - d[1][col];
+            t[3][col] = d[1][col] - d[3][col];
+        }
+
+        int16_t *v = &winograd_tile[channel];
+        for (int32_t row = 0; row < 4; row++, v += 4 * depth)
+        {
+            v[0 * depth] = (int16_t)(t[row][0] - t[row][2]);
+            v[1 * depth] = (int16_t)(t[row][1] + t[row][2]);
+            v[2 * depth] = (int16_t)(t[row][2] - t[row][1]);
+            v[3 * depth] = (int16_t)(t[row][1] - t[row][3]);
+        }
+    }
+}
+
+inline int32_t winograd_dot(const int16_t *u, const int16_t *v, int32_t depth)
+{
+    int32_t acc = 0;
+    int32_t channel = 0;
+#if defined(AOT_CMSIS_NN) && defined(ARM_MATH_DSP)
+    for (; (channel + 1) < depth; channel += 2)
+    {
+        int32_t u2, v2;
+        memcpy(&u2, &u[channel], sizeof(u2));
+        memcpy(&v2, &v[channel], sizeof(v2));
+        acc = __SMLAD(u2, v2, acc);
+    }
+#endif
+    for (; channel < depth; channel++)
+    {
+        acc += u[channel] * v[channel];
+    }
+    return acc;
+}
+
+inline int8_t requantize(int32_t acc, int32_t multiplier, int32_t shift, int32_t offset,
+                         int32_t activation_min, int32_t activation_max)
+{
+    acc = tflite::MultiplyByQuantizedMultiplier(acc, multiplier, shift) + offset;
+    acc = (acc < activation_min) ? activation_min : acc;
+    acc = (acc > activation_max) ? activation_max : acc;
+    return (int8_t)acc;
+}
+} // namespace
+
+bool aot_conv(const aot_conv_t *conv, const int8_t *input, int8_t *output)
+{
+#if defined(AOT_CMSIS_NN)
+    cmsis_nn_conv_params params;
+    params.input_offset = conv->input_offset;
+    params.output_offset = conv->output_offset;
+    params.stride.h = conv->stride_height;
+    params.stride.w = conv->stride_width;
+    params.padding.h = conv->padding_height;
+    params.padding.w = conv->padding_width;
+    params.dilation.h = conv->dilation_height;
+    params.dilation.w = conv->dilation_width;
+    params.activation.min = conv->activation_min;
+    params.activation.max = conv->activation_max;
+
+    cmsis_nn_per_channel_quant_params quant = {const_cast<int32_t *>(conv->multiplier),
+                                               const_cast<int32_t *>(conv->shift)};
+    cmsis_nn_dims input_dims = {1, conv->input_height, conv->input_width, conv->input_depth};
+    cmsis_nn_dims filter_dims = {conv->output_depth, conv->filter_height, conv->filter_width,
+                                 conv->input_depth};
+    cmsis_nn_dims bias_dims = {1, 1, 1, conv->output_depth};
+    cmsis_nn_dims output_dims = {1, conv->output_height, conv->output_width, conv->output_depth};
+
+    cmsis_nn_context context = {scratch, sizeof(scratch)};
+    if (arm_convolve_wrapper_s8_get_buffer_size(&params, &input_dims, &filter_dims, &output_dims) >
+        (int32_t)sizeof(scratch))
+    {
+        return false;
+    }
+
+    return arm_convolve_wrapper_s8(&context, &params, &quant, &input_dims, input, &filter_dims,
+                                   conv->filter, &bias_dims, conv->bias, &output_dims,
+                                   output) == kCmsisSuccess;
+#else
+    tflite::ConvParams params = {};
+    params.padding_type = tflite::PaddingType::kSame;
+    params.padding_values.height = conv->padding_height;
+    params.padding_values.width = conv->padding_width;
+    params.stride_height = conv->stride_height;
+    params.stride_width = conv->stride_width;
+    params.dilation_height_factor = conv->dilation_height;
+    params.dilation_width_factor = conv->dilation_width;
+    params.input_offset = conv->input_offset;
+    params.weights_offset = 0;
+    params.output_offset = conv->output_offset;
+    params.quantized_activation_min = conv->activation_min;
+    params.quantized_activation_max = conv->activation_max;
+
+    tflite::reference_integer_ops::ConvPerChannel(
+        params, conv->multiplier, conv->shift,
+        tflite::RuntimeShape({1, conv->input_height, conv->input_width, conv->input_depth}), input,
+        tflite::RuntimeShape({conv->output_depth, conv->filter_height, conv->filter_width,
+                              conv->input_depth}),
+        conv->filter, tflite::RuntimeShape({conv->output_depth}), conv->bias,
+        tflite::RuntimeShape({1, conv->output_height, conv->output_width, conv->output_depth}),
+        output);
+    return true;
+#endif
+}
+
+bool aot_fully_connected(const aot_fully_connected_t *fc, const int8_t *input, int8_t *output)
+{
+#if defined(AOT_CMSIS_NN)
+    cmsis_nn_fc_params params;
+    params.input_offset = fc->input_offset;
+    params.filter_offset = fc->filter_offset;
+    params.output_offset = fc->output_offset;
+    params.activation.min = fc->activation_min;
+    params.activation.max = fc->activation_max;
+
+    cmsis_nn_per_tensor_quant_params quant = {fc->multiplier, fc->shift};
+    cmsis_nn_dims input_dims = {1, 1, 1, fc->input_size};
+    cmsis_nn_dims filter_dims = {fc->input_size, 1, 1, fc->output_size};
+    cmsis_nn_dims bias_dims = {1, 1, 1, fc->output_size};
+    cmsis_nn_dims output_dims = {1, 1, 1, fc->output_size};
+    cmsis_nn_context context = {scratch, sizeof(scratch)};
+
+    return arm_fully_connected_s8(&context, &params, &quant, &input_dims, input, &filter_dims,
+                                  fc->filter, &bias_dims, fc->bias, &output_dims,
+                                  output) == kCmsisSuccess;
+#else
+    tflite::FullyConnectedParams params = {};
+    params.input_offset = fc->input_offset;
+    params.weights_offset = fc->filter_offset;
+    params.output_offset = fc->output_offset;
+    params.output_multiplier = fc->multiplier;
+    params.output_shift = fc->shift;
+    params.quantized_activation_min = fc->activation_min;
+    params.quantized_activation_max = fc->activation_max;
+
+    tflite::reference_integer_ops::FullyConnected(
+        params, tflite::RuntimeShape({1, fc->input_size}), input,
+        tflite::RuntimeShape({fc->output_size, fc->input_size}), fc->filter,
+        tflite::RuntimeShape({fc->output_size}), fc->bias,
+        tflite::RuntimeShape({1, fc->output_size}), output);
+    return true;
+#endif
+}
+
+// Half the multiplies of the dense kernels and 5/8 of the filter bytes, but
+// without the SIMD multiply-accumulates CMSIS-NN uses; the input depth must be
+// a multiple of four.  Padding is skipped, as in the reference kernel.
+bool aot_sparse_conv(const aot_conv_t *conv, const int8_t *input, int8_t *output)
+{
+    const uint32_t groups = conv->input_depth / 4;
+
+    for (int32_t out_y = 0; out_y < conv->output_height; out_y++)
+    {
+        for (int32_t out_x = 0; out_x < conv->output_width; out_x++)
+        {
+            const int32_t in_y0 = out_y * conv->stride_height - conv->padding_height;
+            const int32_t in_x0 = out_x * conv->stride_width - conv->padding_width;
+
+            for (uint32_t channel = 0; channel < conv->output_depth; channel++)
+            {
+                int32_t acc = 0;
+                for (int32_t filter_y = 0; filter_y < conv->filter_height; filter_y++)
+                {
+                    const int32_t in_y = in_y0 + filter_y * conv->dilation_height;
+                    if ((in_y < 0) || (in_y >= conv->input_height))
+                    {
+                        continue;
+                    }
+
+                    for (int32_t filter_x = 0; filter_x < conv->filter_width; filter_x++)
+                    {
+                        const int32_t in_x = in_x0 + filter_x * conv->dilation_width;
+                        if ((in_x < 0) || (in_x >= conv->input_width))
+                        {
+                            continue;
+                        }
+
+                        const uint32_t group =
+                            ((channel * conv->filter_height + filter_y) * conv->filter_width +
+                             filter_x) * groups;
+                        acc += sparse_dot(conv->filter, conv->positions, group, groups,
+                                          &input[(in_y * conv->input_width + in_x) * conv->input_depth],
+                                          conv->input_offset);
+                    }
+                }
+
+                *output++ = requantize(acc + conv->bias[channel], conv->multiplier[channel],
+                                       conv->shift[channel], conv->output_offset,
+                                       conv->activation_min, conv->activation_max);
+            }
+        }
+    }
+    return true;
+}
+
+// Each 2x2 block of outputs takes 16 multiplies per input channel instead of
+// 36.  The transformed filter is four times G g G^T, so the result of A^T M A
+// is four times the convolution and divides exactly.
+bool aot_winograd_conv(const aot_conv_t *conv, const int8_t *input, int8_t *output)
+{
+    const int32_t depth = conv->input_depth;
+    if (depth > AOT_WINOGRAD_MAX_DEPTH)
+    {
+        return false;
+    }
+
+    for (int32_t out_y = 0; out_y < conv->output_height; out_y += 2)
+    {
+        for (int32_t out_x = 0; out_x < conv->output_width; out_x += 2)
+        {
+            winograd_input(conv, input, out_y - conv->padding_height, out_x - conv->padding_width);
+
+            for (int32_t channel = 0; channel < conv->output_depth; channel++)
+            {
+                const int16_t *u = &conv->winograd[channel * 16 * depth];
+                int32_t m[16];
+                for (int32_t k = 0; k < 16; k++)
+                {
+                    m[k] = winograd_dot(&u[k * depth], &winograd_tile[k * depth], depth);
+                }
+
+                int32_t t[2][4];
+                for (int32_t col = 0; col < 4; col++)
+                {
+                    t[0][col] = m[col] + m[4 + col] + m[8 + col];
+                    t[1][col] = m[4 + col] - m[8 + col] - m[12 + col];
+                }
+
+                for (int32_t row = 0; row < 2; row++)
+                {
+                    const int32_t y[2] = {t[row][0] + t[row][1] + t[row][2],
+                                          t[row][1] - t[row][2] - t[row][3]};
+                    for (int32_t col = 0; col < 2; col++)
+                    {
+                        if (((out_y + row) >= conv->output_height) || ((out_x + col) >= conv->output_width))
+                        {
+                            continue;
+                        }
+                        output[((out_y + row) * conv->output_width + out_x + col) * conv->output_depth +
+                               channel] = requantize((y[col] >> 2) + conv->bias[channel],
+                                                     conv->multiplier[channel], conv->shift[channel],
+                                                     conv->output_offset, conv->activation_min,
+                                                     conv->activation_max);
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// The filter must be symmetric (filter_offset 0) so that pruned weights are 0.
+bool aot_sparse_fully_connected(const aot_fully_connected_t *fc, const int8_t *input, int8_t *output)
+{
+    const uint32_t groups = fc->input_size / 4;
+
+    for (uint32_t unit = 0; unit < fc->output_size; unit++)
+    {
+        int32_t acc = sparse_dot(fc->filter, fc->positions, unit * groups, groups, input,
+                                 fc->input_offset);
+        acc += (fc->bias != nullptr) ? fc->bias[unit] : 0;
+        output[unit] = requantize(acc, fc->multiplier, fc->shift, fc->output_offset,
+                                  fc->activation_min, fc->activation_max);
+    }
+    return true;
+}
+
+bool aot_max_pool(const aot_pool_t *pool, const int8_t *input, int8_t *output)
+{
+#if defined(AOT_CMSIS_NN)
+    cmsis_nn_pool_params params;
+    params.stride.h = pool->stride_height;
+    params.stride.w = pool->stride_width;
+    params.padding.h = pool->padding_height;
+    params.padding.w = pool->padding_width;
+    params.activation.min = pool->activation_min;
+    params.activation.max = pool->activation_max;
+
+    cmsis_nn_dims input_dims = {1, pool->input_height, pool->input_width, pool->depth};
+    cmsis_nn_dims filter_dims = {1, pool->filter_height, pool->filter_width, 1};
+    cmsis_nn_dims output_dims = {1, pool->output_height, pool->output_width, pool->depth};
+    cmsis_nn_context context = {nullptr, 0};
+
+    return arm_max_pool_s8(&context, &params, &input_dims, input, &filter_dims, &output_dims,
+                           output) == kCmsisSuccess;
+#else
+    tflite::PoolParams params = {};
+    params.padding_values.height = pool->padding_height;
+    params.padding_values.width = pool->padding_width;
+    params.stride_height = pool->stride_height;
+    params.stride_width = pool->stride_width;
+    params.filter_height = pool->filter_height;
+    params.filter_width = pool->filter_width;
+    params.quantized_activation_min = pool->activation_min;
+    params.quantized_activation_max = pool->activation_max;
+
+    tflite::reference_integer_ops::MaxPool(
+        params, tflite::RuntimeShape({1, pool->input_height, pool->input_width, pool->depth}),
+        input, tflite::RuntimeShape({1, pool->output_height, pool->output_width, pool->depth}),
+        output);
+    return true;
+#endif
+}
+
+// A per channel input 2 is applied one pixel at a time, which gives the same
+// result as the broadcast kernels without their index arithmetic.
+bool aot_add(const aot_add_t *add, const int8_t *input1, const int8_t *input2, int8_t *output)
+{
+    tflite::ArithmeticParams params = {};
+    params.input1_offset = add->input1_offset;
+    params.input2_offset = add->input2_offset;
+    params.output_offset = add->output_offset;
+    params.left_shift = add->left_shift;
+    params.input1_multiplier = add->input1_multiplier;
+    params.input1_shift = add->input1_shift;
+    params.input2_multiplier = add->input2_multiplier;
+    params.input2_shift = add->input2_shift;
+    params.output_multiplier = add->output_multiplier;
+    params.output_shift = add->output_shift;
+    params.quantized_activation_min = add->activation_min;
+    params.quantized_activation_max = add->activation_max;
+
+    const tflite::RuntimeShape shape({(int32_t)add->input2_size});
+    for (uint32_t offset = 0; offset < add->size; offset += add->input2_size)
+    {
+        tflite::reference_integer_ops::Add(params, shape, input1 + offset, shape, input2, shape,
+                                           output + offset);
+    }
+    return true;
+}
+
+bool aot_mul(const aot_mul_t *mul, const int8_t *input1, const int8_t *input2, int8_t *output)
+{
+    tflite::ArithmeticParams params = {};
+    params.input1_offset = mul->input1_offset;
+    params.input2_offset = mul->input2_offset;
+    params.output_offset = mul->output_offset;
+    params.output_multiplier = mul->output_multiplier;
+    params.output_shift = mul->output_shift;
+    params.quantized_activation_min = mul->activation_min;
+    params.quantized_activation_max = mul->activation_max;
+
+    const tflite::RuntimeShape shape({(int32_t)mul->input2_size});
+    for (uint32_t offset = 0; offset < mul->size; offset += mul->input2_size)
+    {
+        tflite::reference_integer_ops::Mul(params, shape, input1 + offset, shape, input2, shape,
+                                           output + offset);
+    }
+    return true;
+}
+
+bool aot_softmax(const aot_softmax_t *softmax, const int8_t *input, int8_t *output)
+{
+#if defined(AOT_CMSIS_NN)
+    arm_softmax_s8(input, softmax->rows, softmax->depth, softmax->input_multiplier,
+                   softmax->input_left_shift, softmax->diff_min, output);
+#else
+    tflite::SoftmaxParams params = {};
+    params.input_multiplier = softmax->input_multiplier;
+    params.input_left_shift = softmax->input_left_shift;
+    params.diff_min = softmax->diff_min;
+
+    const tflite::RuntimeShape shape({softmax->rows, softmax->depth});
+    tflite::reference_ops::Softmax(params, shape, input, shape, output);
+#endif
+    return true;
+}
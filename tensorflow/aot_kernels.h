@@ -0,0 +1,178 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _AOT_KERNELS_H_
+#define _AOT_KERNELS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Layers of a model compiled by tools/tflm_aot.py. The parameters are the ones
+// the interpreter computes when it prepares each operator, so the results are
+// bit exact with it. Activations are NHWC with a batch of one.
+//
+// A filter pruned to at most two non-zero weights in every four consecutive
+// input channels (2:4 structured sparsity) can be stored packed.  Each group of
+// four then keeps two weights in filter and their positions in a nibble of
+// positions, first | second << 2, the even group in the low nibble.  Packed
+// layers are run by aot_sparse_conv() and aot_sparse_fully_connected().
+//
+// A 3x3 convolution with a stride and dilation of 1 can instead carry its
+// filter transformed for Winograd F(2x2, 3x3), (2G) g (2G)^T for each output
+// and input channel, and be run by aot_winograd_conv().  The arithmetic is
+// exact, so the results are the same as the direct convolution; the generator
+// only transforms layers whose sums cannot overflow.
+#ifndef AOT_WINOGRAD_MAX_DEPTH
+#define AOT_WINOGRAD_MAX_DEPTH 64
+#endif
+
+typedef struct
+{
+    uint16_t input_height;
+    uint16_t input_width;
+    uint16_t input_depth;
+    uint16_t filter_height;
+    uint16_t filter_width;
+    uint16_t output_height;
+    uint16_t output_width;
+    uint16_t output_depth;
+    uint8_t stride_height;
+    uint8_t stride_width;
+    uint8_t dilation_height;
+    uint8_t dilation_width;
+    uint8_t padding_height;
+    uint8_t padding_width;
+    int8_t activation_min;
+    int8_t activation_max;
+    int32_t input_offset;
+    int32_t output_offset;
+    const int8_t *filter;       // output_depth x filter_height x filter_width x input_depth
+    const uint8_t *positions;   // of the packed filter, nullptr when dense
+    const int16_t *winograd;    // output_depth x 16 x input_depth, or nullptr
+    const int32_t *bias;
+    const int32_t *multiplier;  // per output channel
+    const int32_t *shift;
+} aot_conv_t;
+
+typedef struct
+{
+    uint16_t input_size;
+    uint16_t output_size;
+    int8_t activation_min;
+    int8_t activation_max;
+    int32_t input_offset;
+    int32_t filter_offset;
+    int32_t output_offset;
+    int32_t multiplier;
+    int32_t shift;
+    const int8_t *filter;       // output_size x input_size
+    const uint8_t *positions;   // of the packed filter, nullptr when dense
+    const int32_t *bias;
+} aot_fully_connected_t;
+
+typedef struct
+{
+    uint16_t input_height;
+    uint16_t input_width;
+    uint16_t depth;
+    uint16_t filter_height;
+    uint16_t filter_width;
+    uint16_t output_height;
+    uint16_t output_width;
+    uint8_t stride_height;
+    uint8_t stride_width;
+    uint8_t padding_height;
+    uint8_t padding_width;
+    int8_t activation_min;
+    int8_t activation_max;
+} aot_pool_t;
+
+// Input 2 has either as many values as input 1 or one per channel
+typedef struct
+{
+    uint32_t size;
+    uint32_t input2_size;
+    int8_t activation_min;
+    int8_t activation_max;
+    int32_t input1_offset;
+    int32_t input2_offset;
+    int32_t output_offset;
+    int32_t left_shift;
+    int32_t input1_multiplier;
+    int32_t input1_shift;
+    int32_t input2_multiplier;
+    int32_t input2_shift;
+    int32_t output_multiplier;
+    int32_t output_shift;
+} aot_add_t;
+
+typedef struct
+{
+    uint32_t size;
+    uint32_t input2_size;
+    int8_t activation_min;
+    int8_t activation_max;
+    int32_t input1_offset;
+    int32_t input2_offset;
+    int32_t output_offset;
+    int32_t output_multiplier;
+    int32_t output_shift;
+} aot_mul_t;
+
+typedef struct
+{
+    uint16_t rows;
+    uint16_t depth;
+    int32_t input_multiplier;
+    int32_t input_left_shift;
+    int32_t diff_min;
+} aot_softmax_t;
+
+extern bool aot_conv(const aot_conv_t *conv, const int8_t *input, int8_t *output);
+extern bool aot_fully_connected(const aot_fully_connected_t *fc, const int8_t *input, int8_t *output);
+extern bool aot_sparse_conv(const aot_conv_t *conv, const int8_t *input, int8_t *output);
+extern bool aot_winograd_conv(const aot_conv_t *conv, const int8_t *input, int8_t *output);
+extern bool aot_sparse_fully_connected(const aot_fully_connected_t *fc, const int8_t *input, int8_t *output);
+extern bool aot_max_pool(const aot_pool_t *pool, const int8_t *input, int8_t *output);
+extern bool aot_add(const aot_add_t *add, const int8_t *input1, const int8_t *input2, int8_t *output);
+extern bool aot_mul(const aot_mul_t *mul, const int8_t *input1, const int8_t *input2, int8_t *output);
+extern bool aot_softmax(const aot_softmax_t *softmax, const int8_t *input, int8_t *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
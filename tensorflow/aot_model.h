@@ -0,0 +1,80 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _AOT_MODEL_H_
+#define _AOT_MODEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Implemented by the source tools/tflm_aot.py generates from the model
+typedef struct aot_model_info_s
+{
+    uint32_t input_size;
+    uint32_t output_size;
+    uint32_t arena_size;      // activations, planned when the code is generated
+    uint32_t constant_size;   // weights, biases and quantization parameters
+    uint32_t model_size;      // flatbuffer the code was generated from
+    uint32_t layers;
+    uint32_t exits;           // outputs, the last one is the full model
+    const uint32_t *exit_layers; // layers run up to and including each exit
+    uint32_t grid_rows;       // windows scored by a frame model (--frame), one
+    uint32_t grid_columns;    // after the other in the output; 1 x 1 otherwise
+    uint32_t grid_stride;     // pixels from one window to the next
+} aot_model_info_t;
+
+extern const aot_model_info_t aot_model_info;
+
+// The input and output live in the arena; the output is valid until the input
+// is written again.
+extern int8_t *aot_model_input(void);
+extern const int8_t *aot_model_output(void);
+extern bool aot_model_invoke(void);
+
+// Nothing in the arena is needed from one inference to the next.
+extern int8_t *aot_model_arena(void);
+
+// Run the layers one at a time, in order from 0 after the input is written;
+// the layers up to exit_layers[n] give the scores of exit n, which stay valid
+// until the next input.
+extern bool aot_model_invoke_layer(uint32_t layer);
+extern const int8_t *aot_model_exit_output(uint32_t exit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
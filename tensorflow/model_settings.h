@@ -24,6 +24,18 @@ constexpr int kNumChannels = 3;
 
 constexpr int kMaxImageSize = kNumCols * kNumRows * kNumChannels;
 
+// A frame model (TFLM_FRAME) takes the whole camera frame and scores every
+// window of kNumRows by kNumCols in it.
+#if defined(TFLM_FRAME)
+constexpr int kFrameCols = 96;
+constexpr int kFrameRows = 96;
+#else
+constexpr int kFrameCols = kNumCols;
+constexpr int kFrameRows = kNumRows;
+#endif
+
+constexpr int kMaxFrameSize = kFrameCols * kFrameRows * kNumChannels;
+
 #if defined(MODEL_OPT)
 constexpr int kCategoryCount = 10;
 constexpr int kOneIndex = 1;
@@ -32,19 +32,74 @@
 #include <FreeRTOS.h>
 #include <task.h>
 
+#include <am_util.h>
+
+#include <new>
+#include <string.h>
+
+#if defined(TFLM_AOT)
+#include "aot_model.h"
+#else
 #include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/simple_memory_allocator.h"
 #include "tensorflow/lite/micro/system_setup.h"
 #include "tensorflow/lite/schema/schema_generated.h"
+#endif
 
+#include "logger.h"
 #include "model_settings.h"
+#include "perf.h"
+#if defined(MODEL_PARTITION)
+#include "model_partition.h"
+#endif
+#include "overlay.h"
+#if !defined(TFLM_AOT)
 #include "quant_model.h"
+#endif
+
+#if defined(TFLM_SNAPSHOT)
+#include "am_bootloader.h"
+#endif
+
+#if defined(TFLM_AOT) && defined(MODEL_PARTITION)
+#error "A compiled model cannot be replaced from the model partition"
+#endif
+#if defined(TFLM_AOT) && defined(TFLM_SNAPSHOT)
+#error "A compiled model has no planned state to keep"
+#endif
+#if defined(TFLM_FRAME) && !defined(TFLM_AOT)
+#error "Only a compiled model can score a whole frame"
+#endif
+#include "rtos_alloc.h"
 
 #include "tflm.h"
 
+// percent, see tflm_set_exit_threshold()
+#if !defined(TFLM_EXIT_THRESHOLD)
+#define TFLM_EXIT_THRESHOLD (0)
+#endif
+
+// layers per slice, see tflm_set_slice()
+#if !defined(TFLM_SLICE_LAYERS)
+#define TFLM_SLICE_LAYERS (0)
+#endif
+
+// The startup code does not clear .noinit, so what is placed there survives
+// a soft reset or a watchdog reset; see tflm_snapshot_restore().  The section
+// comes from the SDK linker script, and tools/ram_budget.py --retained fails
+// the build when it is missing or cleared.
+#if defined(TFLM_SNAPSHOT)
+#define TFLM_RETAINED __attribute__((section(".noinit")))
+#else
+#define TFLM_RETAINED
+#endif
+
 namespace
 {
+#if !defined(TFLM_AOT)
 // Declare all of the necessary variables: error_reporter, model, interpreter,
 // input and output tensors.
 tflite::ErrorReporter *error_reporter = nullptr;
@@ -52,25 +107,226 @@ const tflite::Model *model = nullptr;
 tflite::MicroInterpreter *interpreter = nullptr;
 TfLiteTensor *input = nullptr;
 TfLiteTensor *output = nullptr;
+#endif
 int inference_count = 0;
-
+uint32_t inference_ticks = 0;
+uint32_t inference_layers = 0;
+uint32_t exit_threshold = TFLM_EXIT_THRESHOLD;
+uint32_t slice_layers = TFLM_SLICE_LAYERS;
+uint32_t slice_ticks = 0;
+#if defined(TFLM_AOT)
+// the priority of the task running the inference before any waiter raised it
+UBaseType_t inference_priority = 0;
+#endif
+uint32_t setup_us = 0;
+bool setup_restored = false;
+
+// the task the running inference is for, see tflm_cancel()
+TaskHandle_t inference_owner = nullptr;
+volatile bool cancel_requested = false;
+bool inference_cancelled = false;
+
+#if defined(TFLM_AOT)
+// the model is compiled into code and constants by tools/tflm_aot.py
+uint32_t model_size = aot_model_info.constant_size;
+#else
+// the model compiled into the firmware unless a valid one is in the partition
+const uint8_t *model_data = QUANT_MODEL;
+uint32_t model_size = QUANT_MODEL_LEN;
+#endif
+uint32_t model_version = 0;
+uint32_t model_hash = 0;
+bool model_in_partition = false;
+const char *labels = kCategoryLabels;
+
+// the interpreter is shared by the pipeline, remote requests and the bench
+SemaphoreHandle_t interpreter_mutex = nullptr;
+RTOS_SEMAPHORE_STORAGE(interpreter)
+
+#if !defined(TFLM_AOT)
 // Set the size of the tensor arena - the tensor arena will vary depending on
 // the model, but the arena size should be slightly above the minimum required
 // to reduce the amount of memory allocated.
 // There will be an error if the tensor arena size is too small.
 constexpr int kTensorArenaSize = 100 * 1024;
-alignas(16) uint8_t tensor_arena[kTensorArenaSize];
+alignas(16) uint8_t tensor_arena[kTensorArenaSize] TFLM_RETAINED;
+
+// Made here rather than by the interpreter so that the persistent section at
+// the end of the arena can be found; everything before it is lent out between
+// inferences.
+tflite::SimpleMemoryAllocator *arena_allocator = nullptr;
+#endif
+
+#if defined(TFLM_SNAPSHOT)
+// The planned interpreter is kept across resets: the interpreter object and
+// the persistent section at the end of the arena, which holds the allocator,
+// the tensor metadata and the kernels' data.  The head of the arena is only
+// scratch between layers and is not part of the snapshot.
+constexpr uint32_t kSnapshotMagic = 0x544E5053;
+struct snapshot_t
+{
+    uint32_t magic;
+    uint32_t build;          // where the kernels and objects it points at are
+    const uint8_t *model;
+    uint32_t model_size;
+    uint32_t model_hash;
+    tflite::SimpleMemoryAllocator *allocator;
+    uint32_t persistent;     // bytes at the end of the arena
+    uint32_t crc;            // of the interpreter and the persistent bytes
+};
+snapshot_t snapshot TFLM_RETAINED;
+alignas(tflite::MicroInterpreter) uint8_t interpreter_storage[sizeof(tflite::MicroInterpreter)] TFLM_RETAINED;
+#endif
+
+#if defined(MODEL_PARTITION)
+// Use the model in the partition when it was built for this input and output
+// and fits the arena; it is mapped straight out of flash.
+void tflm_select_model(void)
+{
+    const model_partition_header_t *header = model_partition_find();
+    if (header == nullptr)
+    {
+        LOG_INFO("No model in the partition, using the built in model.");
+        return;
+    }
+
+    if ((header->rows != kNumRows) || (header->columns != kNumCols) ||
+        (header->channels != kNumChannels) || (header->categories != kCategoryCount))
+    {
+        LOG_WARN("Partition model %d expects %d categories,", header->version, header->categories);
+        LOG_WARN("and a %dx%dx%d input.", header->rows, header->columns, header->channels);
+        return;
+    }
+
+    if (header->arena_size > kTensorArenaSize)
+    {
+        LOG_WARN("Partition model %d needs a %d byte arena, %d available.",
+                 header->version, header->arena_size, kTensorArenaSize);
+        return;
+    }
+
+    model_data = model_partition_data(header);
+    model_size = header->size;
+    model_version = header->version;
+    model_hash = header->crc;
+    model_in_partition = true;
+    labels = header->labels;
+    LOG_INFO("Using partition model %d, %d bytes.", model_version, model_size);
+}
+#endif
 } // namespace
 
+#if defined(TFLM_AOT)
+void tflm_setup()
+{
+    uint32_t start = perf_timestamp();
+
+    interpreter_mutex = RTOS_MUTEX_CREATE(interpreter);
+
+    // the generated code has no interpreter to set up, only the model to check
+    const uint32_t windows = aot_model_info.grid_rows * aot_model_info.grid_columns;
+    if ((aot_model_info.input_size != kMaxFrameSize) ||
+        (aot_model_info.output_size != (kCategoryCount * windows)))
+    {
+        LOG_ERROR("The compiled model takes %d bytes and returns %d categories.",
+                  aot_model_info.input_size, aot_model_info.output_size);
+        return;
+    }
+
+    // lent out between inferences
+    overlay_set_region((uint8_t *)aot_model_arena(), aot_model_info.arena_size);
+
+    inference_count = 0;
+    setup_us = perf_elapsed_us(start);
+    LOG_INFO("Compiled model: %d layers, %d byte arena.", aot_model_info.layers,
+             aot_model_info.arena_size);
+}
+#else
+#if defined(TFLM_SNAPSHOT)
+// Identifies the firmware the snapshot was planned by.  The resolver holds the
+// address of every kernel and the other objects the planned state points at
+// must not have moved; any rebuild that moves one of them plans afresh.
+static uint32_t tflm_snapshot_build(const tflite::AllOpsResolver &resolver)
+{
+    const uintptr_t objects[] = {
+        reinterpret_cast<uintptr_t>(&resolver),
+        reinterpret_cast<uintptr_t>(error_reporter),
+        reinterpret_cast<uintptr_t>(tensor_arena),
+        reinterpret_cast<uintptr_t>(&tflm_setup),
+        reinterpret_cast<uintptr_t>(&tflite::GetModel),
+        sizeof(tflite::MicroInterpreter),
+        kTensorArenaSize,
+    };
+    uint32_t crc = 0;
+
+    AM_BOOTLOADER_PARTIAL_CRC32(&resolver, sizeof(resolver), &crc);
+    AM_BOOTLOADER_PARTIAL_CRC32(objects, sizeof(objects), &crc);
+    return crc;
+}
+
+static uint32_t tflm_snapshot_crc(uint32_t persistent)
+{
+    uint32_t crc = 0;
+
+    AM_BOOTLOADER_PARTIAL_CRC32(interpreter_storage, sizeof(interpreter_storage), &crc);
+    AM_BOOTLOADER_PARTIAL_CRC32(&tensor_arena[kTensorArenaSize - persistent], persistent, &crc);
+    return crc;
+}
+
+// Use the interpreter planned before the last reset when this firmware planned
+// it for this model and it came through the reset intact.
+static bool tflm_snapshot_restore(const tflite::AllOpsResolver &resolver)
+{
+    if ((snapshot.magic != kSnapshotMagic) || (snapshot.build != tflm_snapshot_build(resolver)))
+    {
+        return false;
+    }
+
+    if ((snapshot.model != model_data) || (snapshot.model_size != model_size) ||
+        (snapshot.model_hash != model_hash) || (snapshot.persistent > kTensorArenaSize))
+    {
+        return false;
+    }
+
+    if (tflm_snapshot_crc(snapshot.persistent) != snapshot.crc)
+    {
+        LOG_WARN("Interpreter snapshot damaged, planning again.");
+        return false;
+    }
+
+    interpreter = reinterpret_cast<tflite::MicroInterpreter *>(interpreter_storage);
+    return true;
+}
+
+static void tflm_snapshot_save(const tflite::AllOpsResolver &resolver)
+{
+    snapshot.build = tflm_snapshot_build(resolver);
+    snapshot.model = model_data;
+    snapshot.model_size = model_size;
+    snapshot.model_hash = model_hash;
+    snapshot.persistent = snapshot.allocator->GetTailUsedBytes();
+    snapshot.crc = tflm_snapshot_crc(snapshot.persistent);
+    snapshot.magic = kSnapshotMagic;
+}
+#endif
+
 void tflm_setup() {
+    uint32_t start = perf_timestamp();
+
     tflite::InitializeTarget();
 
+    interpreter_mutex = RTOS_MUTEX_CREATE(interpreter);
+
     // Declare the error_reporter.
     static tflite::MicroErrorReporter micro_error_reporter;
     error_reporter = &micro_error_reporter;
 
+#if defined(MODEL_PARTITION)
+    tflm_select_model();
+#endif
+
     // Load in the model.
-    model = tflite::GetModel(QUANT_MODEL);
+    model = tflite::GetModel(model_data);
     if (model->version() != TFLITE_SCHEMA_VERSION)
     {
         TF_LITE_REPORT_ERROR(error_reporter,
@@ -87,22 +343,51 @@ void tflm_setup() {
     // the layers, you can use AllOpsResolver, with some codespace penalty.
     static tflite::AllOpsResolver resolver;
 
-    // Build an interpreter to run the model with.
-    static tflite::MicroInterpreter static_interpreter(
-        model, resolver, tensor_arena, kTensorArenaSize, error_reporter);
-    interpreter = &static_interpreter;
+#if defined(TFLM_SNAPSHOT)
+    // the partition header carries the CRC of its model
+    if (!model_in_partition)
+    {
+        model_hash = AM_BOOTLOADER_IMAGE_CRC32(model_data, model_size);
+    }
+
+    setup_restored = tflm_snapshot_restore(resolver);
+#endif
 
-    // Allocate memory from the tensor_arena for the model's tensors.
-    TfLiteStatus allocate_status = interpreter->AllocateTensors();
-    if (allocate_status != kTfLiteOk)
+    if (!setup_restored)
     {
-        TF_LITE_REPORT_ERROR(error_reporter, "AllocateTensors() failed.");
-        return;
+#if defined(TFLM_SNAPSHOT)
+        // A reset before planning completes must not leave a snapshot behind.
+        // The allocator is made here rather than by the interpreter so the
+        // persistent section can be found when saving.
+        snapshot.magic = 0;
+        snapshot.allocator = tflite::SimpleMemoryAllocator::Create(
+            error_reporter, tensor_arena, kTensorArenaSize);
+        interpreter = new (interpreter_storage) tflite::MicroInterpreter(
+            model, resolver, tflite::MicroAllocator::Create(snapshot.allocator, error_reporter),
+            error_reporter);
+#else
+        // Build an interpreter to run the model with.
+        arena_allocator = tflite::SimpleMemoryAllocator::Create(error_reporter, tensor_arena, kTensorArenaSize);
+        static tflite::MicroInterpreter static_interpreter(
+            model, resolver, tflite::MicroAllocator::Create(arena_allocator, error_reporter), error_reporter);
+        interpreter = &static_interpreter;
+#endif
+
+        // Allocate memory from the tensor_arena for the model's tensors.
+        TfLiteStatus allocate_status = interpreter->AllocateTensors();
+        if (allocate_status != kTfLiteOk)
+        {
+            TF_LITE_REPORT_ERROR(error_reporter, "AllocateTensors() failed.");
+            return;
+        }
     }
 
     // Obtain pointers to the model's input and output tensors.
     input = interpreter->input(0);
 
+    // the interpreter runs every layer, early exit heads included
+    inference_layers = model->subgraphs()->Get(0)->operators()->size();
+
     // Check the settings match the model you have
     if (kNumRows != input->dims->data[1]) 
     {
@@ -131,13 +416,28 @@ void tflm_setup() {
     // Reset the inferences count every time you start the project.
     inference_count = 0;
 
+#if defined(TFLM_SNAPSHOT)
+    if (!setup_restored)
+    {
+        tflm_snapshot_save(resolver);
+    }
+    arena_allocator = snapshot.allocator;
+#endif
+
+    // the head of the arena only holds the tensors of a running inference,
+    // the input included, so it is lent out in between
+    overlay_set_region(tensor_arena, kTensorArenaSize - arena_allocator->GetTailUsedBytes());
+
+    setup_us = perf_elapsed_us(start);
     TF_LITE_REPORT_ERROR(error_reporter, "Completed setup");
+    LOG_INFO("Setup took %d us, %s.", setup_us, setup_restored ? "restored" : "planned");
 }
+#endif
 
 // Produce prediction results based on the inferences from the model.
 uint32_t prediction_results(int8_t *out, size_t *outlen, uint32_t time) 
 {
-    uint32_t predicted_value = 0xF;
+    uint32_t predicted_value = TFLM_INFERENCE_FAILED;
 
     // Resize the scores to from [-128, 127], to [0, 255] for better readability.
     const int RESIZE_CONSTANT = 128;
@@ -154,40 +454,215 @@ uint32_t prediction_results(int8_t *out, size_t *outlen, uint32_t time)
 
     // Show predicted digits and raw categories. The output tensor format is dependent on
     // the model itself, so you must verify before running on the microcontroller.
-    TF_LITE_REPORT_ERROR(error_reporter, "Predicted digit: %c\nScore: %d", kCategoryLabels[max_index], max_score);
-    predicted_value = kCategoryLabels[max_index] - '0';
-
-    TF_LITE_REPORT_ERROR(error_reporter, "\x01\x01{");
-    TF_LITE_REPORT_ERROR(error_reporter, "    \"result\": \"%c\",", kCategoryLabels[max_index]);
-    TF_LITE_REPORT_ERROR(error_reporter, "    \"confidence\": %d,", max_score);
-    TF_LITE_REPORT_ERROR(error_reporter, "    \"time\": %d,", time);
-    TF_LITE_REPORT_ERROR(error_reporter, "    \"details\": {", max_score);
+    LOG_INFO("Predicted digit: %c\nScore: %d", labels[max_index], max_score);
+    predicted_value = labels[max_index] - '0';
+
+    // the host tool parses this block, so it is printed straight away rather
+    // than through the logger, which can drop, filter or delay lines
+    am_util_stdio_printf("\x01\x01{\r\n");
+    am_util_stdio_printf("    \"result\": \"%c\",\r\n", labels[max_index]);
+    am_util_stdio_printf("    \"confidence\": %d,\r\n", max_score);
+    am_util_stdio_printf("    \"time\": %d,\r\n", time);
+    am_util_stdio_printf("    \"details\": {\r\n");
     for (int i = 0; i < kCategoryCount; i++)
     {
         if (i < (kCategoryCount - 1))
         {
-            TF_LITE_REPORT_ERROR(error_reporter, "        \"%c\": %d,", kCategoryLabels[i], out[i] + RESIZE_CONSTANT);
+            am_util_stdio_printf("        \"%c\": %d,\r\n", labels[i], out[i] + RESIZE_CONSTANT);
         }
         else
         {
-            TF_LITE_REPORT_ERROR(error_reporter, "        \"%c\": %d", kCategoryLabels[i], out[i] + RESIZE_CONSTANT);
+            am_util_stdio_printf("        \"%c\": %d\r\n", labels[i], out[i] + RESIZE_CONSTANT);
         }
     }
-    TF_LITE_REPORT_ERROR(error_reporter, "    }");
-    TF_LITE_REPORT_ERROR(error_reporter, "}");
-    TF_LITE_REPORT_ERROR(error_reporter, "\x02\x02");
+    am_util_stdio_printf("    }\r\n");
+    am_util_stdio_printf("}\r\n");
+    am_util_stdio_printf("\x02\x02\r\n");
 
     return predicted_value;
 }
 
-uint32_t tflm_inference(uint8_t *in, size_t inlen, int8_t *out, size_t *outlen)
+#if defined(TFLM_FRAME)
+// Read the digits in the window scores of a frame model and report them the
+// way prediction_results() reports a single one.  Returns the leftmost digit,
+// whose scores go to out.
+static uint32_t frame_results(const int8_t *scores, digit_reader_result_t *digits, uint32_t time,
+                              int8_t *out, size_t *outlen)
+{
+    const digit_reader_grid_t grid = {
+        .scores = scores,
+        .rows = aot_model_info.grid_rows,
+        .columns = aot_model_info.grid_columns,
+        .stride = aot_model_info.grid_stride,
+        .window = kNumCols,
+        .categories = kCategoryCount,
+        .labels = labels,
+    };
+    digit_reader_decode(&grid, digits);
+
+    // the logger formats later and would read the text after the next frame
+    // had replaced it, so only numbers are passed to it
+    uint32_t windows_per_second = time ? (digits->windows * configTICK_RATE_HZ) / time : 0;
+    LOG_INFO("Read %d digits, %d windows, %d windows/s", digits->count, digits->windows, windows_per_second);
+
+    // the result block is printed straight away, see prediction_results()
+    am_util_stdio_printf("\x01\x01{\r\n");
+    am_util_stdio_printf("    \"result\": \"%s\",\r\n", digits->text);
+    am_util_stdio_printf("    \"count\": %d,\r\n", digits->count);
+    am_util_stdio_printf("    \"time\": %d,\r\n", time);
+    am_util_stdio_printf("    \"windows\": %d,\r\n", digits->windows);
+    am_util_stdio_printf("    \"digits\": [\r\n");
+    for (uint32_t i = 0; i < digits->count; i++)
+    {
+        const digit_reader_digit_t *digit = &digits->digits[i];
+        if ((i + 1) < digits->count)
+        {
+            am_util_stdio_printf("        {\"digit\": \"%c\", \"confidence\": %d, \"x\": %d, \"y\": %d},\r\n",
+                                 digit->label, digit->confidence, digit->x, digit->y);
+        }
+        else
+        {
+            am_util_stdio_printf("        {\"digit\": \"%c\", \"confidence\": %d, \"x\": %d, \"y\": %d}\r\n",
+                                 digit->label, digit->confidence, digit->x, digit->y);
+        }
+    }
+    am_util_stdio_printf("    ]\r\n");
+    am_util_stdio_printf("}\r\n");
+    am_util_stdio_printf("\x02\x02\r\n");
+
+    if (digits->count == 0)
+    {
+        return TFLM_INFERENCE_FAILED;
+    }
+
+    const digit_reader_digit_t *first = &digits->digits[0];
+    uint32_t window = (first->y / grid.stride) * grid.columns + (first->x / grid.stride);
+    *outlen = kCategoryCount;
+    if (out != nullptr)
+    {
+        memcpy(out, &scores[window * kCategoryCount], kCategoryCount);
+    }
+
+    return first->label - '0';
+}
+#endif
+
+#if defined(TFLM_AOT)
+// The softmax scores are probabilities in steps of 1/256 from -128.
+static bool confident(const int8_t *scores, size_t count)
+{
+    if (exit_threshold == 0)
+    {
+        return false;
+    }
+
+    int32_t best = INT8_MIN;
+    for (size_t i = 0; i < count; i++)
+    {
+        best = (scores[i] > best) ? scores[i] : best;
+    }
+    return ((best + 128) * 100) >= (int32_t)(exit_threshold * 256);
+}
+
+// Run the compiled model, stopping at the first confident exit head; returns
+// its scores or nullptr on failure or cancellation.
+static int8_t *tflm_invoke(uint8_t *in, size_t inlen, size_t *outlen)
+{
+    if (inlen != aot_model_info.input_size)
+    {
+        LOG_ERROR("The outgoing number of bytes from camera does not match incoming number of bytes in input tensor.");
+        return nullptr;
+    }
+
+    memcpy(aot_model_input(), in, inlen);
+
+    // Run one layer at a time, stopping at the first confident exit head.  A
+    // cancel is noticed before the next layer starts.  Tasks above the
+    // inference preempt it and the ones at its priority share the tick, so
+    // the task only yields every slice_layers layers while a task waiting
+    // for the interpreter or the overlay has lent it a higher priority; the
+    // other tasks at that priority then get the processor at the next slice
+    // instead of the next tick.  All the state is in the arena, so the result
+    // does not depend on where the slices fall.
+    const int8_t *scores = nullptr;
+    uint32_t head = 0;
+    uint32_t start = xTaskGetTickCount();
+    uint32_t slice_start = start;
+    slice_ticks = 0;
+    for (uint32_t layer = 0; layer < aot_model_info.layers; layer++)
+    {
+        if (cancel_requested)
+        {
+            inference_cancelled = true;
+            break;
+        }
+
+        if (!aot_model_invoke_layer(layer))
+        {
+            LOG_ERROR("Compiled model invoke failed at layer %d.", layer);
+            break;
+        }
+
+        if ((layer + 1) == aot_model_info.exit_layers[head])
+        {
+            inference_layers = layer + 1;
+            if (((head + 1) == aot_model_info.exits) ||
+                confident(aot_model_exit_output(head), aot_model_info.output_size))
+            {
+                scores = aot_model_exit_output(head);
+                break;
+            }
+            head++;
+        }
+
+        if ((slice_layers != 0) && (((layer + 1) % slice_layers) == 0))
+        {
+            uint32_t now = xTaskGetTickCount();
+            slice_ticks = ((now - slice_start) > slice_ticks) ? (now - slice_start) : slice_ticks;
+            if (uxTaskPriorityGet(NULL) > inference_priority)
+            {
+                taskYIELD();
+            }
+            slice_start = xTaskGetTickCount();
+        }
+    }
+    uint32_t stop = xTaskGetTickCount();
+    slice_ticks = ((stop - slice_start) > slice_ticks) ? (stop - slice_start) : slice_ticks;
+    inference_ticks = (stop - start);
+    LOG_INFO("Inference ticks: %d, layers: %d.", inference_ticks, inference_layers);
+
+    if (inference_cancelled)
+    {
+        LOG_INFO("Inference %d cancelled.", inference_count);
+        return nullptr;
+    }
+
+    if (scores == nullptr)
+    {
+        return nullptr;
+    }
+
+    LOG_INFO("Completed inference %d", inference_count);
+
+    *outlen = aot_model_info.output_size;
+    if (*outlen != (kCategoryCount * aot_model_info.grid_rows * aot_model_info.grid_columns))
+    {
+        LOG_ERROR("Number of categories in output tensor: %d\nNumber of categories expected: %d", *outlen, kCategoryCount);
+        return nullptr;
+    }
+
+    return const_cast<int8_t *>(scores);
+}
+#else
+// Run the interpreter; returns the scores in the output tensor or nullptr on
+// failure.
+static int8_t *tflm_invoke(uint8_t *in, size_t inlen, size_t *outlen)
 {
-    uint32_t predicted_value = 0xF;
     // Check that the number of bytes coming from the camera is the same going into the model.
     if (inlen != input->bytes) 
     {
-        TF_LITE_REPORT_ERROR(error_reporter, "The outgoing number of bytes from camera does not match incoming number of bytes in input tensor.");
-        return predicted_value;
+        LOG_ERROR("The outgoing number of bytes from camera does not match incoming number of bytes in input tensor.");
+        return nullptr;
     }
 
     // Copy the input from the camera into the input buffer of the model.
@@ -197,50 +672,222 @@ uint32_t tflm_inference(uint8_t *in, size_t inlen, int8_t *out, size_t *outlen)
     uint32_t start = xTaskGetTickCount();
     TfLiteStatus invoke_status = interpreter->Invoke();
     uint32_t stop = xTaskGetTickCount();
-    uint32_t inference_ticks = (stop - start);
-    TF_LITE_REPORT_ERROR(error_reporter, "Inference ticks: %d.\n", inference_ticks);
+    inference_ticks = (stop - start);
+    slice_ticks = inference_ticks;
+    LOG_INFO("Inference ticks: %d.", inference_ticks);
 
     if (invoke_status != kTfLiteOk) 
     {
-        TF_LITE_REPORT_ERROR(error_reporter, "Interpreter invoke failed.\n");
-        return predicted_value;
+        LOG_ERROR("Interpreter invoke failed.");
+        return nullptr;
     }
 
-    TF_LITE_REPORT_ERROR(error_reporter, "Completed inference %d\n", inference_count);
+    LOG_INFO("Completed inference %d", inference_count);
 
-    output = interpreter->output(0);
+    // models with early exit heads list the full model last
+    output = interpreter->output(interpreter->outputs_size() - 1);
 
     // Grab the output tensor and type cast it to int8_t.
-    out = tflite::GetTensorData<int8_t>(output);
+    int8_t *scores = tflite::GetTensorData<int8_t>(output);
     *outlen = output->dims->data[1];
 
     if (output->dims->size != 2) 
     {
-        TF_LITE_REPORT_ERROR(error_reporter, "Shape of the output tensor is incorrect.");
-        return predicted_value;
+        LOG_ERROR("Shape of the output tensor is incorrect.");
+        return nullptr;
     }
 
     if (output->dims->data[0] != 1) 
     {
-        TF_LITE_REPORT_ERROR(error_reporter, "More than one output tensor is being outputted.");
-        return predicted_value;
+        LOG_ERROR("More than one output tensor is being outputted.");
+        return nullptr;
     }
 
     if (*outlen != kCategoryCount) 
     {
-        TF_LITE_REPORT_ERROR(error_reporter, "Number of categories in output tensor: %d\nNumber of categories expected: %d", outlen, kCategoryCount);
-        return predicted_value;
+        LOG_ERROR("Number of categories in output tensor: %d\nNumber of categories expected: %d", *outlen, kCategoryCount);
+        return nullptr;
     }
 
     if (output->type != kTfLiteInt8) 
     {
-        TF_LITE_REPORT_ERROR(error_reporter, "Output type is not int8.");
-        return predicted_value;
+        LOG_ERROR("Output type is not int8.");
+        return nullptr;
+    }
+
+    return scores;
+}
+#endif
+
+static uint32_t tflm_inference_locked(uint8_t *in, size_t inlen, int8_t *out, size_t *outlen,
+                                      digit_reader_result_t *digits)
+{
+    uint32_t predicted_value = TFLM_INFERENCE_FAILED;
+
+    taskENTER_CRITICAL();
+    inference_owner = xTaskGetCurrentTaskHandle();
+    cancel_requested = false;
+    taskEXIT_CRITICAL();
+    inference_cancelled = false;
+
+    int8_t *scores = tflm_invoke(in, inlen, outlen);
+
+    taskENTER_CRITICAL();
+    inference_owner = nullptr;
+    taskEXIT_CRITICAL();
+
+    if (scores == nullptr)
+    {
+        return inference_cancelled ? TFLM_INFERENCE_CANCELLED : predicted_value;
+    }
+
+#if defined(TFLM_FRAME)
+    predicted_value = frame_results(scores, digits, inference_ticks, out, outlen);
+#else
+    (void)digits;
+    if (out != nullptr)
+    {
+        memcpy(out, scores, *outlen);
     }
 
-    predicted_value = prediction_results(out, outlen, inference_ticks);
+    predicted_value = prediction_results(scores, outlen, inference_ticks);
+#endif
 
     inference_count++;
 
     return predicted_value;
+}
+
+static uint32_t tflm_run(uint8_t *in, size_t inlen, int8_t *out, size_t *outlen, digit_reader_result_t *digits)
+{
+#if defined(TFLM_AOT)
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+#endif
+    xSemaphoreTake(interpreter_mutex, portMAX_DELAY);
+#if defined(TFLM_AOT)
+    inference_priority = priority;
+#endif
+    overlay_claim();
+    uint32_t predicted_value = tflm_inference_locked(in, inlen, out, outlen, digits);
+    overlay_release();
+    xSemaphoreGive(interpreter_mutex);
+
+    return predicted_value;
+}
+
+// When out is not null it must have room for kCategoryCount scores; they are
+// copied from the output tensor so the caller can keep them past the next
+// inference.  A frame model returns the leftmost digit it read and its scores.
+uint32_t tflm_inference(uint8_t *in, size_t inlen, int8_t *out, size_t *outlen)
+{
+    digit_reader_result_t digits;
+    return tflm_run(in, inlen, out, outlen, &digits);
+}
+
+// Read every digit in a whole frame with a frame model (TFLM_FRAME); returns
+// how many were read, TFLM_INFERENCE_FAILED or TFLM_INFERENCE_CANCELLED.  A
+// model that scores a single window always fails.
+uint32_t tflm_read_digits(uint8_t *in, size_t inlen, digit_reader_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+#if defined(TFLM_FRAME)
+    size_t count;
+    uint32_t value = tflm_run(in, inlen, nullptr, &count, result);
+    if (value == TFLM_INFERENCE_CANCELLED)
+    {
+        return value;
+    }
+
+    return result->windows ? result->count : TFLM_INFERENCE_FAILED;
+#else
+    (void)in;
+    (void)inlen;
+    return TFLM_INFERENCE_FAILED;
+#endif
+}
+
+uint32_t tflm_inference_ticks(void)
+{
+    return inference_ticks;
+}
+
+// Layers run by the last inference, fewer than the model has when it stopped
+// at an early exit head.
+uint32_t tflm_inference_layers(void)
+{
+    return inference_layers;
+}
+
+// Stop inference at the first exit head whose best score is at least this
+// likely.  Only the compiled model (TFLM_AOT) runs one head at a time; the
+// interpreter always runs to the final output.  0 turns early exit off.
+void tflm_set_exit_threshold(uint32_t percent)
+{
+    exit_threshold = percent;
+}
+
+// Yield every this many layers while a waiter has raised the priority of the
+// inference.  Only the compiled model can be sliced; 0 runs the whole model in
+// one go.
+void tflm_set_slice(uint32_t layers)
+{
+    slice_layers = layers;
+}
+
+// Abandon the inference running for task, if any, before its next layer; it
+// then returns TFLM_INFERENCE_CANCELLED.  An inference for another task, or
+// one still waiting for the interpreter, is left alone.  The interpreter
+// cannot be interrupted, so without TFLM_AOT this has no effect.
+void tflm_cancel(TaskHandle_t task)
+{
+    taskENTER_CRITICAL();
+    if ((inference_owner != nullptr) && (inference_owner == task))
+    {
+        cancel_requested = true;
+    }
+    taskEXIT_CRITICAL();
+}
+
+// Plan the interpreter again at the next reset.  Without TFLM_SNAPSHOT it is
+// planned at every reset anyway.
+void tflm_snapshot_clear(void)
+{
+#if defined(TFLM_SNAPSHOT)
+    snapshot.magic = 0;
+#endif
+}
+
+void tflm_get_info(tflm_info_t *info)
+{
+    info->rows = kNumRows;
+    info->columns = kNumCols;
+    info->channels = kNumChannels;
+    info->categories = kCategoryCount;
+    info->labels = labels;
+#if defined(TFLM_AOT)
+    info->input_size = aot_model_info.input_size;
+    info->arena_size = aot_model_info.arena_size;
+    info->arena_used = aot_model_info.arena_size;
+#else
+    info->input_size = (input != nullptr) ? input->bytes : kMaxImageSize;
+    info->arena_size = kTensorArenaSize;
+    info->arena_used = (interpreter != nullptr) ? interpreter->arena_used_bytes() : 0;
+#endif
+    info->model_size = model_size;
+    info->model_version = model_version;
+    info->model_in_partition = model_in_partition;
+    info->exit_threshold = exit_threshold;
+    info->slice_layers = slice_layers;
+    info->slice_ticks = slice_ticks;
+    info->setup_us = setup_us;
+    info->setup_restored = setup_restored;
+#if defined(TFLM_AOT)
+    info->layers = aot_model_info.layers;
+    info->exits = aot_model_info.exits;
+    info->windows = aot_model_info.grid_rows * aot_model_info.grid_columns;
+#else
+    info->windows = 1;
+    info->layers = (model != nullptr) ? model->subgraphs()->Get(0)->operators()->size() : 0;
+    info->exits = (interpreter != nullptr) ? interpreter->outputs_size() : 1;
+#endif
 }
\ No newline at end of file
@@ -32,13 +32,56 @@
 #ifndef _TFLM_H_
 #define _TFLM_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "digit_reader.h"
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+#define TFLM_INFERENCE_FAILED    (0xF)
+#define TFLM_INFERENCE_CANCELLED (0xE)
+
+typedef struct tflm_info_s
+{
+    uint8_t rows;
+    uint8_t columns;
+    uint8_t channels;
+    uint8_t categories;
+    size_t input_size;
+    const char *labels;
+    size_t arena_size;
+    size_t arena_used;
+    uint32_t model_size;
+    uint32_t model_version;   // 0 for the model built into the firmware
+    bool model_in_partition;
+    uint32_t layers;          // layers in the full model
+    uint32_t exits;           // early exit heads including the final output
+    uint32_t exit_threshold;  // percent, 0 when every layer always runs
+    uint32_t slice_layers;    // layers run between yields, 0 for no slicing
+    uint32_t slice_ticks;     // longest slice of the last inference
+    uint32_t setup_us;        // time tflm_setup() took
+    bool setup_restored;      // the interpreter came from the snapshot
+    uint32_t windows;         // scored by each inference, more than 1 for a frame model
+} tflm_info_t;
+
 extern void tflm_setup(void);
 extern uint32_t tflm_inference(uint8_t *in, size_t inlen, int8_t *out, size_t *outlen);
+extern uint32_t tflm_read_digits(uint8_t *in, size_t inlen, digit_reader_result_t *result);
+extern uint32_t tflm_inference_ticks(void);
+extern uint32_t tflm_inference_layers(void);
+extern void tflm_set_exit_threshold(uint32_t percent);
+extern void tflm_set_slice(uint32_t layers);
+extern void tflm_cancel(TaskHandle_t task);
+extern void tflm_snapshot_clear(void);
+extern void tflm_get_info(tflm_info_t *info);
 
 #ifdef __cplusplus
 }
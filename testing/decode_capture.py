@@ -0,0 +1,117 @@
+import argparse
+import base64
+import numpy as np
+import re
+
+# Decoder for the image dumps produced by "cam dump" (see image_dump.c).
+# Captures are located between the \x01\x01image ... and \x02\x02 markers in
+# a console log, so the log can also contain prompts and inference output.
+# Logs in the older one pixel per line hex format are still accepted.
+
+START_MARKER = b"\x01\x01image "
+END_MARKER = b"\x02\x02"
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            if crc & 0x8000:
+                crc = ((crc << 1) ^ 0x1021) & 0xFFFF
+            else:
+                crc = (crc << 1) & 0xFFFF
+    return crc
+
+def unpack_rle(data, channels):
+    pixels = bytearray()
+    index = 0
+    while index < len(data):
+        control = data[index]
+        index += 1
+        if control < 128:
+            count = (control + 1) * channels
+            pixels += data[index:index + count]
+            index += count
+        elif control > 128:
+            pixels += data[index:index + channels] * (257 - control)
+            index += channels
+    return bytes(pixels)
+
+def parse_header(line):
+    fields = dict(re.findall(rb"(\w+)=(\w+)", line))
+    return {
+        "width": int(fields[b"width"]),
+        "height": int(fields[b"height"]),
+        "channels": int(fields[b"channels"]),
+        "encoding": fields[b"encoding"].decode(),
+        "rle": int(fields[b"rle"]) != 0,
+        "size": int(fields[b"size"]),
+        "crc": int(fields[b"crc"], 16),
+    }
+
+def decode_payload(log, position, header):
+    if header["encoding"] == "binary":
+        payload = bytearray()
+        while True:
+            length = log[position]
+            position += 1
+            if length == 0:
+                break
+            payload += log[position:position + length]
+            position += length
+        return bytes(payload), position
+
+    end = log.index(END_MARKER, position)
+    text = b"".join(log[position:end].split())
+    return base64.b64decode(text), end
+
+def decode_dumps(log):
+    images = []
+    position = 0
+    while True:
+        start = log.find(START_MARKER, position)
+        if start < 0:
+            break
+        eol = log.index(b"\r\n", start)
+        header = parse_header(log[start:eol])
+        payload, position = decode_payload(log, eol + 2, header)
+
+        if header["rle"]:
+            payload = unpack_rle(payload, header["channels"])
+
+        if len(payload) != header["size"] or crc16(payload) != header["crc"]:
+            raise ValueError("corrupted image dump at offset {}".format(start))
+
+        raw = np.frombuffer(payload, dtype=np.uint8)
+        images.append(raw.reshape((header["height"], header["width"], header["channels"])))
+
+    return images
+
+def decode_legacy(log, width=32, height=32, channels=3):
+    array = [int(x, 16) for x in log.split() if x.startswith(b"0x")]
+    raw = np.array(array, dtype=np.uint8)
+    return [raw.reshape((height, width, channels))]
+
+def load_captures(filename):
+    with open(filename, "rb") as f:
+        log = f.read()
+
+    images = decode_dumps(log)
+    if not images:
+        images = decode_legacy(log)
+    return images
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode image dumps from a console log.")
+    parser.add_argument("log", action="store")
+    parser.add_argument("--output", dest="output", action="store", default=None)
+    args = parser.parse_args()
+
+    images = load_captures(args.log)
+    for index, image in enumerate(images):
+        print("image {}: {}x{}x{}".format(index, image.shape[1], image.shape[0], image.shape[2]))
+        if args.output:
+            image.tofile("{}_{}.raw".format(args.output, index))
+
+if __name__ == "__main__":
+    main()
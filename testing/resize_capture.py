@@ -1,21 +1,13 @@
 import cv2
 import numpy as np
 
-f = open("console_capture_32x32.log")
-array = []
-for line in f:
-    for x in line.split():
-        array.append(int(x, 16))
-f.close()
+from decode_capture import load_captures
 
-byte_array = bytearray(array)
+raw = load_captures("console_capture_32x32.log")[-1]
 
-raw = np.array(byte_array, dtype=np.uint8)
-raw = raw.reshape((1024, 3))
-
-r = raw[:,0].reshape((32, 32))
-g = raw[:,1].reshape((32, 32))
-b = raw[:,2].reshape((32, 32))
+r = raw[:,:,0]
+g = raw[:,:,1]
+b = raw[:,:,2]
 
 r_max = np.max(r)
 g_max = np.max(g)
@@ -32,4 +24,4 @@ cv2.imwrite("console_capture.png", image_rgb)
 image_bgr = cv2.merge([b/b_max, g/g_max, r/r_max])
 cv2.imshow("", image_bgr)
 cv2.waitKey()
-cv2.destroyAllWindows()
\ No newline at end of file
+cv2.destroyAllWindows()
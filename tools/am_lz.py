@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+# Compressor for OTA images installed by the multiboot OTA handler with
+# OTA_INFO_OPTIONS_COMPRESSED; the format is described in
+# utils/bootloader/am_multiboot_lz.h.  Used by create_model_blob.py --compress,
+# or on its own:
+#
+#   python3 tools/am_lz.py image.bin image.lz
+
+import argparse
+import struct
+import zlib
+
+MAGIC = 0x315A4C41
+# AM_MULTIBOOT_LZ_WINDOW, 2KB
+WINDOW_BITS = 11
+
+# boot loader CRC-32: polynomial 0x1EDC6F41, MSB first, no reflection, init 0
+POLYNOMIAL = 0x1EDC6F41
+
+
+def _crc_table():
+    table = []
+    for n in range(256):
+        crc = n << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ POLYNOMIAL) if crc & 0x80000000 else (crc << 1)
+        table.append(crc & 0xFFFFFFFF)
+    return table
+
+
+_TABLE = _crc_table()
+
+
+def bootloader_crc32(data):
+    crc = 0
+    for byte in data:
+        crc = ((crc << 8) & 0xFFFFFFFF) ^ _TABLE[byte ^ (crc >> 24)]
+    return crc
+
+
+def compress(data):
+    data = bytes(data)
+    # raw DEFLATE limited to the window the boot loader keeps
+    deflate = zlib.compressobj(9, zlib.DEFLATED, -WINDOW_BITS, 9)
+    out = struct.pack("<III", MAGIC, len(data), bootloader_crc32(data))
+    out += deflate.compress(data) + deflate.flush()
+    # the boot loader reads whole words
+    out += b"\0" * (-len(out) % 4)
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compress an image for the multiboot OTA handler.")
+    parser.add_argument("input", type=argparse.FileType("rb"))
+    parser.add_argument("output", type=argparse.FileType("wb"))
+    args = parser.parse_args()
+
+    data = args.input.read()
+    compressed = compress(data)
+    args.output.write(compressed)
+    print("%d bytes compressed to %d (%.1f%%)" %
+          (len(data), len(compressed), 100.0 * len(compressed) / max(len(data), 1)))
+
+
+if __name__ == "__main__":
+    main()
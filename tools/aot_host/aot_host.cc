@@ -0,0 +1,271 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <task.h>
+
+#include "aot_model.h"
+#include "logger.h"
+#include "model_settings.h"
+#include "tflm.h"
+
+namespace
+{
+const auto kEpoch = std::chrono::steady_clock::now();
+bool verbose = false;
+
+void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options] [vectors]\n"
+            "\n"
+            "Run the interpreter and the ahead of time compiled model on the same\n"
+            "inputs and check that every score matches.  [vectors] holds records\n"
+            "written by training_files/local/export_vectors.py; random inputs are\n"
+            "used as well.\n"
+            "\n"
+            "options:\n"
+            "  -n <count>        number of random inputs (default 100)\n"
+            "  -s <seed>         seed for the random inputs (default 1)\n"
+            "  -v                show the firmware log\n",
+            program);
+}
+
+uint32_t host_timestamp(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - kEpoch)
+        .count();
+}
+
+struct timing_t
+{
+    uint64_t total_us = 0;
+    uint32_t max_us = 0;
+    uint32_t runs = 0;
+
+    void add(uint32_t us)
+    {
+        total_us += us;
+        max_us = (us > max_us) ? us : max_us;
+        runs++;
+    }
+
+    uint32_t mean_us() const
+    {
+        return runs ? static_cast<uint32_t>(total_us / runs) : 0;
+    }
+};
+
+// Returns false when the two disagree; the scores are printed the first time.
+bool compare(const uint8_t *input, size_t size, timing_t &interpreter, timing_t &aot, bool report)
+{
+    int8_t expected[kCategoryCount];
+    size_t count = 0;
+
+    uint32_t start = host_timestamp();
+    uint32_t value = tflm_inference(const_cast<uint8_t *>(input), size, expected, &count);
+    interpreter.add(host_timestamp() - start);
+    if ((value == TFLM_INFERENCE_FAILED) || (count != kCategoryCount))
+    {
+        fprintf(stderr, "interpreter failed\n");
+        return false;
+    }
+
+    start = host_timestamp();
+    memcpy(aot_model_input(), input, size);
+    bool invoked = aot_model_invoke();
+    aot.add(host_timestamp() - start);
+    if (!invoked)
+    {
+        fprintf(stderr, "compiled model failed\n");
+        return false;
+    }
+
+    const int8_t *actual = aot_model_output();
+    if (memcmp(expected, actual, kCategoryCount) == 0)
+    {
+        return true;
+    }
+
+    if (report)
+    {
+        fprintf(stderr, "scores differ\n  interpreter:");
+        for (int i = 0; i < kCategoryCount; i++)
+        {
+            fprintf(stderr, " %4d", expected[i]);
+        }
+        fprintf(stderr, "\n  compiled:   ");
+        for (int i = 0; i < kCategoryCount; i++)
+        {
+            fprintf(stderr, " %4d", actual[i]);
+        }
+        fprintf(stderr, "\n");
+    }
+    return false;
+}
+} // namespace
+
+extern "C" TickType_t xTaskGetTickCount(void)
+{
+    return host_timestamp() / 1000;
+}
+
+extern "C" uint32_t perf_timestamp(void)
+{
+    return host_timestamp();
+}
+
+extern "C" uint32_t perf_elapsed_us(uint32_t start)
+{
+    return host_timestamp() - start;
+}
+
+extern "C" void logger_record(uint8_t level, const char *format, uint32_t argc, ...)
+{
+    if (!verbose)
+    {
+        return;
+    }
+
+    // arguments are recorded as 32-bit words, the same way the firmware does
+    uint32_t args[LOGGER_MAX_ARGS] = {0};
+    va_list list;
+    va_start(list, argc);
+    for (uint32_t i = 0; (i < argc) && (i < LOGGER_MAX_ARGS); i++)
+    {
+        args[i] = va_arg(list, uint32_t);
+    }
+    va_end(list);
+
+    fprintf(stderr, format, args[0], args[1], args[2], args[3]);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t count = 100;
+    uint32_t seed = 1;
+    int arg = 1;
+
+    for (; (arg < argc) && (argv[arg][0] == '-'); arg++)
+    {
+        if ((strcmp(argv[arg], "-n") == 0) && ((arg + 1) < argc))
+        {
+            count = strtoul(argv[++arg], nullptr, 0);
+        }
+        else if ((strcmp(argv[arg], "-s") == 0) && ((arg + 1) < argc))
+        {
+            seed = strtoul(argv[++arg], nullptr, 0);
+        }
+        else if (strcmp(argv[arg], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    tflm_setup();
+
+    tflm_info_t model;
+    tflm_get_info(&model);
+
+    if ((aot_model_info.input_size != model.input_size) || (aot_model_info.output_size != kCategoryCount))
+    {
+        fprintf(stderr,
+                "compiled model takes %u bytes and returns %u scores, interpreter %zu and %d\n",
+                aot_model_info.input_size,
+                aot_model_info.output_size,
+                model.input_size,
+                kCategoryCount);
+        return EXIT_FAILURE;
+    }
+
+    // records of one label byte followed by the input
+    std::vector<uint8_t> data;
+    if (arg < argc)
+    {
+        std::ifstream file(argv[arg], std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::mt19937 generator(seed);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        data.push_back(0);
+        for (size_t j = 0; j < model.input_size; j++)
+        {
+            data.push_back(static_cast<uint8_t>(generator()));
+        }
+    }
+
+    timing_t interpreter;
+    timing_t aot;
+    uint32_t inputs = 0;
+    uint32_t mismatches = 0;
+    const size_t record_size = 1 + model.input_size;
+
+    for (size_t offset = 0; (offset + record_size) <= data.size(); offset += record_size)
+    {
+        if (!compare(&data[offset + 1], model.input_size, interpreter, aot, mismatches == 0))
+        {
+            mismatches++;
+        }
+        inputs++;
+    }
+
+    printf("%u inputs, %u mismatches\n", inputs, mismatches);
+    printf("latency     interpreter %u us mean %u us max, compiled %u us mean %u us max\n",
+           interpreter.mean_us(),
+           interpreter.max_us,
+           aot.mean_us(),
+           aot.max_us);
+    printf("arena       interpreter %zu bytes, compiled %u bytes\n", model.arena_used, aot_model_info.arena_size);
+    printf("model data  flatbuffer %u bytes, compiled constants %u bytes (%+d)\n",
+           aot_model_info.model_size,
+           aot_model_info.constant_size,
+           static_cast<int>(aot_model_info.constant_size) - static_cast<int>(aot_model_info.model_size));
+    printf("layers      %u\n", aot_model_info.layers);
+
+    return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
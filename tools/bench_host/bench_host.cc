@@ -0,0 +1,373 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <cctype>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <task.h>
+
+#include "bench.h"
+#include "logger.h"
+#include "overlay.h"
+#include "tflm.h"
+
+namespace
+{
+const auto kEpoch = std::chrono::steady_clock::now();
+bool verbose = false;
+
+// layers run, summed over the inferences of one benchmark
+uint64_t layers_run = 0;
+
+void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options] <vectors>\n"
+            "\n"
+            "Run the firmware benchmark on the host TFLM build.  <vectors> holds\n"
+            "records written by training_files/local/export_vectors.py.\n"
+            "\n"
+            "options:\n"
+            "  -n <count>        number of inferences (default: one per vector)\n"
+            "  -c                also print the results as one CSV line\n"
+            "  -b <file>         compare with a CSV line saved from an earlier run\n"
+            "  -t <percent>      allowed latency regression (default 10)\n"
+            "  -e <percent,...>  also run with these early exit thresholds\n"
+            "  -s <layers>       yield every this many layers (TFLM_AOT only)\n"
+            "  -v                show the firmware log\n",
+            program);
+}
+
+uint32_t host_timestamp(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - kEpoch)
+        .count();
+}
+
+uint32_t host_elapsed_us(uint32_t start)
+{
+    return host_timestamp() - start;
+}
+
+char host_infer(const uint8_t *tensor, size_t size)
+{
+    size_t count;
+    uint32_t value = tflm_inference(const_cast<uint8_t *>(tensor), size, nullptr, &count);
+    layers_run += tflm_inference_layers();
+    return (value == TFLM_INFERENCE_FAILED) ? 0 : static_cast<char>('0' + value);
+}
+
+uint32_t accuracy_bp(const bench_result_t &result)
+{
+    return result.labelled ? (result.correct * 10000) / result.labelled : 0;
+}
+
+void print_csv(const bench_result_t &result)
+{
+    printf("iterations,failed,min_us,p50_us,p95_us,p99_us,max_us,mean_us,accuracy_bp\n");
+    printf("%u,%u,%u,%u,%u,%u,%u,%u,%u\n",
+           result.iterations,
+           result.failed,
+           result.min_us,
+           result.p50_us,
+           result.p95_us,
+           result.p99_us,
+           result.max_us,
+           result.mean_us,
+           accuracy_bp(result));
+}
+
+bool read_baseline(const std::string &filename, bench_result_t &baseline, uint32_t &accuracy)
+{
+    std::ifstream file(filename);
+    std::string line;
+
+    // skip the header written by print_csv
+    while (std::getline(file, line))
+    {
+        if (sscanf(line.c_str(),
+                   "%u,%u,%u,%u,%u,%u,%u,%u,%u",
+                   &baseline.iterations,
+                   &baseline.failed,
+                   &baseline.min_us,
+                   &baseline.p50_us,
+                   &baseline.p95_us,
+                   &baseline.p99_us,
+                   &baseline.max_us,
+                   &baseline.mean_us,
+                   &accuracy) == 9)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Latency and accuracy against the depth reached for each exit threshold.
+void sweep_exits(const std::vector<uint32_t> &thresholds,
+                 const bench_platform_t &platform,
+                 const std::vector<bench_vector_t> &vectors,
+                 const tflm_info_t &model,
+                 std::vector<uint32_t> &samples)
+{
+    printf("\nexit threshold  mean layers  p50_us  mean_us  accuracy\n");
+    for (uint32_t threshold : thresholds)
+    {
+        bench_result_t result;
+
+        tflm_set_exit_threshold(threshold);
+        layers_run = 0;
+        bench_run(&platform, vectors.data(), vectors.size(), model.input_size, samples.size(), samples.data(), &result);
+
+        uint32_t tenths = result.iterations ? (layers_run * 10) / result.iterations : 0;
+        printf("%13u%%  %5u.%u/%-3u  %6u  %7u  %3u.%02u%%\n",
+               threshold,
+               tenths / 10,
+               tenths % 10,
+               model.layers,
+               result.p50_us,
+               result.mean_us,
+               accuracy_bp(result) / 100,
+               accuracy_bp(result) % 100);
+    }
+    tflm_set_exit_threshold(0);
+}
+
+bool regressed(const char *what, uint32_t value, uint32_t reference, uint32_t tolerance)
+{
+    uint64_t limit = static_cast<uint64_t>(reference) * (100 + tolerance) / 100;
+    if (value > limit)
+    {
+        fprintf(stderr, "%s regressed: %u us, baseline %u us\n", what, value, reference);
+        return true;
+    }
+    return false;
+}
+} // namespace
+
+extern "C" TickType_t xTaskGetTickCount(void)
+{
+    return host_timestamp() / 1000;
+}
+
+extern "C" uint32_t perf_timestamp(void)
+{
+    return host_timestamp();
+}
+
+extern "C" uint32_t perf_elapsed_us(uint32_t start)
+{
+    return host_timestamp() - start;
+}
+
+extern "C" void logger_record(uint8_t level, const char *format, uint32_t argc, ...)
+{
+    if (!verbose)
+    {
+        return;
+    }
+
+    // formatted straight away; the firmware records 32-bit words, which would
+    // cut a %s pointer in half on a 64-bit host
+    (void)argc;
+    va_list list;
+    va_start(list, argc);
+    vfprintf(stderr, format, list);
+    va_end(list);
+    fprintf(stderr, "\n");
+}
+
+extern "C" int am_util_stdio_printf(const char *format, ...)
+{
+    if (!verbose)
+    {
+        return 0;
+    }
+
+    va_list list;
+    va_start(list, format);
+    int length = vfprintf(stderr, format, list);
+    va_end(list);
+    return length;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 0;
+    bool csv = false;
+    std::string baseline_file;
+    uint32_t tolerance = 10;
+    std::vector<uint32_t> thresholds;
+    uint32_t slice_layers = 0;
+    int arg = 1;
+
+    for (; (arg < argc) && (argv[arg][0] == '-'); arg++)
+    {
+        if ((strcmp(argv[arg], "-n") == 0) && ((arg + 1) < argc))
+        {
+            iterations = strtoul(argv[++arg], nullptr, 0);
+        }
+        else if (strcmp(argv[arg], "-c") == 0)
+        {
+            csv = true;
+        }
+        else if ((strcmp(argv[arg], "-b") == 0) && ((arg + 1) < argc))
+        {
+            baseline_file = argv[++arg];
+        }
+        else if ((strcmp(argv[arg], "-t") == 0) && ((arg + 1) < argc))
+        {
+            tolerance = strtoul(argv[++arg], nullptr, 0);
+        }
+        else if ((strcmp(argv[arg], "-e") == 0) && ((arg + 1) < argc))
+        {
+            for (char *next = argv[++arg]; *next != '\0';)
+            {
+                thresholds.push_back(strtoul(next, &next, 0));
+                next += (*next == ',') ? 1 : 0;
+                if ((*next != '\0') && !isdigit(static_cast<unsigned char>(*next)))
+                {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+        else if ((strcmp(argv[arg], "-s") == 0) && ((arg + 1) < argc))
+        {
+            slice_layers = strtoul(argv[++arg], nullptr, 0);
+        }
+        else if (strcmp(argv[arg], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (arg >= argc)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    overlay_setup();
+    tflm_setup();
+    tflm_set_slice(slice_layers);
+
+    tflm_info_t model;
+    tflm_get_info(&model);
+
+    std::ifstream file(argv[arg], std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const size_t record_size = 1 + model.input_size;
+
+    std::vector<bench_vector_t> vectors;
+    for (size_t offset = 0; (offset + record_size) <= data.size(); offset += record_size)
+    {
+        vectors.push_back({static_cast<char>(data[offset]), &data[offset + 1]});
+    }
+    if (vectors.empty())
+    {
+        fprintf(stderr, "no vectors of %zu bytes in %s\n", model.input_size, argv[arg]);
+        return EXIT_FAILURE;
+    }
+
+    if (iterations == 0)
+    {
+        iterations = vectors.size();
+    }
+
+    const bench_platform_t platform = {host_timestamp, host_elapsed_us, host_infer};
+    std::vector<uint32_t> samples(iterations);
+    bench_result_t result;
+
+    bench_run(&platform, vectors.data(), vectors.size(), model.input_size, iterations, samples.data(), &result);
+    bench_print("host", &result);
+    if ((model.windows > 1) && (result.elapsed_us > 0))
+    {
+        uint64_t rate = static_cast<uint64_t>(result.iterations) * model.windows * 1000000 / result.elapsed_us;
+        printf("  windows: %u per frame, %llu windows/s\n", model.windows, static_cast<unsigned long long>(rate));
+    }
+    printf("  setup us: %u, %s\n", model.setup_us, model.setup_restored ? "restored" : "planned");
+    printf("  arena: %zu of %zu bytes\n", model.arena_used, model.arena_size);
+
+    if (csv)
+    {
+        print_csv(result);
+    }
+
+    if (!thresholds.empty())
+    {
+        sweep_exits(thresholds, platform, vectors, model, samples);
+    }
+
+    int status = result.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    if (!baseline_file.empty())
+    {
+        bench_result_t baseline;
+        uint32_t baseline_accuracy;
+
+        if (!read_baseline(baseline_file, baseline, baseline_accuracy))
+        {
+            fprintf(stderr, "unable to read baseline %s\n", baseline_file.c_str());
+            return EXIT_FAILURE;
+        }
+
+        if (regressed("p50", result.p50_us, baseline.p50_us, tolerance) ||
+            regressed("p95", result.p95_us, baseline.p95_us, tolerance))
+        {
+            status = EXIT_FAILURE;
+        }
+        if (accuracy_bp(result) < baseline_accuracy)
+        {
+            fprintf(stderr,
+                    "accuracy regressed: %u.%02u%%, baseline %u.%02u%%\n",
+                    accuracy_bp(result) / 100,
+                    accuracy_bp(result) % 100,
+                    baseline_accuracy / 100,
+                    baseline_accuracy % 100);
+            status = EXIT_FAILURE;
+        }
+    }
+
+    return status;
+}
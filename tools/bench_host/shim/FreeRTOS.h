@@ -0,0 +1,17 @@
+// Minimal FreeRTOS surface needed to build tensorflow/tflm.cc on the host.
+#ifndef _FREERTOS_H_
+#define _FREERTOS_H_
+
+#include <stdint.h>
+
+#define configTICK_RATE_HZ (1000)
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE       ((BaseType_t)0)
+#define pdTRUE        ((BaseType_t)1)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef _AM_UTIL_H_
+#define _AM_UTIL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// console output of the result block, printed by bench_host.cc with -v
+extern int am_util_stdio_printf(const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
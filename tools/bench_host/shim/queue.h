@@ -0,0 +1,7 @@
+// Nothing from queue.h is used on the host; it is here for rtos_alloc.h.
+#ifndef _QUEUE_H_
+#define _QUEUE_H_
+
+#include "FreeRTOS.h"
+
+#endif
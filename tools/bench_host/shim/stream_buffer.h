@@ -0,0 +1,7 @@
+// Nothing from stream_buffer.h is used on the host; it is here for rtos_alloc.h.
+#ifndef _STREAM_BUFFER_H_
+#define _STREAM_BUFFER_H_
+
+#include "FreeRTOS.h"
+
+#endif
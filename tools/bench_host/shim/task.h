@@ -0,0 +1,26 @@
+#ifndef _TASK_H_
+#define _TASK_H_
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// milliseconds since the harness started, implemented in bench_host.cc
+extern TickType_t xTaskGetTickCount(void);
+
+// the harness runs everything on one thread
+typedef void *TaskHandle_t;
+
+#define xTaskGetCurrentTaskHandle() ((TaskHandle_t)1)
+#define uxTaskPriorityGet(task)     ((UBaseType_t)0)
+#define taskYIELD()
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,7 @@
+// Nothing from timers.h is used on the host; it is here for rtos_alloc.h.
+#ifndef _TIMERS_H_
+#define _TIMERS_H_
+
+#include "FreeRTOS.h"
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "button_trie.h"
+
+namespace
+{
+constexpr size_t kSequences = 300;
+constexpr int kRounds = 2000;
+
+uint32_t hits = 0;
+
+void hit(void)
+{
+    hits++;
+}
+
+struct Sequence
+{
+    uint8_t size;
+    uint32_t value;
+};
+
+// the matcher the trie replaced: compare every registration on each lookup
+bool linear_match(const std::vector<Sequence> &registered, uint8_t size, uint32_t value)
+{
+    bool matched = false;
+    for (const auto &sequence : registered)
+    {
+        if ((sequence.size == size) && (sequence.value == value))
+        {
+            matched = true;
+        }
+    }
+    return matched;
+}
+
+// walk a sequence press by press, return the result of the final step
+button_trie_result_e walk(const Sequence &sequence, uint16_t &node)
+{
+    button_trie_result_e result = BUTTON_TRIE_NONE;
+    node = BUTTON_TRIE_ROOT;
+    for (uint8_t i = 0; i < sequence.size; i++)
+    {
+        result = button_trie_step(&node, (sequence.value >> i) & 0x01);
+        if (result == BUTTON_TRIE_NONE)
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+int check(const std::vector<Sequence> &sequences)
+{
+    int failures = 0;
+    std::set<std::pair<uint8_t, uint32_t>> keys;
+    for (const auto &sequence : sequences)
+    {
+        keys.insert({sequence.size, sequence.value});
+    }
+
+    for (const auto &sequence : sequences)
+    {
+        uint16_t node;
+        button_trie_result_e result = walk(sequence, node);
+        if ((result != BUTTON_TRIE_MATCH) && (result != BUTTON_TRIE_AMBIGUOUS))
+        {
+            fprintf(stderr, "sequence 0x%x/%u not matched\n", sequence.value, sequence.size);
+            failures++;
+            continue;
+        }
+
+        // a match is reported as final only when no longer sequence extends it
+        bool extended = false;
+        for (const auto &key : keys)
+        {
+            uint32_t mask = (sequence.size == 32) ? UINT32_MAX : ((1UL << sequence.size) - 1);
+            if ((key.first > sequence.size) && ((key.second & mask) == sequence.value))
+            {
+                extended = true;
+            }
+        }
+        if (extended != (result == BUTTON_TRIE_AMBIGUOUS))
+        {
+            fprintf(stderr, "sequence 0x%x/%u has the wrong result\n", sequence.value, sequence.size);
+            failures++;
+        }
+
+        uint32_t before = hits;
+        button_trie_execute(node);
+        if (hits != before + 1)
+        {
+            fprintf(stderr, "sequence 0x%x/%u fired %u callbacks\n", sequence.value, sequence.size, hits - before);
+            failures++;
+        }
+    }
+    return failures;
+}
+} // namespace
+
+int main()
+{
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> length(1, 10);
+    std::set<std::pair<uint8_t, uint32_t>> unique;
+    std::vector<Sequence> sequences;
+
+    while (sequences.size() < kSequences)
+    {
+        Sequence sequence;
+        sequence.size = length(random);
+        sequence.value = random() & ((1UL << sequence.size) - 1);
+        if (unique.insert({sequence.size, sequence.value}).second)
+        {
+            sequences.push_back(sequence);
+        }
+    }
+
+    button_trie_init();
+    for (const auto &sequence : sequences)
+    {
+        if (!button_trie_insert(sequence.size, sequence.value, hit))
+        {
+            fprintf(stderr, "pool exhausted after inserting sequences\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    int failures = check(sequences);
+
+    // remove every other sequence; the rest must still match and the removed
+    // ones must not fire
+    std::vector<Sequence> kept;
+    for (size_t i = 0; i < sequences.size(); i++)
+    {
+        if (i % 2)
+        {
+            if (!button_trie_remove(sequences[i].size, sequences[i].value, hit))
+            {
+                fprintf(stderr, "unable to remove 0x%x/%u\n", sequences[i].value, sequences[i].size);
+                failures++;
+            }
+        }
+        else
+        {
+            kept.push_back(sequences[i]);
+        }
+    }
+    failures += check(kept);
+    for (size_t i = 1; i < sequences.size(); i += 2)
+    {
+        uint16_t node;
+        uint32_t before = hits;
+        if (walk(sequences[i], node) != BUTTON_TRIE_NONE)
+        {
+            button_trie_execute(node);
+        }
+        if (hits != before)
+        {
+            fprintf(stderr, "removed sequence 0x%x/%u still fires\n", sequences[i].value, sequences[i].size);
+            failures++;
+        }
+    }
+
+    // removing everything must give every node back to the pool
+    for (const auto &sequence : kept)
+    {
+        button_trie_remove(sequence.size, sequence.value, hit);
+    }
+    for (const auto &sequence : sequences)
+    {
+        if (!button_trie_insert(sequence.size, sequence.value, hit))
+        {
+            fprintf(stderr, "nodes leaked on removal\n");
+            failures++;
+            break;
+        }
+    }
+
+    // timing, trie against the linear list it replaced
+    uint64_t presses = 0;
+    volatile uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++)
+    {
+        for (const auto &sequence : sequences)
+        {
+            uint16_t node;
+            sink += walk(sequence, node);
+            presses += sequence.size;
+        }
+    }
+    auto trie_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++)
+    {
+        for (const auto &sequence : sequences)
+        {
+            // the list was searched once per completed sequence
+            sink += linear_match(sequences, sequence.size, sequence.value);
+        }
+    }
+    auto linear_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    double lookups = static_cast<double>(kRounds) * sequences.size();
+    printf("%zu sequences, %u node pool\n", sequences.size(), BUTTON_TRIE_MAX_NODES);
+    printf("trie: %.1f ns per press, %.1f ns per sequence\n", trie_ns / presses, trie_ns / lookups);
+    printf("list: %.1f ns per sequence\n", linear_ns / lookups);
+    printf("%s\n", failures ? "FAILED" : "passed");
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
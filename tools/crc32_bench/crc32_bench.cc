@@ -0,0 +1,194 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "am_bootloader.h"
+
+namespace
+{
+// image sizes covering the small model up to a large model plus application
+constexpr uint32_t kImageSizes[] = {64 * 1024, 256 * 1024, 512 * 1024, 960 * 1024};
+constexpr int kRandomSizes = 2000;
+constexpr int kRounds = 20;
+
+typedef uint32_t (*crc_function)(const void *, uint32_t);
+
+struct Implementation
+{
+    const char *name;
+    crc_function crc;
+};
+
+uint32_t partial_slice8_crc32(const void *data, uint32_t size)
+{
+    uint32_t crc = 0;
+    am_bootloader_partial_slice8_crc32(data, size, &crc);
+    return crc;
+}
+
+const Implementation implementations[] = {
+    {"bitwise", am_bootloader_crc32},
+    {"table", am_bootloader_fast_crc32},
+    {"slice8", am_bootloader_slice8_crc32},
+};
+
+// every routine must agree with the bitwise reference, including on unaligned
+// buffers, odd lengths and when the image is fed in arbitrary chunks
+int check(const std::vector<uint8_t> &image, uint32_t offset, uint32_t size)
+{
+    int failures = 0;
+    const uint8_t *data = image.data() + offset;
+    uint32_t expected = am_bootloader_crc32(data, size);
+
+    for (const auto &implementation : implementations)
+    {
+        uint32_t crc = implementation.crc(data, size);
+        if (crc != expected)
+        {
+            fprintf(stderr, "%s: 0x%08x != 0x%08x at offset %u size %u\n", implementation.name, crc,
+                    expected, offset, size);
+            failures++;
+        }
+    }
+
+    std::mt19937 random(size);
+    uint32_t partial = 0;
+    uint32_t slice8 = 0;
+    for (uint32_t done = 0; done < size;)
+    {
+        uint32_t chunk = std::min<uint32_t>(size - done, random() % 4096 + 1);
+        am_bootloader_partial_crc32(data + done, chunk, &partial);
+        am_bootloader_partial_slice8_crc32(data + done, chunk, &slice8);
+        done += chunk;
+    }
+    if ((partial != expected) || (slice8 != expected))
+    {
+        fprintf(stderr, "partial: 0x%08x/0x%08x != 0x%08x at offset %u size %u\n", partial, slice8,
+                expected, offset, size);
+        failures++;
+    }
+    return failures;
+}
+
+double megabytes_per_second(crc_function crc, const std::vector<uint8_t> &image, int rounds)
+{
+    volatile uint32_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        sink = sink + crc(image.data(), image.size());
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return (double)image.size() * rounds / elapsed.count() / (1024.0 * 1024.0);
+}
+
+void benchmark(const char *name, const std::vector<uint8_t> &image)
+{
+    printf("%-24s %8zu bytes  crc 0x%08x\n", name, image.size(),
+           am_bootloader_slice8_crc32(image.data(), image.size()));
+    for (const auto &implementation : implementations)
+    {
+        // the bitwise version is an order of magnitude slower
+        int rounds = (implementation.crc == am_bootloader_crc32) ? 1 : kRounds;
+        printf("  %-8s %10.1f MB/s\n", implementation.name,
+               megabytes_per_second(implementation.crc, image, rounds));
+    }
+    printf("  %-8s %10.1f MB/s\n", "partial", megabytes_per_second(partial_slice8_crc32, image, kRounds));
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::mt19937 random(1234);
+    std::vector<uint8_t> image(kImageSizes[3] + 16);
+    for (auto &byte : image)
+    {
+        byte = random();
+    }
+
+    int failures = 0;
+
+    // known answer: slice 0 of the table is the CRC of each single byte
+    const uint8_t one = 0x01;
+    if (am_bootloader_slice8_crc32(&one, 1) != 0x1EDC6F41)
+    {
+        fprintf(stderr, "CRC of 0x01 is not the polynomial\n");
+        failures++;
+    }
+
+    for (int i = 0; i < kRandomSizes; i++)
+    {
+        failures += check(image, random() % 8, random() % 2048);
+    }
+    for (uint32_t size : kImageSizes)
+    {
+        failures += check(image, 0, size);
+        failures += check(image, 3, size + 5);
+    }
+
+    for (uint32_t size : kImageSizes)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "random %uK", size / 1024);
+        benchmark(name, std::vector<uint8_t>(image.begin(), image.begin() + size));
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::ifstream file(argv[i], std::ios::binary);
+        std::vector<uint8_t> contents((std::istreambuf_iterator<char>(file)),
+                                      std::istreambuf_iterator<char>());
+        if (!file && !file.eof())
+        {
+            fprintf(stderr, "unable to read %s\n", argv[i]);
+            failures++;
+            continue;
+        }
+        failures += check(contents, 0, contents.size());
+        benchmark(argv[i], contents);
+    }
+
+    if (failures)
+    {
+        fprintf(stderr, "%d failures\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("all CRC routines agree\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+# Package a quantized model for the model partition.  The blob starts with the
+# header described in model_partition.h and can be programmed straight to
+# MODEL_PARTITION_ADDRESS, or staged for the boot loader OTA handler with
+# OTA_INFO_OPTIONS_MODEL set so that only the model partition is rewritten.
+#
+#   python3 tools/create_model_blob.py quant_model.tflite model.bin --version 3 \
+#       --labels 0123456789 --arena 81920
+#
+# The model may also be one of the tensorflow/quant_model_*.cc arrays.  With
+# --compress the blob is written compressed for OTA_INFO_OPTIONS_COMPRESSED.
+
+import argparse
+import re
+import struct
+import sys
+
+import am_lz
+
+MAGIC = 0x504D4654
+FORMAT = 1
+HEADER_SIZE = 64
+MAX_LABELS = 16
+PARTITION_SIZE = 0x80000
+
+# boot loader CRC-32: polynomial 0x1EDC6F41, MSB first, no reflection, init 0
+POLYNOMIAL = 0x1EDC6F41
+
+
+def crc_table():
+    table = []
+    for n in range(256):
+        crc = n << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ POLYNOMIAL) if crc & 0x80000000 else (crc << 1)
+        table.append(crc & 0xFFFFFFFF)
+    return table
+
+
+TABLE = crc_table()
+
+
+def crc32(data):
+    crc = 0
+    for byte in data:
+        crc = ((crc << 8) & 0xFFFFFFFF) ^ TABLE[byte ^ (crc >> 24)]
+    return crc
+
+
+def load_model(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if not path.endswith((".cc", ".cpp", ".c")):
+        return data
+    # the array written by xxd -i, ignoring the length variable after it
+    text = data.decode("utf-8")
+    body = text[text.index("{") + 1:text.index("}")]
+    return bytes(int(value, 16) for value in re.findall(r"0x[0-9a-fA-F]{2}", body))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Create a model partition blob.")
+    parser.add_argument("model", help=".tflite file or quant_model_*.cc array")
+    parser.add_argument("output", type=argparse.FileType("wb"))
+    parser.add_argument("--version", type=int, required=True, help="model version, must not be 0")
+    parser.add_argument("--rows", type=int, default=32)
+    parser.add_argument("--columns", type=int, default=32)
+    parser.add_argument("--channels", type=int, default=3)
+    parser.add_argument("--labels", default="0123456789",
+                        help="one character per category, in output tensor order")
+    parser.add_argument("--arena", type=int, default=0,
+                        help="tensor arena bytes the model needs (\"perf memory\" reports it)")
+    parser.add_argument("--partition-size", type=lambda x: int(x, 0), default=PARTITION_SIZE)
+    parser.add_argument("--compress", action="store_true",
+                        help="compress the blob for the OTA handler, see tools/am_lz.py")
+    args = parser.parse_args()
+
+    model = load_model(args.model)
+    if not model:
+        sys.exit("no model data in %s" % args.model)
+    if args.version <= 0:
+        sys.exit("the version must be positive, 0 is the built in model")
+    if not 0 < len(args.labels) <= MAX_LABELS:
+        sys.exit("between 1 and %d labels are supported" % MAX_LABELS)
+    if HEADER_SIZE + len(model) > args.partition_size:
+        sys.exit("the model needs %d bytes, the partition holds %d" %
+                 (HEADER_SIZE + len(model), args.partition_size))
+
+    header = struct.pack("<IHHIIII4B16s16x", MAGIC, HEADER_SIZE, FORMAT, args.version,
+                         len(model), crc32(model), args.arena, args.rows, args.columns,
+                         args.channels, len(args.labels), args.labels.encode("ascii"))
+    header += struct.pack("<I", crc32(header))
+
+    blob = header + model
+    # the boot loader programs whole words
+    blob += b"\xff" * (-len(blob) % 4)
+
+    print("model version %d: %d bytes, crc 0x%08x, blob %d bytes, blob crc 0x%08x" %
+          (args.version, len(model), crc32(model), len(blob), crc32(blob)))
+
+    if args.compress:
+        compressed = am_lz.compress(blob)
+        print("compressed to %d bytes (%.1f%%)" % (len(compressed), 100.0 * len(compressed) / len(blob)))
+        blob = compressed
+
+    args.output.write(blob)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+# Convert test vectors written by training_files/local/export_vectors.py into a
+# C source file that embeds them in flash for the "bench" console command.
+#
+#   python3 tools/generate_bench_vectors.py svhn_test.bin bench_vectors.c --count 16
+#   cmake ... -DBENCH_VECTORS=/path/to/bench_vectors.c
+#
+# Frames exported with export_vectors.py --frame need --frame here too.
+
+import argparse
+import sys
+
+TENSOR_SIZE = 32 * 32 * 3
+FRAME_TENSOR_SIZE = 96 * 96 * 3
+BYTES_PER_LINE = 16
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate embedded benchmark vectors.")
+    parser.add_argument("vectors", type=argparse.FileType("rb"))
+    parser.add_argument("output", type=argparse.FileType("w"))
+    parser.add_argument("--count", type=int, default=16,
+                        help="number of vectors to embed, each costs %d bytes of flash" % TENSOR_SIZE)
+    parser.add_argument("--frame", action="store_true",
+                        help="96x96 frames for a frame model, %d bytes each" % FRAME_TENSOR_SIZE)
+    args = parser.parse_args()
+
+    tensor_size = FRAME_TENSOR_SIZE if args.frame else TENSOR_SIZE
+    data = args.vectors.read()
+    record_size = 1 + tensor_size
+    count = min(len(data) // record_size, args.count)
+    if count == 0:
+        sys.exit("no vectors found in %s" % args.vectors.name)
+
+    out = args.output
+    out.write("// Generated by tools/generate_bench_vectors.py, do not edit.\n")
+    out.write("#include \"bench.h\"\n\n")
+    out.write("static const uint8_t bench_vector_data[%d][%d] = {\n" % (count, tensor_size))
+    for index in range(count):
+        tensor = data[index * record_size + 1:(index + 1) * record_size]
+        out.write("    {\n")
+        for offset in range(0, tensor_size, BYTES_PER_LINE):
+            line = ", ".join("0x%02x" % b for b in tensor[offset:offset + BYTES_PER_LINE])
+            out.write("        %s,\n" % line)
+        out.write("    },\n")
+    out.write("};\n\n")
+
+    out.write("const bench_vector_t bench_vectors[] = {\n")
+    for index in range(count):
+        out.write("    {'%c', bench_vector_data[%d]},\n" % (data[index * record_size], index))
+    out.write("};\n\n")
+    out.write("const size_t bench_vector_count = %d;\n" % count)
+
+    print("Embedded %d vectors in %s" % (count, out.name))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,9 @@
+// Host stand in for the Apollo3 HAL header included by am_multi_boot.h; the
+// decompressor only needs the flash interface declared there.
+#ifndef AM_MCU_APOLLO_H
+#define AM_MCU_APOLLO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#endif
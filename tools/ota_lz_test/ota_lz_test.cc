@@ -0,0 +1,433 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "am_multiboot_lz.h"
+
+namespace
+{
+// the emulated devices are static so that their addresses fit in 32 bits
+constexpr uint32_t kFlashSize = 1024 * 1024;
+constexpr uint32_t kMaxSectorSize = 64 * 1024;
+constexpr uint8_t kFill = 0xA5;
+
+uint8_t staging[kFlashSize] __attribute__((aligned(kMaxSectorSize)));
+uint8_t target[kFlashSize] __attribute__((aligned(kMaxSectorSize)));
+uint32_t sector_buffer[kMaxSectorSize / 4];
+
+struct Geometry
+{
+    const char *name;
+    uint32_t page_size;
+    uint32_t sector_size;
+};
+
+// internal flash, then external SPI flashes with small pages
+const Geometry geometries[] = {
+    {"internal 8K", 8192, 8192},
+    {"spi 256/4K", 256, 4096},
+    {"spi 512/64K", 512, 65536},
+};
+
+uint32_t erases;
+uint32_t writes;
+bool write_error;
+
+uint32_t address(const void *pointer)
+{
+    return (uint32_t)(uintptr_t)pointer;
+}
+
+bool within(const uint8_t *device, uint32_t addr, uint32_t length)
+{
+    return (addr >= address(device)) && (addr + length <= address(device) + kFlashSize);
+}
+
+template <size_t I> struct Device
+{
+    static int read_page(uint32_t dest, uint32_t *src, uint32_t length)
+    {
+        uint32_t addr = address(src);
+        if ((!within(staging, addr, length) && !within(target, addr, length)) ||
+            ((addr & (geometries[I].page_size - 1)) + length > geometries[I].page_size))
+        {
+            write_error = true;
+            return -1;
+        }
+        memcpy((void *)(uintptr_t)dest, src, length);
+        return 0;
+    }
+
+    // programming can only clear bits, as on the real devices
+    static int write_page(uint32_t dest, uint32_t *src, uint32_t length)
+    {
+        if (!within(target, dest, length) || (dest & (geometries[I].page_size - 1)) || (length != geometries[I].page_size))
+        {
+            write_error = true;
+            return -1;
+        }
+        uint8_t *flash = (uint8_t *)(uintptr_t)dest;
+        const uint8_t *data = (const uint8_t *)src;
+        for (uint32_t i = 0; i < length; i++)
+        {
+            if (data[i] & ~flash[i])
+            {
+                write_error = true;
+            }
+            flash[i] &= data[i];
+        }
+        writes++;
+        return 0;
+    }
+
+    static int erase_sector(uint32_t addr)
+    {
+        if (!within(target, addr, geometries[I].sector_size) || (addr & (geometries[I].sector_size - 1)))
+        {
+            write_error = true;
+            return -1;
+        }
+        memset((void *)(uintptr_t)addr, 0xFF, geometries[I].sector_size);
+        erases++;
+        return 0;
+    }
+
+    static am_multiboot_flash_info_t info()
+    {
+        am_multiboot_flash_info_t flash = {};
+        flash.flashPageSize = geometries[I].page_size;
+        flash.flashSectorSize = geometries[I].sector_size;
+        flash.flash_read_page = read_page;
+        flash.flash_write_page = write_page;
+        flash.flash_erase_sector = erase_sector;
+        return flash;
+    }
+};
+
+std::vector<am_multiboot_flash_info_t> devices()
+{
+    return {Device<0>::info(), Device<1>::info(),
+            Device<2>::info()};
+}
+
+std::vector<uint8_t> deflate(const std::vector<uint8_t> &image, int level, int strategy,
+                             int window_bits = 11)
+{
+    z_stream stream = {};
+    deflateInit2(&stream, level, Z_DEFLATED, -window_bits, 9, strategy);
+    std::vector<uint8_t> out(deflateBound(&stream, image.size()) + 16);
+    stream.next_in = const_cast<uint8_t *>(image.data());
+    stream.avail_in = image.size();
+    stream.next_out = out.data() + sizeof(am_multiboot_lz_header_t);
+    stream.avail_out = out.size() - sizeof(am_multiboot_lz_header_t);
+    deflate(&stream, Z_FINISH);
+    out.resize(sizeof(am_multiboot_lz_header_t) + stream.total_out);
+    deflateEnd(&stream);
+
+    am_multiboot_lz_header_t header = {AM_MULTIBOOT_LZ_MAGIC, (uint32_t)image.size(),
+                                       am_bootloader_crc32(image.data(), image.size())};
+    memcpy(out.data(), &header, sizeof(header));
+    // staged images are padded to a word
+    out.resize((out.size() + 3) & ~3);
+    return out;
+}
+
+std::vector<uint8_t> inflate(const std::vector<uint8_t> &compressed)
+{
+    am_multiboot_lz_header_t header;
+    memcpy(&header, compressed.data(), sizeof(header));
+    std::vector<uint8_t> image(header.ui32Length);
+
+    z_stream stream = {};
+    inflateInit2(&stream, -15);
+    stream.next_in = const_cast<uint8_t *>(compressed.data()) + sizeof(header);
+    stream.avail_in = compressed.size() - sizeof(header);
+    stream.next_out = image.data();
+    stream.avail_out = image.size();
+    int result = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    if ((result != Z_STREAM_END) || (stream.total_out != image.size()))
+    {
+        image.clear();
+    }
+    return image;
+}
+
+uint32_t stage(const std::vector<uint8_t> &compressed)
+{
+    // a word past a page boundary, so that the first read is a partial page
+    memset(staging, 0xFF, sizeof(staging));
+    memcpy(staging + 4, compressed.data(), compressed.size());
+    return address(staging + 4);
+}
+
+bool filled(uint32_t from, uint32_t to)
+{
+    for (uint32_t i = from; i < to; i++)
+    {
+        if (target[i] != kFill)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// install and check the image, that the rest of its last sector is kept and
+// that nothing else is touched
+int install(const char *name, const std::vector<uint8_t> &image,
+            const std::vector<uint8_t> &compressed)
+{
+    int failures = 0;
+    uint32_t src = stage(compressed);
+    const uint32_t at = kMaxSectorSize;
+    auto flashes = devices();
+
+    for (size_t i = 0; i < flashes.size(); i++)
+    {
+        auto &flash = flashes[i];
+        uint32_t sectors = (image.size() + flash.flashSectorSize - 1) / flash.flashSectorSize;
+        uint32_t end = at + sectors * flash.flashSectorSize;
+
+        memset(target, kFill, sizeof(target));
+        erases = 0;
+        writes = 0;
+        write_error = false;
+
+        bool verified = am_multiboot_lz_verify((uint32_t *)(uintptr_t)src, compressed.size(), &flash);
+        bool programmed = verified && (erases == 0) && (writes == 0) &&
+                          am_multiboot_lz_program(address(target + at), (uint32_t *)(uintptr_t)src,
+                                                  compressed.size(), &flash, &flash, sector_buffer);
+
+        if (!programmed || write_error || (erases != sectors) ||
+            memcmp(target + at, image.data(), image.size()) ||
+            !filled(at + image.size(), end) || !filled(0, at) || !filled(end, kFlashSize))
+        {
+            fprintf(stderr, "%s on %s: verify %d program %d errors %d erases %u/%u\n", name,
+                    geometries[i].name, verified, programmed, write_error, erases, sectors);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// a damaged image must fail verification without touching the flash
+int reject(const char *name, const std::vector<uint8_t> &compressed, uint32_t size)
+{
+    uint32_t src = stage(compressed);
+    auto flash = devices()[0];
+
+    erases = 0;
+    writes = 0;
+    if (am_multiboot_lz_verify((uint32_t *)(uintptr_t)src, size, &flash) || erases || writes)
+    {
+        fprintf(stderr, "%s: damaged image accepted\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+int damage(const std::vector<uint8_t> &image, std::mt19937 &random)
+{
+    int failures = 0;
+    auto compressed = deflate(image, 9, Z_DEFAULT_STRATEGY);
+    uint32_t header = sizeof(am_multiboot_lz_header_t);
+
+    failures += reject("truncated", compressed, header + (compressed.size() - header) / 2);
+    failures += reject("header only", compressed, header);
+    failures += reject("short header", compressed, header - 4);
+
+    const struct
+    {
+        const char *name;
+        uint32_t word;
+        uint32_t change;
+    } fields[] = {
+        {"magic", 0, 1},
+        {"length + 1", 1, 1},
+        {"length - 1", 1, (uint32_t)-1},
+        {"crc", 2, 0x100},
+    };
+    for (const auto &field : fields)
+    {
+        auto changed = compressed;
+        uint32_t value;
+        memcpy(&value, changed.data() + field.word * 4, 4);
+        value += field.change;
+        memcpy(changed.data() + field.word * 4, &value, 4);
+        failures += reject(field.name, changed, changed.size());
+    }
+
+    // the last bytes of the stream may hold unused bits, stay clear of them
+    for (int i = 0; i < 50; i++)
+    {
+        auto changed = compressed;
+        changed[header + random() % ((compressed.size() - header) / 2)] ^= 1 << (random() % 8);
+        failures += reject("flipped bit", changed, changed.size());
+    }
+
+    // references further back than the window the boot loader keeps
+    std::vector<uint8_t> far(16384);
+    for (size_t i = 0; i < far.size(); i++)
+    {
+        far[i] = (i < 4096) ? random() : far[i - 4096];
+    }
+    failures += reject("32K window", deflate(far, 9, Z_DEFAULT_STRATEGY, 15), UINT32_MAX);
+    return failures;
+}
+
+std::vector<uint8_t> read_file(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)),
+                                std::istreambuf_iterator<char>());
+}
+
+void report(const char *name, size_t size, size_t compressed)
+{
+    printf("%-32s %8zu -> %8zu bytes (%5.1f%%)\n", name, size, compressed,
+           size ? 100.0 * compressed / size : 0.0);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::mt19937 random(1234);
+    int failures = 0;
+
+    // int8 weights look like noise around a few values, the code like text
+    std::vector<uint8_t> weights(200003);
+    std::normal_distribution<double> normal(0.0, 12.0);
+    for (auto &byte : weights)
+    {
+        byte = (int8_t)std::max(-128.0, std::min(127.0, normal(random)));
+    }
+    std::vector<uint8_t> noise(50001);
+    for (auto &byte : noise)
+    {
+        byte = random();
+    }
+    std::string text;
+    while (text.size() < 100000)
+    {
+        text += "mov r0, #" + std::to_string(random() % 64) + "; bl am_hal_gpio_state_write\n";
+    }
+
+    const struct
+    {
+        const char *name;
+        std::vector<uint8_t> image;
+    } images[] = {
+        {"empty", {}},
+        {"one byte", {0x42}},
+        {"zeros", std::vector<uint8_t>(70000, 0)},
+        {"weights", weights},
+        {"noise", noise},
+        {"text", std::vector<uint8_t>(text.begin(), text.end())},
+    };
+    const struct
+    {
+        const char *name;
+        int level;
+        int strategy;
+    } modes[] = {
+        {"dynamic", 9, Z_DEFAULT_STRATEGY},
+        {"fixed", 9, Z_FIXED},
+        {"stored", 0, Z_DEFAULT_STRATEGY},
+        {"huffman", 9, Z_HUFFMAN_ONLY},
+        {"rle", 9, Z_RLE},
+    };
+
+    for (const auto &image : images)
+    {
+        for (const auto &mode : modes)
+        {
+            std::string name = std::string(image.name) + " " + mode.name;
+            failures += install(name.c_str(), image.image,
+                                deflate(image.image, mode.level, mode.strategy));
+        }
+    }
+    failures += damage(weights, random);
+
+    for (const auto &image : images)
+    {
+        report(image.name, image.image.size(), deflate(image.image, 9, Z_DEFAULT_STRATEGY).size());
+    }
+
+    // images compressed by tools/am_lz.py are installed as they are, anything
+    // else is compressed here first
+    for (int i = 1; i < argc; i++)
+    {
+        std::string path = argv[i];
+        std::vector<uint8_t> contents = read_file(argv[i]);
+        std::vector<uint8_t> image, compressed;
+
+        if (path.size() > 3 && path.compare(path.size() - 3, 3, ".lz") == 0)
+        {
+            compressed = contents;
+            image = inflate(compressed);
+        }
+        else
+        {
+            image = contents;
+            compressed = deflate(image, 9, Z_DEFAULT_STRATEGY);
+        }
+
+        if (image.empty() || (image.size() + kMaxSectorSize > kFlashSize))
+        {
+            fprintf(stderr, "unable to use %s\n", argv[i]);
+            failures++;
+            continue;
+        }
+        failures += install(argv[i], image, compressed);
+        report(argv[i], image.size(), compressed.size());
+    }
+
+    if (failures)
+    {
+        fprintf(stderr, "%d failures\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("all images installed\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+# Print the SRAM used by the firmware, grouped by subsystem, from the symbol
+# table of the linked image.  Run automatically after every build; with
+# -DSTATIC_ALLOCATION=ON every task stack and RTOS object is a named symbol and
+# shows up in its own group instead of inside the FreeRTOS heap.  With
+# --flash-limit it also fails when the image grows into the flash above the
+# limit, such as the model partition.  With --retained it fails unless each
+# named object is in .noinit, outside the ranges the startup code zeroes
+# (_sbss to _ebss) and copies from flash (_sdata to _edata).  The linker script
+# comes from the SDK, and this is how TFLM_SNAPSHOT knows it has a .noinit.
+#
+#   python3 tools/ram_budget.py --nm arm-none-eabi-nm tflm_digits.axf
+
+import argparse
+import re
+import subprocess
+import sys
+
+# Apollo3 SRAM
+DEFAULT_SRAM = 384 * 1024
+SRAM_BASE = 0x10000000
+
+# first match wins
+GROUPS = [
+    ("heap", r"^ucHeap$"),
+    ("tensor arena", r"tensor_arena|interpreter_storage"),
+    ("camera buffers", r"^(pipeline_frames|image_\w+|camera_raw\w*|overlay_fallback|rpc_tensor\w*|rpc_preprocess\w*)$"),
+    ("task stacks", r"(_stack|^uxIdleTaskStack|^uxTimerTaskStack)$"),
+    ("rtos objects", r"_(tcb|queue|storage|timer|semaphore|stream)$|^(xIdleTaskTCB|xTimerTaskTCB)"),
+    ("logger", r"^logger_"),
+    ("console", r"^(console_|stream_buffer|uart_|rx_batch|cmd_)"),
+    ("rpc", r"^rpc_"),
+    ("bench", r"^bench_"),
+    ("tflm", r"tflite|^(\(anonymous namespace\)::)"),
+]
+
+# sections of RAM the startup code writes, by their start and end symbols
+STARTUP_RANGES = [("_sbss", "_ebss"), ("_sdata", "_edata")]
+RETAINED_SECTION = ".noinit"
+
+RAM_TYPES = "bBdDsS"
+# initialised data is copied out of flash at startup
+DATA_TYPES = "dD"
+
+
+def load_symbols(nm, image):
+    output = subprocess.run([nm, "-S", "-C", "--size-sort", image],
+                            check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    for line in output.splitlines():
+        fields = line.split(maxsplit=3)
+        if len(fields) < 4:
+            continue
+        # function local statics carry a numeric suffix
+        name = re.sub(r"\.\d+$", "", fields[3])
+        yield name, fields[2], int(fields[0], 16), int(fields[1], 16)
+
+
+def load_sections(objdump, image):
+    output = subprocess.run([objdump, "-t", "-C", image],
+                            check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout
+    for line in output.splitlines():
+        # address, seven flag characters, section, size, name
+        match = re.match(r"^([0-9a-fA-F]+) .{7} (\S+)\s+([0-9a-fA-F]+)\s+(.+)$", line)
+        if match:
+            yield match.group(4).strip(), match.group(2), int(match.group(1), 16), int(match.group(3), 16)
+
+
+def check_retained(objdump, image, names):
+    symbols = list(load_sections(objdump, image))
+    addresses = {name: address for name, _, address, _ in symbols}
+    ranges = []
+    for start, end in STARTUP_RANGES:
+        if (start not in addresses) or (end not in addresses):
+            return "the linker script defines no %s and %s to check against" % (start, end)
+        ranges.append((addresses[start], addresses[end]))
+
+    for name in names:
+        # objects in an anonymous namespace are qualified
+        found = [s for s in symbols if re.search(r"(^|::)%s$" % re.escape(name), s[0])]
+        if not found:
+            return "%s is not in the image" % name
+        for symbol, section, address, size in found:
+            if section != RETAINED_SECTION:
+                return "%s is in %s, not %s" % (symbol, section, RETAINED_SECTION)
+            for start, end in ranges:
+                if (address < end) and (start < address + size):
+                    return "%s at 0x%08x is cleared by the startup code" % (symbol, address)
+    return None
+
+
+def flash_end(symbols):
+    end = 0
+    data = 0
+    for _, kind, address, size in symbols:
+        if address < SRAM_BASE:
+            end = max(end, address + size)
+        elif kind in DATA_TYPES:
+            data += size
+    return end + data
+
+
+def classify(name):
+    for group, pattern in GROUPS:
+        if re.search(pattern, name):
+            return group
+    return "other"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Print the SRAM budget of a firmware image.")
+    parser.add_argument("image")
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--sram", type=int, default=DEFAULT_SRAM, help="SRAM size in bytes")
+    parser.add_argument("--verbose", action="store_true", help="list every symbol")
+    parser.add_argument("--flash-limit", type=lambda x: int(x, 0),
+                        help="fail when the image reaches this flash address")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump")
+    parser.add_argument("--retained", action="append", default=[], metavar="NAME",
+                        help="fail unless NAME survives a reset in %s, may be repeated" % RETAINED_SECTION)
+    args = parser.parse_args()
+
+    symbols = list(load_symbols(args.nm, args.image))
+    totals = {}
+    members = {}
+    for name, kind, _, size in symbols:
+        if kind not in RAM_TYPES:
+            continue
+        group = classify(name)
+        totals[group] = totals.get(group, 0) + size
+        members.setdefault(group, []).append((size, name))
+
+    if not totals:
+        sys.exit("no RAM symbols found in %s" % args.image)
+
+    used = sum(totals.values())
+    order = [group for group, _ in GROUPS] + ["other"]
+    print("SRAM budget for %s" % args.image)
+    for group in order:
+        if group not in totals:
+            continue
+        print("  %-16s %8d bytes  %5.1f%%" % (group, totals[group], 100.0 * totals[group] / args.sram))
+        if args.verbose:
+            for size, name in sorted(members[group], reverse=True):
+                print("      %8d  %s" % (size, name))
+    print("  %-16s %8d bytes  %5.1f%%" % ("total", used, 100.0 * used / args.sram))
+    print("  %-16s %8d bytes" % ("free", args.sram - used))
+
+    if args.flash_limit is not None:
+        end = flash_end(symbols)
+        print("flash used up to 0x%08x, limit 0x%08x" % (end, args.flash_limit))
+        if end > args.flash_limit:
+            sys.exit("image overlaps the flash above 0x%08x" % args.flash_limit)
+
+    if args.retained:
+        error = check_retained(args.objdump, args.image, args.retained)
+        if error:
+            sys.exit("%s: %s" % (RETAINED_SECTION, error))
+        print("%s keeps %s across a reset" % (RETAINED_SECTION, ", ".join(args.retained)))
+
+
+if __name__ == "__main__":
+    main()
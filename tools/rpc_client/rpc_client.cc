@@ -0,0 +1,526 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "rpc_link.h"
+#include "rpc_protocol.h"
+#include "serial_port.h"
+
+namespace
+{
+void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options] <device> <command> [arguments]\n"
+            "\n"
+            "options:\n"
+            "  -b <baudrate>   serial baudrate (default 115200)\n"
+            "  -v              echo console output to stderr\n"
+            "\n"
+            "commands:\n"
+            "  info                    report model and protocol details\n"
+            "  infer-tensor <file>     run inference on a preprocessed int8 tensor\n"
+            "  infer-frame <file>      run inference on a raw 96x96 RGB565 frame\n"
+            "  read-tensor <file>      save the tensor currently staged on the device\n"
+            "  batch <file> [count]    run labelled test vectors and report accuracy\n"
+            "                          (records of one ASCII label followed by the\n"
+            "                          tensor, see training_files/local/export_vectors.py)\n"
+            "  loopback [count] [size] [window]\n"
+            "                          echo frames of size bytes through the device,\n"
+            "                          keeping up to window requests in flight, and\n"
+            "                          report throughput and receive overflows\n",
+            program);
+}
+
+bool read_file(const std::string &filename, std::vector<uint8_t> &data)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+void put_u16(std::vector<uint8_t> &buffer, uint16_t value)
+{
+    buffer.push_back(value & 0xFF);
+    buffer.push_back((value >> 8) & 0xFF);
+}
+
+bool check_status(const RpcFrame &response, const char *what)
+{
+    if (response.payload.empty() || (response.payload[0] != RPC_STATUS_OK))
+    {
+        fprintf(stderr,
+                "%s failed with status %d\n",
+                what,
+                response.payload.empty() ? -1 : response.payload[0]);
+        return false;
+    }
+    return true;
+}
+
+bool get_info(RpcLink &link, rpc_info_t &info)
+{
+    RpcFrame response;
+    if (!link.Transact(RPC_COMMAND_INFO, {}, response) || (response.payload.size() < sizeof(info)))
+    {
+        fprintf(stderr, "no response to info request\n");
+        return false;
+    }
+    memcpy(&info, response.payload.data(), sizeof(info));
+    return check_status(response, "info");
+}
+
+bool upload_tensor(RpcLink &link, const uint8_t *tensor, size_t size)
+{
+    constexpr size_t kChunk = RPC_MAX_PAYLOAD - 2;
+
+    for (size_t offset = 0; offset < size; offset += kChunk)
+    {
+        size_t count = std::min(kChunk, size - offset);
+        std::vector<uint8_t> payload;
+        put_u16(payload, offset);
+        payload.insert(payload.end(), tensor + offset, tensor + offset + count);
+
+        RpcFrame response;
+        if (!link.Transact(RPC_COMMAND_TENSOR_WRITE, payload, response) ||
+            !check_status(response, "tensor write"))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool upload_frame(RpcLink &link, const rpc_info_t &info, const std::vector<uint8_t> &frame)
+{
+    const size_t row_size = info.frame_width * 2;
+    const size_t rows_per_chunk = (RPC_MAX_PAYLOAD - 2) / row_size;
+
+    if (frame.size() != row_size * info.frame_height)
+    {
+        fprintf(stderr,
+                "frame must be %zu bytes (%dx%d RGB565)\n",
+                row_size * info.frame_height,
+                info.frame_width,
+                info.frame_height);
+        return false;
+    }
+
+    for (size_t row = 0; row < info.frame_height; row += rows_per_chunk)
+    {
+        size_t rows = std::min(rows_per_chunk, info.frame_height - row);
+        std::vector<uint8_t> payload;
+        put_u16(payload, row);
+        payload.insert(payload.end(),
+                       frame.begin() + row * row_size,
+                       frame.begin() + (row + rows) * row_size);
+
+        RpcFrame response;
+        if (!link.Transact(RPC_COMMAND_FRAME_WRITE, payload, response) ||
+            !check_status(response, "frame write"))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool infer(RpcLink &link, rpc_source_e source, rpc_result_t &result, std::vector<int8_t> &scores)
+{
+    RpcFrame response;
+    if (!link.Transact(RPC_COMMAND_INFER, {static_cast<uint8_t>(source)}, response) ||
+        !check_status(response, "inference"))
+    {
+        return false;
+    }
+
+    if (response.payload.size() < sizeof(result))
+    {
+        fprintf(stderr, "short inference response\n");
+        return false;
+    }
+
+    memcpy(&result, response.payload.data(), sizeof(result));
+    scores.assign(response.payload.begin() + sizeof(result), response.payload.end());
+    return true;
+}
+
+void print_result(const rpc_info_t &info, const rpc_result_t &result, const std::vector<int8_t> &scores)
+{
+    printf("result: %c\n", result.label);
+    printf("confidence: %d\n", result.confidence);
+    printf("preprocess: %.1f ms\n", result.preprocess_ticks * 1000.0 / info.tick_rate_hz);
+    printf("inference: %.1f ms\n", result.inference_ticks * 1000.0 / info.tick_rate_hz);
+    for (size_t i = 0; i < scores.size(); i++)
+    {
+        printf("  %c: %d\n", info.labels[i], scores[i] + 128);
+    }
+}
+
+int command_info(RpcLink &link)
+{
+    rpc_info_t info;
+    if (!get_info(link, info))
+    {
+        return EXIT_FAILURE;
+    }
+
+    printf("protocol: %d\n", info.version);
+    printf("input: %dx%dx%d (%d bytes)\n", info.rows, info.columns, info.channels, info.tensor_size);
+    printf("frame: %dx%d RGB565\n", info.frame_width, info.frame_height);
+    printf("categories: %.*s\n", info.categories, info.labels);
+    printf("tick rate: %u Hz\n", info.tick_rate_hz);
+    return EXIT_SUCCESS;
+}
+
+int command_infer(RpcLink &link, rpc_source_e source, const std::string &filename)
+{
+    rpc_info_t info;
+    std::vector<uint8_t> data;
+    rpc_result_t result;
+    std::vector<int8_t> scores;
+
+    if (!get_info(link, info))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (!read_file(filename, data))
+    {
+        fprintf(stderr, "unable to read %s\n", filename.c_str());
+        return EXIT_FAILURE;
+    }
+
+    if (source == RPC_SOURCE_TENSOR)
+    {
+        if (data.size() != info.tensor_size)
+        {
+            fprintf(stderr, "tensor must be %d bytes\n", info.tensor_size);
+            return EXIT_FAILURE;
+        }
+        if (!upload_tensor(link, data.data(), data.size()))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    else if (!upload_frame(link, info, data))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (!infer(link, source, result, scores))
+    {
+        return EXIT_FAILURE;
+    }
+
+    print_result(info, result, scores);
+    return EXIT_SUCCESS;
+}
+
+int command_read_tensor(RpcLink &link, const std::string &filename)
+{
+    rpc_info_t info;
+    std::vector<uint8_t> tensor;
+
+    if (!get_info(link, info))
+    {
+        return EXIT_FAILURE;
+    }
+
+    while (tensor.size() < info.tensor_size)
+    {
+        std::vector<uint8_t> payload;
+        put_u16(payload, tensor.size());
+
+        RpcFrame response;
+        if (!link.Transact(RPC_COMMAND_TENSOR_READ, payload, response) ||
+            !check_status(response, "tensor read") || (response.payload.size() < 2))
+        {
+            return EXIT_FAILURE;
+        }
+        tensor.insert(tensor.end(), response.payload.begin() + 1, response.payload.end());
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(tensor.data()), tensor.size());
+    return file ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int command_batch(RpcLink &link, const std::string &filename, size_t limit)
+{
+    rpc_info_t info;
+    std::vector<uint8_t> data;
+
+    if (!get_info(link, info))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (!read_file(filename, data))
+    {
+        fprintf(stderr, "unable to read %s\n", filename.c_str());
+        return EXIT_FAILURE;
+    }
+
+    const size_t record_size = 1 + info.tensor_size;
+    size_t count = data.size() / record_size;
+    if ((limit > 0) && (limit < count))
+    {
+        count = limit;
+    }
+
+    size_t correct = 0;
+    size_t failed = 0;
+    uint64_t total_ticks = 0;
+    uint32_t min_ticks = UINT32_MAX;
+    uint32_t max_ticks = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t *record = &data[i * record_size];
+        rpc_result_t result;
+        std::vector<int8_t> scores;
+
+        if (!upload_tensor(link, record + 1, info.tensor_size) ||
+            !infer(link, RPC_SOURCE_TENSOR, result, scores))
+        {
+            failed++;
+            continue;
+        }
+
+        if (result.label == record[0])
+        {
+            correct++;
+        }
+        total_ticks += result.inference_ticks;
+        min_ticks = std::min(min_ticks, result.inference_ticks);
+        max_ticks = std::max(max_ticks, result.inference_ticks);
+
+        if (((i + 1) % 100) == 0)
+        {
+            fprintf(stderr, "%zu/%zu\r", i + 1, count);
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t completed = count - failed;
+    printf("vectors: %zu (%zu failed)\n", count, failed);
+    if (completed > 0)
+    {
+        double scale = 1000.0 / info.tick_rate_hz;
+        printf("accuracy: %.2f%%\n", 100.0 * correct / completed);
+        printf("inference: min %.1f ms, mean %.1f ms, max %.1f ms\n",
+               min_ticks * scale,
+               total_ticks * scale / completed,
+               max_ticks * scale);
+        printf("throughput: %.2f vectors/s end to end\n", completed / elapsed);
+    }
+    printf("link: %u retries, %u crc errors\n", link.retries(), link.crc_errors());
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+bool get_link_stats(RpcLink &link, rpc_link_stats_t &stats)
+{
+    RpcFrame response;
+    if (!link.Transact(RPC_COMMAND_LINK_STATS, {}, response) ||
+        (response.payload.size() < sizeof(stats)))
+    {
+        fprintf(stderr, "no response to link statistics request\n");
+        return false;
+    }
+    memcpy(&stats, response.payload.data(), sizeof(stats));
+    return check_status(response, "link statistics");
+}
+
+int command_loopback(RpcLink &link, size_t count, size_t size, size_t window)
+{
+    rpc_link_stats_t before, after;
+
+    size = std::min<size_t>(size, RPC_MAX_PAYLOAD);
+    window = std::max<size_t>(window, 1);
+
+    if (!get_link_stats(link, before))
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint8_t> payload(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        payload[i] = i & 0xFF;
+    }
+
+    size_t posted = 0;
+    size_t received = 0;
+    size_t mismatched = 0;
+    size_t lost = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (received + lost < count)
+    {
+        while ((posted < count) && ((posted - received - lost) < window))
+        {
+            if (!link.Post(RPC_COMMAND_ECHO, payload))
+            {
+                fprintf(stderr, "write failed\n");
+                return EXIT_FAILURE;
+            }
+            posted++;
+        }
+
+        RpcFrame response;
+        if (!link.Collect(response))
+        {
+            // every request still in flight is assumed lost
+            lost += posted - received - lost;
+            continue;
+        }
+        if (response.command != (RPC_COMMAND_ECHO | RPC_RESPONSE_FLAG))
+        {
+            continue;
+        }
+        if (response.payload != payload)
+        {
+            mismatched++;
+        }
+        received++;
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!get_link_stats(link, after))
+    {
+        return EXIT_FAILURE;
+    }
+
+    size_t frame_size = RPC_HEADER_SIZE + size + RPC_CRC_SIZE;
+    printf("frames: %zu of %zu bytes, window %zu\n", count, frame_size, window);
+    printf("echoed: %zu (%zu lost, %zu corrupted)\n", received, lost, mismatched);
+    printf("elapsed: %.2f s\n", elapsed);
+    printf("throughput: %.0f bytes/s each way\n", received * frame_size / elapsed);
+    printf("device: %u bytes in %u reads, %u dropped, %u overruns, %u crc errors\n",
+           after.rx_bytes - before.rx_bytes,
+           after.rx_batches - before.rx_batches,
+           after.rx_dropped - before.rx_dropped,
+           after.rx_overruns - before.rx_overruns,
+           after.crc_errors - before.crc_errors);
+
+    return (lost || mismatched) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint32_t baudrate = 115200;
+    bool echo = false;
+    int arg = 1;
+
+    for (; (arg < argc) && (argv[arg][0] == '-'); arg++)
+    {
+        if ((strcmp(argv[arg], "-b") == 0) && ((arg + 1) < argc))
+        {
+            baudrate = strtoul(argv[++arg], nullptr, 0);
+        }
+        else if (strcmp(argv[arg], "-v") == 0)
+        {
+            echo = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ((argc - arg) < 2)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string device = argv[arg++];
+    std::string command = argv[arg++];
+
+    SerialPort port;
+    if (!port.Open(device, baudrate))
+    {
+        fprintf(stderr, "unable to open %s\n", device.c_str());
+        return EXIT_FAILURE;
+    }
+
+    RpcLink link(port);
+    link.SetEcho(echo);
+
+    if (command == "info")
+    {
+        return command_info(link);
+    }
+    else if ((command == "infer-tensor") && (arg < argc))
+    {
+        return command_infer(link, RPC_SOURCE_TENSOR, argv[arg]);
+    }
+    else if ((command == "infer-frame") && (arg < argc))
+    {
+        return command_infer(link, RPC_SOURCE_FRAME, argv[arg]);
+    }
+    else if ((command == "read-tensor") && (arg < argc))
+    {
+        return command_read_tensor(link, argv[arg]);
+    }
+    else if ((command == "batch") && (arg < argc))
+    {
+        size_t limit = ((arg + 1) < argc) ? strtoul(argv[arg + 1], nullptr, 0) : 0;
+        return command_batch(link, argv[arg], limit);
+    }
+    else if (command == "loopback")
+    {
+        size_t count = (arg < argc) ? strtoul(argv[arg], nullptr, 0) : 100;
+        size_t size = ((arg + 1) < argc) ? strtoul(argv[arg + 1], nullptr, 0) : 256;
+        size_t window = ((arg + 2) < argc) ? strtoul(argv[arg + 2], nullptr, 0) : 1;
+        link.SetTimeout(500);
+        return command_loopback(link, count, size, window);
+    }
+
+    usage(argv[0]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,167 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <cstdio>
+
+#include "rpc_link.h"
+
+namespace
+{
+constexpr int kMaxAttempts = 3;
+} // namespace
+
+bool RpcLink::Transact(uint8_t command,
+                       const std::vector<uint8_t> &payload,
+                       RpcFrame &response)
+{
+    for (int attempt = 0; attempt < kMaxAttempts; attempt++)
+    {
+        uint8_t sequence = ++sequence_;
+
+        if (attempt > 0)
+        {
+            retries_++;
+        }
+
+        if (!Send(command, sequence, payload))
+        {
+            return false;
+        }
+
+        while (Receive(response))
+        {
+            // stale responses from an earlier, timed out attempt are dropped
+            if ((response.sequence == sequence) &&
+                (response.command == (command | RPC_RESPONSE_FLAG)))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+bool RpcLink::Post(uint8_t command, const std::vector<uint8_t> &payload)
+{
+    return Send(command, ++sequence_, payload);
+}
+
+bool RpcLink::Send(uint8_t command, uint8_t sequence, const std::vector<uint8_t> &payload)
+{
+    if (payload.size() > RPC_MAX_PAYLOAD)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> frame;
+    frame.reserve(RPC_HEADER_SIZE + payload.size() + RPC_CRC_SIZE);
+    frame.push_back(RPC_SYNC);
+    frame.push_back(RPC_PROTOCOL_VERSION);
+    frame.push_back(command);
+    frame.push_back(sequence);
+    frame.push_back(payload.size() & 0xFF);
+    frame.push_back((payload.size() >> 8) & 0xFF);
+    frame.insert(frame.end(), payload.begin(), payload.end());
+
+    uint16_t crc = rpc_crc16(RPC_CRC_INIT, &frame[1], frame.size() - 1);
+    frame.push_back(crc & 0xFF);
+    frame.push_back((crc >> 8) & 0xFF);
+
+    return port_.Write(frame.data(), frame.size());
+}
+
+bool RpcLink::ReadByte(uint8_t &ch)
+{
+    return port_.Read(&ch, 1, timeout_ms_) == 1;
+}
+
+bool RpcLink::Receive(RpcFrame &frame)
+{
+    uint8_t header[RPC_HEADER_SIZE];
+    uint8_t ch;
+
+    while (true)
+    {
+        if (!ReadByte(ch))
+        {
+            return false;
+        }
+
+        if (ch != RPC_SYNC)
+        {
+            if (echo_)
+            {
+                fputc(ch, stderr);
+            }
+            continue;
+        }
+
+        header[0] = ch;
+        size_t received = 1;
+        while (received < RPC_HEADER_SIZE)
+        {
+            if (!ReadByte(header[received]))
+            {
+                return false;
+            }
+            received++;
+        }
+
+        uint16_t length = header[4] | (header[5] << 8);
+        if ((header[1] != RPC_PROTOCOL_VERSION) || (length > RPC_MAX_PAYLOAD))
+        {
+            continue;
+        }
+
+        std::vector<uint8_t> body(length + RPC_CRC_SIZE);
+        for (auto &byte : body)
+        {
+            if (!ReadByte(byte))
+            {
+                return false;
+            }
+        }
+
+        uint16_t crc = rpc_crc16(RPC_CRC_INIT, &header[1], RPC_HEADER_SIZE - 1);
+        crc = rpc_crc16(crc, body.data(), length);
+        if (crc != (body[length] | (body[length + 1] << 8)))
+        {
+            crc_errors_++;
+            continue;
+        }
+
+        frame.command = header[2];
+        frame.sequence = header[3];
+        frame.payload.assign(body.begin(), body.begin() + length);
+        return true;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2023, Northern Mechatronics, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef _RPC_LINK_H_
+#define _RPC_LINK_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "rpc_protocol.h"
+#include "serial_port.h"
+
+struct RpcFrame
+{
+    uint8_t command = 0;
+    uint8_t sequence = 0;
+    std::vector<uint8_t> payload;
+};
+
+// Request/response transport over the console UART.  Anything that is not a
+// valid frame (console text, prompts, inference logs) is skipped, and passed
+// to stderr when echo is enabled.
+class RpcLink
+{
+public:
+    explicit RpcLink(SerialPort &port) : port_(port) {}
+
+    void SetEcho(bool echo) { echo_ = echo; }
+    void SetTimeout(uint32_t timeout_ms) { timeout_ms_ = timeout_ms; }
+
+    bool Transact(uint8_t command, const std::vector<uint8_t> &payload, RpcFrame &response);
+
+    // Pipelined use: queue requests without waiting for each response, then
+    // collect the responses in order.  No retries are made.
+    bool Post(uint8_t command, const std::vector<uint8_t> &payload);
+    bool Collect(RpcFrame &response) { return Receive(response); }
+
+    uint32_t crc_errors() const { return crc_errors_; }
+    uint32_t retries() const { return retries_; }
+
+private:
+    bool Send(uint8_t command, uint8_t sequence, const std::vector<uint8_t> &payload);
+    bool Receive(RpcFrame &frame);
+    bool ReadByte(uint8_t &ch);
+
+    SerialPort &port_;
+    bool echo_ = false;
+    uint32_t timeout_ms_ = 2000;
+    uint8_t sequence_ = 0;
+    uint32_t crc_errors_ = 0;
+    uint32_t retries_ = 0;
+};
+
+#endif
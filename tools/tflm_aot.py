@@ -0,0 +1,1024 @@
+#!/usr/bin/env python3
+# Ahead of time compiler for the int8 digit models.  Turns a .tflite file or one
+# of the tensorflow/quant_model_*.cc arrays into C++ that calls the kernels in
+# tensorflow/aot_kernels.h one layer after the other.  Shapes, quantization
+# multipliers and the tensor arena layout are worked out here, the way the
+# interpreter would in AllocateTensors(), so the firmware carries neither the
+# interpreter nor the flatbuffer.  CMake runs it with -DTFLM_AOT=ON:
+#
+#   python3 tools/tflm_aot.py tensorflow/quant_model_opt.cc aot_model.cc
+#
+# Only the operators used by the digit models are supported; anything else is
+# reported and the interpreter has to be used instead.
+#
+# A model with several outputs is treated as a trunk with early exit heads
+# (training_files/local/ocr_model.py --exits).  The operators are split into
+# one segment per output, shallowest first, so the firmware can run a segment,
+# look at that head's scores and stop.  aot_model_invoke_layer() runs a single
+# layer so the firmware can also yield or give up between layers.
+#
+# With --sparse, convolution and fully connected filters that have at most two
+# non-zero weights in every four consecutive input channels (2:4 structured
+# sparsity, training_files/local/train.py --prune) are packed and run by the
+# sparse kernels.  --prune zeroes the two smallest weights of every group first,
+# so the kernels can be measured on a model that was not trained sparse; its
+# accuracy drops.
+#
+# With --winograd, 3x3 convolutions with a stride and dilation of 1 carry their
+# filters transformed for Winograd F(2x2, 3x3) and take 16 multiplies per 2x2
+# block of outputs and input channel instead of 36.  The transform is kept in
+# integers, so the results do not change; a layer whose sums could overflow
+# int32 stays on the direct kernel.  Packed sparse layers are not transformed.
+#
+# With --patches N, the convolution, pool and per channel ADD and MUL layers at
+# the start of the model run as N bands of rows, one band after the other, each
+# with the rows of halo its filters need.  Only a band of the feature maps
+# between them is kept, so a larger input fits in a smaller arena; the stage
+# ends where the arena is smallest.  The halo rows are computed twice.
+#
+# With --frame ROWSxCOLUMNS, the model is compiled fully convolutionally for a
+# whole camera frame.  The layers before the flatten run once over the frame,
+# the first fully connected layer becomes a convolution as large as the
+# feature map of one window, and the later ones become 1x1 convolutions.  The
+# output is then a grid of scores, one set for every window of the model's
+# input size, stepping by the stride of the layers before the flatten.
+
+import argparse
+import math
+import os
+import struct
+import sys
+
+from create_model_blob import load_model
+
+ALIGNMENT = 16
+VALUES_PER_LINE = 16
+
+# schema.fbs enumerations
+TYPE_INT32 = 2
+TYPE_INT8 = 9
+ADD = 0
+CONV_2D = 3
+FULLY_CONNECTED = 9
+MAX_POOL_2D = 17
+MUL = 18
+RESHAPE = 22
+SOFTMAX = 25
+PADDING_SAME = 0
+WINOGRAD_MAX_DEPTH = 64   # AOT_WINOGRAD_MAX_DEPTH in aot_kernels.h
+WINOGRAD_G = ((2, 0, 0), (1, 1, 1), (1, -1, 1), (0, 0, 2))   # twice G
+WINOGRAD_AT = ((1, 1, 1, 0), (0, 1, -1, -1))
+INT32_MAX = (1 << 31) - 1
+ACTIVATIONS = {0: "NONE", 1: "RELU", 2: "RELU_N1_TO_1", 3: "RELU6"}
+
+
+class Table:
+    """Read only view of a flatbuffer table."""
+
+    def __init__(self, data, position):
+        self.data = data
+        self.position = position
+        self.vtable = position - struct.unpack_from("<i", data, position)[0]
+        self.vtable_size = struct.unpack_from("<H", data, self.vtable)[0]
+
+    def _offset(self, field):
+        entry = 4 + 2 * field
+        if entry >= self.vtable_size:
+            return 0
+        return struct.unpack_from("<H", self.data, self.vtable + entry)[0]
+
+    def scalar(self, field, fmt, default=0):
+        offset = self._offset(field)
+        if not offset:
+            return default
+        return struct.unpack_from("<" + fmt, self.data, self.position + offset)[0]
+
+    def _indirect(self, field):
+        offset = self._offset(field)
+        if not offset:
+            return None
+        position = self.position + offset
+        return position + struct.unpack_from("<I", self.data, position)[0]
+
+    def table(self, field):
+        position = self._indirect(field)
+        return Table(self.data, position) if position is not None else None
+
+    def vector(self, field, fmt):
+        position = self._indirect(field)
+        if position is None:
+            return []
+        count = struct.unpack_from("<I", self.data, position)[0]
+        return list(struct.unpack_from("<%d%s" % (count, fmt), self.data, position + 4))
+
+    def tables(self, field):
+        position = self._indirect(field)
+        if position is None:
+            return []
+        count = struct.unpack_from("<I", self.data, position)[0]
+        result = []
+        for index in range(count):
+            entry = position + 4 + 4 * index
+            result.append(Table(self.data, entry + struct.unpack_from("<I", self.data, entry)[0]))
+        return result
+
+    def bytes(self, field):
+        position = self._indirect(field)
+        if position is None:
+            return b""
+        count = struct.unpack_from("<I", self.data, position)[0]
+        return bytes(self.data[position + 4:position + 4 + count])
+
+
+class Tensor:
+    def __init__(self, index, table, buffers):
+        self.index = index
+        self.shape = table.vector(0, "i")
+        self.type = table.scalar(1, "b")
+        self.data = buffers[table.scalar(2, "I")]
+        quantization = table.table(4)
+        self.scales = quantization.vector(2, "f") if quantization else []
+        self.zero_points = quantization.vector(3, "q") if quantization else []
+        # arena offset, or the tensor this one shares its data with
+        self.offset = None
+        self.alias = None
+
+    @property
+    def scale(self):
+        return self.scales[0]
+
+    @property
+    def zero_point(self):
+        return self.zero_points[0] if self.zero_points else 0
+
+    @property
+    def size(self):
+        return math.prod(self.shape) * (4 if self.type == TYPE_INT32 else 1)
+
+    @property
+    def constant(self):
+        return len(self.data) > 0
+
+    def root(self):
+        return self.alias.root() if self.alias else self
+
+    def values(self):
+        fmt = "i" if self.type == TYPE_INT32 else "b"
+        return list(struct.unpack("<%d%s" % (len(self.data) // struct.calcsize(fmt), fmt), self.data))
+
+
+def fail(message):
+    sys.exit("tflm_aot: " + message)
+
+
+def f32(value):
+    """Round a double to float, for the parts TFLM computes in float."""
+    return struct.unpack("<f", struct.pack("<f", value))[0]
+
+
+def quantize_multiplier(value):
+    """tflite::QuantizeMultiplier()"""
+    if value == 0.0:
+        return 0, 0
+    fraction, shift = math.frexp(value)
+    fixed = int(math.floor(fraction * (1 << 31) + 0.5))
+    if fixed == (1 << 31):
+        fixed //= 2
+        shift += 1
+    if shift < -31:
+        return 0, 0
+    return fixed, shift
+
+
+def activation_range(activation, output):
+    """tflite::CalculateActivationRangeQuantized() for int8"""
+    def quantize(value):
+        return output.zero_point + int(math.copysign(math.floor(abs(f32(value / output.scale)) + 0.5),
+                                                     value))
+
+    low, high = -128, 127
+    name = ACTIVATIONS.get(activation)
+    if name == "RELU":
+        low = max(low, quantize(0.0))
+    elif name == "RELU6":
+        low, high = max(low, quantize(0.0)), min(high, quantize(6.0))
+    elif name == "RELU_N1_TO_1":
+        low, high = max(low, quantize(-1.0)), min(high, quantize(1.0))
+    elif name is None:
+        fail("unsupported fused activation %d" % activation)
+    return low, high
+
+
+def same_padding(size, filter_size, stride, dilation):
+    effective = (filter_size - 1) * dilation + 1
+    output = (size + stride - 1) // stride
+    return output, max((output - 1) * stride + effective - size, 0) // 2
+
+
+def valid_padding(size, filter_size, stride, dilation):
+    effective = (filter_size - 1) * dilation + 1
+    return (size + stride - effective) // stride, 0
+
+
+def prune(values):
+    """Keep the two largest weights of every group of four."""
+    pruned = list(values)
+    for start in range(0, len(pruned), 4):
+        group = sorted(range(start, start + 4), key=lambda index: abs(pruned[index]))
+        for index in group[:2]:
+            pruned[index] = 0
+    return pruned
+
+
+def pack(values):
+    """Packed weights and position nibbles of a 2:4 sparse filter, None when a
+    group of four has more than two non-zero weights."""
+    weights, positions = [], []
+    for start in range(0, len(values), 4):
+        group = values[start:start + 4]
+        kept = [position for position, value in enumerate(group) if value != 0]
+        if len(kept) > 2:
+            return None
+        # a group with fewer weights keeps zeros in the free places
+        kept += [position for position in range(4) if position not in kept][:2 - len(kept)]
+        weights += [group[position] for position in kept]
+        positions.append(kept[0] | (kept[1] << 2))
+    if len(positions) % 2:
+        positions.append(0)
+    return weights, [low | (high << 4) for low, high in zip(positions[0::2], positions[1::2])]
+
+
+def winograd(values, output_depth, depth, biases):
+    """(2G) g (2G)^T of every 3x3 filter as output_depth x 16 x depth, or None
+    when a sum could overflow int32.  The input transform B^T d B adds or
+    subtracts four inputs, each at most 255 after the offset."""
+    transformed = [0] * (output_depth * 16 * depth)
+    for channel in range(output_depth):
+        largest = [0] * 16
+        for input_channel in range(depth):
+            g = [[values[((channel * 3 + y) * 3 + x) * depth + input_channel] for x in range(3)]
+                 for y in range(3)]
+            gg = [[sum(WINOGRAD_G[i][k] * g[k][j] for k in range(3)) for j in range(3)] for i in range(4)]
+            for i in range(4):
+                for j in range(4):
+                    u = sum(gg[i][k] * WINOGRAD_G[j][k] for k in range(3))
+                    transformed[(channel * 16 + i * 4 + j) * depth + input_channel] = u
+                    largest[i * 4 + j] += abs(u) * 4 * 255
+        # A^T M A, four times the convolution
+        bound = max(sum(abs(WINOGRAD_AT[row][k] * WINOGRAD_AT[col][l]) * largest[k * 4 + l]
+                        for k in range(4) for l in range(4))
+                    for row in range(2) for col in range(2))
+        if bound > INT32_MAX or bound // 4 + abs(biases[channel]) > INT32_MAX:
+            return None
+    return transformed
+
+
+class Generator:
+    def __init__(self, model, name, sparse=False, pruned=False, winograd=False, patches=0, frame=None):
+        root = Table(model, struct.unpack_from("<I", model, 0)[0])
+        subgraphs = root.tables(2)
+        if len(subgraphs) != 1:
+            fail("models with %d subgraphs are not supported" % len(subgraphs))
+        self.codes = [max(code.scalar(0, "b"), code.scalar(3, "i")) for code in root.tables(1)]
+        buffers = [buffer.bytes(0) for buffer in root.tables(4)]
+        graph = subgraphs[0]
+        self.tensors = [Tensor(index, table, buffers) for index, table in enumerate(graph.tables(0))]
+        self.inputs = [self.tensors[index] for index in graph.vector(1, "i")]
+        self.outputs = [self.tensors[index] for index in graph.vector(2, "i")]
+        self.operators = graph.tables(3)
+        self.name = name
+        self.model_size = len(model)
+        self.constants = []
+        self.layers = []
+        self.calls = []
+        self.exits = []
+        self.constant_size = 0
+        self.sparse = sparse
+        self.pruned = pruned
+        self.sparse_layers = 0
+        self.winograd = winograd
+        self.winograd_layers = 0
+        # multiplies per inference of the direct kernels and as compiled
+        self.dense_macs = 0
+        self.macs = 0
+        self.patches = patches
+        self.patch_layers = 0
+        self.patch_count = 0
+        self.monolithic_arena = 0
+        self.halo_macs = 0
+        # (number, rows, padding, first rows) of the patch being generated
+        self.band = None
+        self.filters = {}
+        self.constant_names = set()
+        # window grid of a frame model: rows, columns and stride in pixels
+        self.grid = (1, 1, 0)
+        # fully connected layers run as convolutions, with their filter size
+        self.convolutional = {}
+
+        if len(self.inputs) != 1:
+            fail("one input tensor is supported")
+        for tensor in self.inputs + self.outputs:
+            if tensor.type != TYPE_INT8:
+                fail("the input and outputs must be int8")
+        if len(set(math.prod(tensor.shape) for tensor in self.outputs)) != 1:
+            fail("every output must have the same number of categories")
+        if frame:
+            self.reframe(frame)
+        self.segments = self.split()
+
+    def reframe(self, frame):
+        """Work out every tensor shape for an input of frame rows and columns,
+        as a fully convolutional model."""
+        if len(self.outputs) != 1:
+            fail("--frame needs a model without early exit heads")
+        input = self.inputs[0]
+        _, rows, columns, depth = input.shape
+        if frame[0] < rows or frame[1] < columns:
+            fail("the frame is smaller than the %dx%d input" % (rows, columns))
+        window = {tensor.index: list(tensor.shape) for tensor in self.tensors}
+        flattened = self.flattened(window)
+        input.shape = [1, frame[0], frame[1], depth]
+        for index, operator in enumerate(self.operators):
+            code = self.codes[operator.scalar(0, "I")]
+            options = operator.table(4)
+            inputs = [self.tensors[i] for i in operator.vector(1, "i") if i >= 0]
+            (output,) = [self.tensors[i] for i in operator.vector(2, "i")]
+            source = self.activation(operator)
+            _, height, width, _ = source.shape
+            if code in (CONV_2D, MAX_POOL_2D):
+                if code == CONV_2D:
+                    depth, filter_height, filter_width, _ = inputs[1].shape
+                    dilation_width, dilation_height = options.scalar(4, "i", 1), options.scalar(5, "i", 1)
+                else:
+                    depth = source.shape[3]
+                    filter_width, filter_height = options.scalar(3, "i"), options.scalar(4, "i")
+                    dilation_width, dilation_height = 1, 1
+                padding = same_padding if options.scalar(0, "b") == PADDING_SAME else valid_padding
+                output_height, _ = padding(height, filter_height, options.scalar(2, "i"), dilation_height)
+                output_width, _ = padding(width, filter_width, options.scalar(1, "i"), dilation_width)
+                output.shape = [1, output_height, output_width, depth]
+            elif code in (ADD, MUL, SOFTMAX, RESHAPE):
+                # a flatten keeps the feature map for the first fully connected layer
+                output.shape = list(source.shape)
+            elif code == FULLY_CONNECTED:
+                units = inputs[1].shape[0]
+                shape = flattened.get(source.index, window[source.index])
+                if len(shape) == 4:
+                    _, filter_height, filter_width, _ = shape
+                    stride = (rows // filter_height, columns // filter_width)
+                    if stride[0] * filter_height != rows or stride[1] * filter_width != columns:
+                        fail("the %dx%d input does not map to the feature map of FULLY_CONNECTED %d" %
+                             (rows, columns, index))
+                    self.grid = (height - filter_height + 1, width - filter_width + 1, stride[0])
+                    if stride[0] != stride[1]:
+                        fail("FULLY_CONNECTED %d sees windows with different strides" % index)
+                else:
+                    filter_height, filter_width = 1, 1
+                self.convolutional[index] = (filter_height, filter_width)
+                output.shape = [1, height - filter_height + 1, width - filter_width + 1, units]
+            else:
+                fail("operator %d (builtin code %d) is not supported, use the interpreter" % (index, code))
+            if output.shape[1] < 1 or output.shape[2] < 1:
+                fail("the frame is too small for operator %d" % index)
+
+    def flattened(self, window):
+        """Shape each flattened tensor had before its RESHAPE, for a model
+        compiled for a single window."""
+        shapes = {}
+        for operator in self.operators:
+            if self.codes[operator.scalar(0, "I")] == RESHAPE:
+                source = operator.vector(1, "i")[0]
+                shapes[operator.vector(2, "i")[0]] = shapes.get(source, window[source])
+        return shapes
+
+    def split(self):
+        """Order the outputs by the number of operators they need and return
+        the operators each one adds to the ones before it, as lists of
+        (index, operator) in the original order."""
+        producer = {}
+        for index, operator in enumerate(self.operators):
+            for tensor in operator.vector(2, "i"):
+                producer[tensor] = index
+
+        def needs(tensor, found):
+            index = producer.get(tensor)
+            if index is None or index in found:
+                return found
+            found.add(index)
+            for tensor in self.operators[index].vector(1, "i"):
+                if tensor >= 0:
+                    needs(tensor, found)
+            return found
+
+        heads = sorted((len(needs(output.index, set())), position, output)
+                       for position, output in enumerate(self.outputs))
+        self.outputs = [output for _, _, output in heads]
+        segments, done = [], set()
+        for output in self.outputs:
+            found = needs(output.index, set()) - done
+            segments.append([(index, self.operators[index]) for index in sorted(found)])
+            done |= found
+        if len(done) != len(self.operators):
+            fail("%d operators do not lead to an output" % (len(self.operators) - len(done)))
+        return segments
+
+    # -- constant data ------------------------------------------------------
+
+    def constant(self, name, ctype, values):
+        # layers run in patches share their constants
+        if name in self.constant_names:
+            return name
+        self.constant_names.add(name)
+        self.constants.append("const %s %s[%d] = {\n" % (ctype, name, len(values)))
+        for start in range(0, len(values), VALUES_PER_LINE):
+            line = ", ".join(str(value) for value in values[start:start + VALUES_PER_LINE])
+            self.constants.append("    %s,\n" % line)
+        self.constants.append("};\n\n")
+        self.constant_size += len(values) * {"int8_t": 1, "uint8_t": 1, "int16_t": 2}.get(ctype, 4)
+        return name
+
+    def layer(self, ctype, name, fields):
+        self.layers.append("const %s %s = {\n" % (ctype, name))
+        for values, comment in fields:
+            text = ", ".join(str(value) for value in values) + ","
+            self.layers.append("    %-28s // %s\n" % (text, comment))
+        self.layers.append("};\n\n")
+
+    def operand(self, tensor):
+        """Expression for the data of a tensor inside aot_model_invoke()."""
+        if tensor.constant:
+            return self.constant("tensor_%d" % tensor.index, "int8_t", tensor.values())
+        offset = tensor.root().offset
+        if self.band and tensor.index in self.band[3]:
+            offset += self.band[3][tensor.index] * tensor.size // tensor.shape[1]
+        return "&tensor_arena[%d]" % offset
+
+    def patch(self, index, name, input, output, height, output_height, padding_height):
+        """Name, input and output height and top padding of a layer in the
+        patch being generated."""
+        if not self.band:
+            return name, height, output_height, padding_height
+        number, rows, padding, _ = self.band
+        return ("%s_%d" % (name, number), rows[input.index][1] - rows[input.index][0],
+                rows[output.index][1] - rows[output.index][0], padding[index])
+
+    def filter(self, name, filter, depth, transform=None):
+        """Filter and positions fields of a conv or fully connected layer, and
+        how the layer runs: "sparse", "winograd" or "dense".  transform, when
+        given, returns the Winograd weights of a dense filter or None."""
+        if name in self.filters:
+            return self.filters[name]
+        self.filters[name] = self.pack_filter(name, filter, depth, transform)
+        return self.filters[name]
+
+    def pack_filter(self, name, filter, depth, transform):
+        values = filter.values()
+        packed = None
+        if depth % 4 == 0 and not any(filter.zero_points):
+            if self.pruned:
+                values = prune(values)
+            if self.sparse:
+                packed = pack(values)
+        if packed is None:
+            transformed = transform(values) if transform else None
+            if transformed is not None:
+                self.winograd_layers += 1
+                return [(("nullptr", "nullptr"), "filter and positions"),
+                        ((self.constant(name + "_winograd", "int16_t", transformed),), "winograd")], "winograd"
+            return [((self.constant(name + "_filter", "int8_t", values),), "filter"),
+                    (("nullptr",), "dense")], "dense"
+        self.sparse_layers += 1
+        weights, positions = packed
+        return [((self.constant(name + "_filter", "int8_t", weights),), "2:4 packed filter"),
+                ((self.constant(name + "_positions", "uint8_t", positions),), "positions")], "sparse"
+
+    # -- operators ----------------------------------------------------------
+
+    def conv(self, index, options, inputs, output):
+        input, filter, bias = inputs
+        if len(filter.scales) != filter.shape[0] or any(filter.zero_points):
+            fail("CONV_2D filters must be quantized per channel and symmetric")
+        _, height, width, depth = input.shape
+        output_depth, filter_height, filter_width, _ = filter.shape
+        stride_width, stride_height = options.scalar(1, "i"), options.scalar(2, "i")
+        dilation_width, dilation_height = options.scalar(4, "i", 1), options.scalar(5, "i", 1)
+        padding = same_padding if options.scalar(0, "b") == PADDING_SAME else valid_padding
+        output_height, padding_height = padding(height, filter_height, stride_height, dilation_height)
+        output_width, padding_width = padding(width, filter_width, stride_width, dilation_width)
+        if [1, output_height, output_width, output_depth] != output.shape:
+            fail("CONV_2D %d output shape mismatch" % index)
+        name = "conv_%d" % index
+        full_macs = output_height * output_width * output_depth * filter_height * filter_width * depth
+        layer_name, height, output_height, padding_height = self.patch(
+            index, name, input, output, height, output_height, padding_height)
+        macs = output_height * output_width * output_depth * filter_height * filter_width * depth
+        if self.band:
+            self.halo_macs += macs - (full_macs if self.band[0] == 0 else 0)
+
+        multipliers, shifts = [], []
+        for scale in filter.scales:
+            multiplier, shift = quantize_multiplier(input.scale * scale / output.scale)
+            multipliers.append(multiplier)
+            shifts.append(shift)
+        low, high = activation_range(options.scalar(3, "b"), output)
+
+        transform = None
+        if (self.winograd and (filter_height, filter_width) == (3, 3) and
+                (stride_height, stride_width, dilation_height, dilation_width) == (1, 1, 1, 1) and
+                depth <= WINOGRAD_MAX_DEPTH):
+            def transform(values):
+                transformed = winograd(values, output_depth, depth, bias.values())
+                if transformed is None:
+                    print("%s: sums could overflow, left on the direct kernel" % name, file=sys.stderr)
+                return transformed
+        filter_fields, kind = self.filter(name, filter, depth, transform)
+        self.dense_macs += macs
+        if kind == "winograd":
+            kernel = "aot_winograd_conv"
+            self.macs += ((output_height + 1) // 2) * ((output_width + 1) // 2) * 16 * depth * output_depth
+        else:
+            kernel = "aot_sparse_conv" if kind == "sparse" else "aot_conv"
+            filter_fields = filter_fields + [(("nullptr",), "winograd")]
+            self.macs += macs // 2 if kind == "sparse" else macs
+        self.layer("aot_conv_t", layer_name, [
+            ((height, width, depth), "input height, width, depth"),
+            ((filter_height, filter_width), "filter height, width"),
+            ((output_height, output_width, output_depth), "output height, width, depth"),
+            ((stride_height, stride_width), "stride"),
+            ((dilation_height, dilation_width), "dilation"),
+            ((padding_height, padding_width), "padding"),
+            ((low, high), "activation"),
+            ((-input.zero_point, output.zero_point), "input and output offset"),
+        ] + filter_fields + [
+            ((self.constant(name + "_bias", "int32_t", bias.values()),), "bias"),
+            ((self.constant(name + "_multiplier", "int32_t", multipliers),), "multiplier"),
+            ((self.constant(name + "_shift", "int32_t", shifts),), "shift"),
+        ])
+        return "%s(&%s, %s, %s)" % (kernel, layer_name, self.operand(input), self.operand(output))
+
+    def fully_connected(self, index, options, inputs, output):
+        input, filter, bias = inputs
+        if index in self.convolutional:
+            return self.fully_connected_conv(index, options, inputs, output)
+        if len(filter.scales) != 1:
+            fail("FULLY_CONNECTED filters must be quantized per tensor")
+        if options.scalar(1, "b") != 0:
+            fail("FULLY_CONNECTED %d uses shuffled weights" % index)
+        output_size, input_size = filter.shape
+        if math.prod(input.shape) != input_size or output.shape != [1, output_size]:
+            fail("FULLY_CONNECTED %d supports a single batch only" % index)
+
+        # the interpreter multiplies the two scales as floats
+        multiplier, shift = quantize_multiplier(f32(input.scale * filter.scale) / output.scale)
+        low, high = activation_range(options.scalar(0, "b"), output)
+
+        name = "fully_connected_%d" % index
+        filter_fields, kind = self.filter(name, filter, input_size)
+        sparse = kind == "sparse"
+        self.layer("aot_fully_connected_t", name, [
+            ((input_size, output_size), "input and output size"),
+            ((low, high), "activation"),
+            ((-input.zero_point, -filter.zero_point, output.zero_point), "input, filter and output offset"),
+            ((multiplier, shift), "multiplier and shift"),
+        ] + filter_fields + [
+            ((self.constant(name + "_bias", "int32_t", bias.values()) if bias else "nullptr",), "bias"),
+        ])
+        kernel = "aot_sparse_fully_connected" if sparse else "aot_fully_connected"
+        self.dense_macs += input_size * output_size
+        self.macs += input_size * output_size // (2 if sparse else 1)
+        return "%s(&%s, %s, %s)" % (kernel, name, self.operand(input), self.operand(output))
+
+    def fully_connected_conv(self, index, options, inputs, output):
+        """A fully connected layer of a frame model, run as a convolution over
+        the windows with the per tensor scale repeated for every channel."""
+        input, filter, bias = inputs
+        if len(filter.scales) != 1 or any(filter.zero_points):
+            fail("FULLY_CONNECTED filters must be quantized per tensor and symmetric")
+        _, height, width, depth = input.shape
+        _, output_height, output_width, output_depth = output.shape
+        filter_height, filter_width = self.convolutional[index]
+        if filter.shape != [output_depth, filter_height * filter_width * depth]:
+            fail("FULLY_CONNECTED %d does not match its feature map" % index)
+        multiplier, shift = quantize_multiplier(f32(input.scale * filter.scale) / output.scale)
+        low, high = activation_range(options.scalar(0, "b"), output)
+
+        name = "fully_connected_%d" % index
+        filter_fields, kind = self.filter(name, filter, depth)
+        macs = output_height * output_width * output_depth * filter_height * filter_width * depth
+        self.dense_macs += macs
+        self.macs += macs // 2 if kind == "sparse" else macs
+        zeros = [0] * output_depth
+        self.layer("aot_conv_t", name, [
+            ((height, width, depth), "input height, width, depth"),
+            ((filter_height, filter_width), "filter height, width"),
+            ((output_height, output_width, output_depth), "output height, width, depth"),
+            ((1, 1), "stride"),
+            ((1, 1), "dilation"),
+            ((0, 0), "padding"),
+            ((low, high), "activation"),
+            ((-input.zero_point, output.zero_point), "input and output offset"),
+        ] + filter_fields + [
+            (("nullptr",), "winograd"),
+            ((self.constant(name + "_bias", "int32_t", bias.values() if bias else zeros),), "bias"),
+            ((self.constant(name + "_multiplier", "int32_t", [multiplier] * output_depth),), "multiplier"),
+            ((self.constant(name + "_shift", "int32_t", [shift] * output_depth),), "shift"),
+        ])
+        kernel = "aot_sparse_conv" if kind == "sparse" else "aot_conv"
+        return "%s(&%s, %s, %s)" % (kernel, name, self.operand(input), self.operand(output))
+
+    def max_pool(self, index, options, inputs, output):
+        (input,) = inputs
+        _, height, width, depth = input.shape
+        stride_width, stride_height = options.scalar(1, "i"), options.scalar(2, "i")
+        filter_width, filter_height = options.scalar(3, "i"), options.scalar(4, "i")
+        padding = same_padding if options.scalar(0, "b") == PADDING_SAME else valid_padding
+        output_height, padding_height = padding(height, filter_height, stride_height, 1)
+        output_width, padding_width = padding(width, filter_width, stride_width, 1)
+        if [1, output_height, output_width, depth] != output.shape:
+            fail("MAX_POOL_2D %d output shape mismatch" % index)
+        if (input.scale, input.zero_point) != (output.scale, output.zero_point):
+            fail("MAX_POOL_2D %d rescales its input" % index)
+        low, high = activation_range(options.scalar(5, "b"), output)
+
+        name, height, output_height, padding_height = self.patch(
+            index, "max_pool_%d" % index, input, output, height, output_height, padding_height)
+        self.layer("aot_pool_t", name, [
+            ((height, width, depth), "input height, width, depth"),
+            ((filter_height, filter_width), "filter height, width"),
+            ((output_height, output_width), "output height, width"),
+            ((stride_height, stride_width), "stride"),
+            ((padding_height, padding_width), "padding"),
+            ((low, high), "activation"),
+        ])
+        return "aot_max_pool(&%s, %s, %s)" % (name, self.operand(input), self.operand(output))
+
+    def broadcast(self, index, inputs, output):
+        """Order the inputs so the second one is the same size or one value
+        per channel, which is all the kernels handle."""
+        first, second = inputs
+        size = math.prod(output.shape)
+        if math.prod(first.shape) != size:
+            first, second = second, first
+        channels = output.shape[-1]
+        second_size = math.prod(second.shape)
+        if (math.prod(first.shape) != size or
+                (second_size != size and (second_size != channels or second.shape[-1] != channels))):
+            fail("operator %d broadcasts in a way that is not supported" % index)
+        return first, second, size, second_size
+
+    def add(self, index, options, inputs, output):
+        first, second, size, second_size = self.broadcast(index, inputs, output)
+        left_shift = 20
+        twice_max_scale = 2 * max(first.scale, second.scale)
+        first_multiplier, first_shift = quantize_multiplier(first.scale / twice_max_scale)
+        second_multiplier, second_shift = quantize_multiplier(second.scale / twice_max_scale)
+        output_multiplier, output_shift = quantize_multiplier(
+            twice_max_scale / ((1 << left_shift) * output.scale))
+        low, high = activation_range(options.scalar(0, "b"), output)
+
+        name = "add_%d" % index
+        if self.band:
+            name, height, _, _ = self.patch(index, name, first, output, output.shape[1], 0, 0)
+            size = size // output.shape[1] * height
+        self.layer("aot_add_t", name, [
+            ((size, second_size), "input 1 and input 2 size"),
+            ((low, high), "activation"),
+            ((-first.zero_point, -second.zero_point, output.zero_point), "input 1, input 2 and output offset"),
+            ((left_shift,), "left shift"),
+            ((first_multiplier, first_shift), "input 1 multiplier and shift"),
+            ((second_multiplier, second_shift), "input 2 multiplier and shift"),
+            ((output_multiplier, output_shift), "output multiplier and shift"),
+        ])
+        return "aot_add(&%s, %s, %s, %s)" % (name, self.operand(first), self.operand(second),
+                                            self.operand(output))
+
+    def mul(self, index, options, inputs, output):
+        first, second, size, second_size = self.broadcast(index, inputs, output)
+        multiplier, shift = quantize_multiplier(first.scale * second.scale / output.scale)
+        low, high = activation_range(options.scalar(0, "b"), output)
+
+        name = "mul_%d" % index
+        if self.band:
+            name, height, _, _ = self.patch(index, name, first, output, output.shape[1], 0, 0)
+            size = size // output.shape[1] * height
+        self.layer("aot_mul_t", name, [
+            ((size, second_size), "input 1 and input 2 size"),
+            ((low, high), "activation"),
+            ((-first.zero_point, -second.zero_point, output.zero_point), "input 1, input 2 and output offset"),
+            ((multiplier, shift), "output multiplier and shift"),
+        ])
+        return "aot_mul(&%s, %s, %s, %s)" % (name, self.operand(first), self.operand(second),
+                                            self.operand(output))
+
+    def softmax(self, index, options, inputs, output):
+        (input,) = inputs
+        integer_bits = 5
+        beta = options.scalar(0, "f", 1.0)
+        # tflite::PreprocessSoftmaxScaling() and CalculateInputRadius()
+        multiplier, shift = quantize_multiplier(
+            min(beta * input.scale * (1 << (31 - integer_bits)), (1 << 31) - 1.0))
+        if shift < 0:
+            fail("SOFTMAX %d input scale is too small" % index)
+        radius = math.floor(((1 << integer_bits) - 1) * (1 << (31 - integer_bits)) / (1 << shift))
+        if (output.scale, output.zero_point) != (1.0 / 256, -128):
+            fail("SOFTMAX %d output must have a scale of 1/256 and a zero point of -128" % index)
+
+        depth = input.shape[-1]
+        name = "softmax_%d" % index
+        self.layer("aot_softmax_t", name, [
+            ((math.prod(input.shape) // depth, depth), "rows and depth"),
+            ((multiplier, shift), "input multiplier and left shift"),
+            ((-radius,), "minimum difference"),
+        ])
+        return "aot_softmax(&%s, %s, %s)" % (name, self.operand(input), self.operand(output))
+
+    # -- memory plan ---------------------------------------------------------
+
+    def activation(self, operator):
+        """The input of a layer that is not a constant."""
+        return [self.tensors[index] for index in operator.vector(1, "i")
+                if index >= 0 and not self.tensors[index].constant][0]
+
+    def chain(self):
+        """The convolution, pool and per channel ADD and MUL layers at the
+        start of the first segment where each one only feeds the next, as
+        (index, operator).  These can run in patches."""
+        uses = {}
+        for operator in self.operators:
+            for index in operator.vector(1, "i"):
+                uses[index] = uses.get(index, 0) + 1
+        outputs = [tensor.index for tensor in self.outputs]
+        tensor = self.inputs[0]
+        chain = []
+        for index, operator in self.segments[0]:
+            code = self.codes[operator.scalar(0, "I")]
+            inputs = [self.tensors[i] for i in operator.vector(1, "i") if i >= 0]
+            (output,) = [self.tensors[i] for i in operator.vector(2, "i")]
+            if code not in (CONV_2D, MAX_POOL_2D, ADD, MUL) or len(output.shape) != 4:
+                break
+            if [input for input in inputs if not input.constant] != [tensor]:
+                break
+            if code in (ADD, MUL) and any(input.constant and math.prod(input.shape) != output.shape[-1]
+                                          for input in inputs):
+                break
+            chain.append((index, operator))
+            if uses.get(output.index) != 1 or output.index in outputs:
+                break
+            tensor = output
+        return chain
+
+    def rows(self, operator):
+        """Filter height, stride, dilation and top padding of a layer that can
+        run in patches; ADD and MUL keep each row to itself."""
+        code = self.codes[operator.scalar(0, "I")]
+        options = operator.table(4)
+        if code == CONV_2D:
+            filter_size = self.tensors[operator.vector(1, "i")[1]].shape[1]
+            stride, dilation = options.scalar(2, "i"), options.scalar(5, "i", 1)
+        elif code == MAX_POOL_2D:
+            filter_size, stride, dilation = options.scalar(4, "i"), options.scalar(2, "i"), 1
+        else:
+            return 1, 1, 1, 0
+        padding = same_padding if options.scalar(0, "b") == PADDING_SAME else valid_padding
+        height = self.activation(operator).shape[1]
+        return filter_size, stride, dilation, padding(height, filter_size, stride, dilation)[1]
+
+    def bands(self, stage):
+        """Split the output of a stage into bands of rows and work back to the
+        rows of every tensor that each band needs, and the top padding each
+        layer sees.  Returns a list of (rows, padding) dictionaries keyed by
+        tensor and operator index."""
+        output = self.tensors[stage[-1][1].vector(2, "i")[0]]
+        height = output.shape[1]
+        count = min(self.patches, height)
+        bands = []
+        for band in range(count):
+            rows = {output.index: (height * band // count, height * (band + 1) // count)}
+            padding = {}
+            for index, operator in reversed(stage):
+                input = self.activation(operator)
+                first, end = rows[operator.vector(2, "i")[0]]
+                filter_size, stride, dilation, top = self.rows(operator)
+                start = first * stride - top
+                stop = (end - 1) * stride - top + (filter_size - 1) * dilation + 1
+                rows[input.index] = (max(start, 0), min(stop, input.shape[1]))
+                padding[index] = max(start, 0) - start
+            bands.append((rows, padding))
+        return bands
+
+    def plan(self, stage=(), bands=()):
+        """Greedy first fit of the activations by size, largest first, the
+        same strategy as the TFLM GreedyMemoryPlanner.  A stage run in bands
+        keeps its input and output whole but only a band of the tensors in
+        between."""
+        first_use, last_use = {}, {}
+        for tensor in self.inputs:
+            first_use[tensor.index] = 0
+        order = [operator for segment in self.segments for _, operator in segment]
+        for step, operator in enumerate(order):
+            for index in operator.vector(1, "i"):
+                tensor = self.tensors[index].root() if index >= 0 else None
+                if tensor is not None and not tensor.constant:
+                    last_use[tensor.index] = step
+            for index in operator.vector(2, "i"):
+                tensor = self.tensors[index].root()
+                first_use.setdefault(tensor.index, step)
+                last_use.setdefault(tensor.index, step)
+        for tensor in self.outputs:
+            last_use[tensor.root().index] = len(self.operators)
+
+        sizes = {index: self.tensors[index].size for index in first_use}
+        if stage:
+            input = self.activation(stage[0][1])
+            output = self.tensors[stage[-1][1].vector(2, "i")[0]]
+            for index in sizes:
+                if index not in (input.index, output.index) and index in bands[0][0]:
+                    tensor = self.tensors[index]
+                    sizes[index] = max((end - first) * tensor.size // tensor.shape[1]
+                                       for rows, _ in bands for first, end in [rows[index]])
+            # every band reads the input and fills in part of the output
+            last_use[input.index] = max(last_use[input.index], len(stage) - 1)
+            first_use[output.index] = 0
+
+        placed = []
+        order = sorted(first_use, key=lambda index: (-sizes[index], first_use[index]))
+        for index in order:
+            tensor = self.tensors[index]
+            offset = 0
+            for other in sorted(placed, key=lambda other: other.offset):
+                if last_use[other.index] < first_use[index] or last_use[index] < first_use[other.index]:
+                    continue
+                if offset + sizes[index] > other.offset and other.offset + sizes[other.index] > offset:
+                    offset = (other.offset + sizes[other.index] + ALIGNMENT - 1) & ~(ALIGNMENT - 1)
+            tensor.offset = offset
+            placed.append(tensor)
+        return max((tensor.offset + sizes[tensor.index] for tensor in placed), default=0)
+
+    def stage(self):
+        """The layers to run in patches and their bands, the longest chain
+        that gives the smallest arena, or nothing when patches do not help."""
+        best = (self.monolithic_arena, [], [])
+        chain = self.chain()
+        for length in range(1, len(chain) + 1):
+            bands = self.bands(chain[:length])
+            arena_size = self.plan(chain[:length], bands)
+            if arena_size < best[0]:
+                best = (arena_size, chain[:length], bands)
+        if not best[1]:
+            print("%s: patches do not make the arena smaller" % self.name, file=sys.stderr)
+        return best[1], best[2]
+
+    # -- output -------------------------------------------------------------
+
+    def generate(self):
+        handlers = {
+            ADD: self.add,
+            CONV_2D: self.conv,
+            FULLY_CONNECTED: self.fully_connected,
+            MAX_POOL_2D: self.max_pool,
+            MUL: self.mul,
+            SOFTMAX: self.softmax,
+        }
+
+        # a reshape only changes how the next operator sees the data
+        for operator in self.operators:
+            if self.codes[operator.scalar(0, "I")] == RESHAPE:
+                source = self.tensors[operator.vector(1, "i")[0]]
+                target = self.tensors[operator.vector(2, "i")[0]]
+                if source.constant or source.size != target.size:
+                    fail("unsupported RESHAPE")
+                target.alias = source
+        arena_size = self.monolithic_arena = self.plan()
+        stage, bands = self.stage() if self.patches > 1 else ([], [])
+        if stage:
+            arena_size = self.plan(stage, bands)
+            self.patch_layers, self.patch_count = len(stage), len(bands)
+            input = self.activation(stage[0][1])
+            output = self.tensors[stage[-1][1].vector(2, "i")[0]]
+
+        def call(index, operator):
+            code = self.codes[operator.scalar(0, "I")]
+            if code not in handlers:
+                fail("operator %d (builtin code %d) is not supported, use the interpreter" % (index, code))
+            inputs = [self.tensors[i] if i >= 0 else None for i in operator.vector(1, "i")]
+            (output,) = [self.tensors[i] for i in operator.vector(2, "i")]
+            for tensor in inputs + [output]:
+                if tensor is not None and tensor.type not in (TYPE_INT8, TYPE_INT32):
+                    fail("operator %d is not int8" % index)
+            options = operator.table(4)
+            self.calls.append(handlers[code](index, options, inputs, output))
+
+        for number, segment in enumerate(self.segments):
+            if number == 0 and stage:
+                for band, (rows, padding) in enumerate(bands):
+                    first_rows = {input.index: rows[input.index][0], output.index: rows[output.index][0]}
+                    self.band = (band, rows, padding, first_rows)
+                    for index, operator in stage:
+                        call(index, operator)
+                self.band = None
+                segment = segment[len(stage):]
+            for index, operator in segment:
+                if self.codes[operator.scalar(0, "I")] != RESHAPE:
+                    call(index, operator)
+            # number of layers run up to and including this exit
+            self.exits.append(len(self.calls))
+
+        return arena_size
+
+    def write(self, out):
+        arena_size = self.generate()
+        input, output = self.inputs[0], self.outputs[-1]
+
+        out.write("// Generated by tools/tflm_aot.py from %s, do not edit.\n" % self.name)
+        out.write("#include <stdbool.h>\n#include <stdint.h>\n\n")
+        out.write("#include \"aot_kernels.h\"\n#include \"aot_model.h\"\n\n")
+        out.write("namespace\n{\n")
+        out.writelines(self.constants)
+        out.writelines(self.layers)
+        out.write("alignas(%d) int8_t tensor_arena[%d];\n\n" % (ALIGNMENT, arena_size))
+        out.write("const uint32_t exit_layers[%d] = {%s};\n\n" %
+                  (len(self.exits), ", ".join(str(layers) for layers in self.exits)))
+        out.write("const int8_t *const exit_outputs[%d] = {\n" % len(self.outputs))
+        for tensor in self.outputs:
+            out.write("    %s,\n" % self.operand(tensor))
+        out.write("};\n\n")
+
+        out.write("} // namespace\n\n")
+
+        out.write("const aot_model_info_t aot_model_info = {\n")
+        out.write("    %d, // input size\n" % math.prod(input.shape))
+        out.write("    %d, // output size\n" % math.prod(output.shape))
+        out.write("    %d, // arena size\n" % arena_size)
+        out.write("    %d, // constant size\n" % self.constant_size)
+        out.write("    %d, // flatbuffer size\n" % self.model_size)
+        out.write("    %d, // layers\n" % len(self.calls))
+        out.write("    %d, // exits\n" % len(self.exits))
+        out.write("    exit_layers,\n")
+        out.write("    %d, // grid rows\n" % self.grid[0])
+        out.write("    %d, // grid columns\n" % self.grid[1])
+        out.write("    %d, // grid stride\n" % self.grid[2])
+        out.write("};\n\n")
+
+        out.write("int8_t *aot_model_arena(void)\n{\n    return tensor_arena;\n}\n\n")
+        out.write("int8_t *aot_model_input(void)\n{\n    return %s;\n}\n\n" % self.operand(input))
+        out.write("const int8_t *aot_model_output(void)\n{\n    return %s;\n}\n\n" % self.operand(output))
+        out.write("const int8_t *aot_model_exit_output(uint32_t exit)\n{\n")
+        out.write("    return (exit < %d) ? exit_outputs[exit] : nullptr;\n}\n\n" % len(self.exits))
+        out.write("bool aot_model_invoke_layer(uint32_t layer)\n{\n    switch (layer)\n    {\n")
+        for layer, call in enumerate(self.calls):
+            out.write("    case %d:\n        return %s;\n" % (layer, call))
+        out.write("    default:\n        return false;\n    }\n}\n\n")
+        out.write("bool aot_model_invoke(void)\n{\n")
+        for call in self.calls:
+            out.write("    if (!%s)\n    {\n        return false;\n    }\n" % call)
+        out.write("    return true;\n}\n")
+
+        return arena_size
+
+
+def frame_size(text):
+    try:
+        rows, columns = (int(value) for value in text.lower().split("x"))
+    except ValueError:
+        raise argparse.ArgumentTypeError("expected ROWSxCOLUMNS, such as 96x96")
+    return rows, columns
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile an int8 model to C++ for the firmware.")
+    parser.add_argument("model", help=".tflite file or quant_model_*.cc array")
+    parser.add_argument("output", type=argparse.FileType("w"))
+    parser.add_argument("--sparse", action="store_true", help="run 2:4 sparse filters packed")
+    parser.add_argument("--prune", action="store_true",
+                        help="prune every filter to 2:4 first, for benchmarking")
+    parser.add_argument("--winograd", action="store_true", help="run 3x3 convolutions with Winograd F(2x2, 3x3)")
+    parser.add_argument("--patches", type=int, default=0, metavar="N",
+                        help="run the first layers in N bands of rows to shrink the arena")
+    parser.add_argument("--frame", type=frame_size, metavar="ROWSxCOLUMNS",
+                        help="compile fully convolutionally for a whole frame of windows")
+    args = parser.parse_args()
+
+    model = load_model(args.model)
+    if not model:
+        fail("no model data in %s" % args.model)
+
+    generator = Generator(model, os.path.basename(args.model), args.sparse, args.prune, args.winograd,
+                          args.patches, args.frame)
+    arena_size = generator.write(args.output)
+    print("%s: %d layers, %d exits, %d sparse, %d winograd, %d bytes of constants, %d byte arena" %
+          (os.path.basename(args.model), len(generator.calls), len(generator.exits),
+           generator.sparse_layers, generator.winograd_layers, generator.constant_size, arena_size))
+    print("%d multiplies per inference, %d with the direct kernels (%.2fx)" %
+          (generator.macs, generator.dense_macs, generator.dense_macs / max(generator.macs, 1)))
+    if generator.patch_layers:
+        print("%d patches over the first %d layers, %d byte arena instead of %d, %d multiplies in the halos" %
+              (generator.patch_count, generator.patch_layers, arena_size, generator.monolithic_arena,
+               generator.halo_macs))
+    if args.frame:
+        rows, columns, stride = generator.grid
+        print("%dx%d windows %d pixels apart, %d multiplies per window" %
+              (rows, columns, stride, generator.macs // (rows * columns)))
+
+
+if __name__ == "__main__":
+    main()
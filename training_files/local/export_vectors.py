@@ -0,0 +1,51 @@
+import argparse
+import numpy as np
+import utils
+
+# Each record is the ASCII label of the digit followed by the int8 input
+# tensor, quantised the same way the firmware normalises camera frames
+# (every channel scaled to [0, 127]).  The file is consumed by
+# tools/rpc_client to run the test split through the device.
+#
+# With --frame each record is a 96x96 frame with three test digits side by
+# side across the middle, labelled with the leftmost one, for a model
+# compiled with tools/tflm_aot.py --frame 96x96.
+
+FRAME_SIZE = 96
+FRAME_DIGITS = 3
+
+def main():
+    parser = argparse.ArgumentParser(description="Export test vectors for the device.")
+    parser.add_argument("--images", dest="images", action="store", required=True)
+    parser.add_argument("--output", dest="output", action="store", required=True)
+    parser.add_argument("--count", dest="count", action="store", type=int, default=0)
+    parser.add_argument("--frame", dest="frame", action="store_true")
+    args = parser.parse_args()
+
+    train_images, train_labels, val_images, val_labels, test_images, test_labels = utils.load_images(args.images)
+
+    digits = FRAME_DIGITS if args.frame else 1
+    count = len(test_images) // digits
+    if args.count > 0:
+        count = min(count, args.count)
+
+    size = 0
+    with open(args.output, "wb") as f:
+        for index in range(count):
+            images = [np.clip(test_images[index * digits + i] * 127, 0, 127).astype("int8") for i in range(digits)]
+            label = ord("0") + int(np.argmax(test_labels[index * digits]))
+            if args.frame:
+                rows, cols = images[0].shape[:2]
+                image = np.zeros((FRAME_SIZE, FRAME_SIZE, images[0].shape[2]), "int8")
+                top = (FRAME_SIZE - rows) // 2
+                for i in range(digits):
+                    image[top:top + rows, i * cols:(i + 1) * cols] = images[i]
+            else:
+                image = images[0]
+            f.write(bytes([label]))
+            f.write(image.tobytes())
+            size = image.size
+
+    print(f"Exported {count} vectors of {size} bytes to {args.output}")
+
+main()
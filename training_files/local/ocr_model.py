@@ -1,7 +1,19 @@
 import numpy as np
 import keras
 
-def create_model(image_size):
+# Early exit heads follow these pooling blocks (counting from 1) when the model
+# is created with exits=True.  Each head is a small classifier the firmware can
+# stop at when it is confident enough; see tools/tflm_aot.py.
+EXIT_BLOCKS = (2, 3)
+EXIT_LOSS_WEIGHT = 0.3
+
+# train.py --prune fine tunes a trained model so that every Conv2D and Dense
+# layer whose input depth is a multiple of four keeps at most two non-zero
+# weights in every four input channels; tools/tflm_aot.py --sparse runs those
+# layers with the sparse kernels.
+PRUNE_M_BY_N = (2, 4)
+
+def create_model(image_size, exits=False):
     keras.backend.clear_session()
     # Reference model
     # model = keras.Sequential([
@@ -70,12 +82,65 @@ def create_model(image_size):
         keras.layers.Dense(10, activation='softmax')
     ])
 
+    if exits:
+        model = add_exits(model, image_size)
+
+    compile_model(model)
+    model.summary()
+    return model
+
+def compile_model(model):
+    loss_weights = None
+    if len(model.outputs) > 1:
+        loss_weights = [EXIT_LOSS_WEIGHT] * (len(model.outputs) - 1) + [1.0]
 
     optimizer = keras.optimizers.Adam(learning_rate=1e-3, amsgrad=True)
     model.compile(optimizer=optimizer,
                 loss='categorical_crossentropy',
+                loss_weights=loss_weights,
                 metrics=['accuracy'])
 
-    model.summary()
-    return model
-
+def prune_model(model):
+    """Wrap the layers the sparse kernels can run for PRUNE_M_BY_N pruning.
+    The other layers and all the trained weights are kept.  Fit the result with
+    the pruning_callbacks() and remove the wrappers with strip_pruning()."""
+    import tensorflow_model_optimization as tfmot
+
+    def wrap(layer):
+        if (isinstance(layer, (keras.layers.Conv2D, keras.layers.Dense)) and
+                layer.input_shape[-1] % PRUNE_M_BY_N[1] == 0):
+            return tfmot.sparsity.keras.prune_low_magnitude(layer, sparsity_m_by_n=PRUNE_M_BY_N)
+        return layer
+
+    pruned = keras.models.clone_model(model, clone_function=wrap)
+    compile_model(pruned)
+    pruned.summary()
+    return pruned
+
+def pruning_callbacks():
+    import tensorflow_model_optimization as tfmot
+    return [tfmot.sparsity.keras.UpdatePruningStep()]
+
+def strip_pruning(model):
+    import tensorflow_model_optimization as tfmot
+    return tfmot.sparsity.keras.strip_pruning(model)
+
+def add_exits(model, image_size):
+    """Rebuild the model with a Flatten and Dense head after each pooling block
+    in EXIT_BLOCKS.  The outputs are ordered and named shallowest first, which
+    is the order the converter keeps and the firmware expects, with the full
+    model last."""
+    inputs = keras.Input(shape=image_size)
+    x = inputs
+    outputs = []
+    blocks = 0
+    for layer in model.layers:
+        x = layer(x)
+        if isinstance(layer, keras.layers.MaxPooling2D):
+            blocks += 1
+            if blocks in EXIT_BLOCKS:
+                head = keras.layers.Flatten(name="exit_%d_flatten" % len(outputs))(x)
+                outputs.append(keras.layers.Dense(10, activation='softmax',
+                                                  name="exit_%d" % len(outputs))(head))
+    outputs.append(keras.layers.Activation('linear', name="exit_%d" % len(outputs))(x))
+    return keras.Model(inputs=inputs, outputs=outputs)
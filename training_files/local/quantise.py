@@ -12,6 +12,10 @@ def main():
     parser = argparse.ArgumentParser(description="Import dataset.")
     parser.add_argument("--images", dest="images", action="store", required=True)
     parser.add_argument("--output", dest="output", action="store", required=True)
+    parser.add_argument("--exits", dest="exits", action="store_true", default=False,
+                        help="the model was trained with train.py --exits")
+    parser.add_argument("--pruned", dest="pruned", action="store_true", default=False,
+                        help="use the weights of train.py --prune")
     args = parser.parse_args()
 
     basename = os.path.basename(args.images)
@@ -19,6 +23,10 @@ def main():
         model_name = ".".join(basename.split(".")[:-1])
     else:
         model_name = basename
+    if args.exits:
+        model_name += "_exits"
+    if args.pruned:
+        model_name += "_pruned"
 
     weights_dir = MODEL_DIR + model_name + "/weights"
     tflite_dir = MODEL_DIR + model_name + "/tflite"
@@ -30,7 +38,7 @@ def main():
     train_images, train_labels, val_images, val_labels, test_images, test_labels = utils.load_images(args.images)
     image_shape = train_images[0].shape
 
-    model = ocr_model.create_model(image_shape)
+    model = ocr_model.create_model(image_shape, exits=args.exits)
     model.load_weights(weights_dir + "/weights")
     converter = tf.lite.TFLiteConverter.from_keras_model(model)
     tflite_model = converter.convert()
@@ -54,6 +62,12 @@ def main():
     tflite_model_quant_file = pathlib.Path(tflite_model_quant_filename)
     tflite_model_quant_file.write_bytes(tflite_model_quant)
 
+    # the firmware stops at the first confident output, so the shallowest
+    # has to come first and the full model last
+    interpreter = tf.lite.Interpreter(model_content=tflite_model_quant)
+    for output in interpreter.get_output_details():
+        print(f"Output {output['name']}: {output['shape']}")
+
     tflite_stats = os.stat(tflite_model_filename)
     tflite_quant_stats = os.stat(tflite_model_quant_filename)
     print()
@@ -13,6 +13,10 @@ def main():
     parser.add_argument("--images", dest="images", action="store", required=True)
     parser.add_argument("--history", dest="history", action="store_true", default=False)
     parser.add_argument("--compile", dest="compile", action="store_true")
+    parser.add_argument("--exits", dest="exits", action="store_true", default=False,
+                        help="add early exit heads, see ocr_model.EXIT_BLOCKS")
+    parser.add_argument("--prune", dest="prune", action="store_true", default=False,
+                        help="fine tune the trained model to 2:4 sparsity, see ocr_model.PRUNE_M_BY_N")
     args = parser.parse_args()
 
 
@@ -21,6 +25,11 @@ def main():
         model_name = ".".join(basename.split(".")[:-1])
     else:
         model_name = basename
+    if args.exits:
+        model_name += "_exits"
+    dense_weights_dir = MODEL_DIR + model_name + "/weights"
+    if args.prune:
+        model_name += "_pruned"
     checkpoint_path = MODEL_DIR + model_name + "/cp.ckpt"
     checkpoint_dir = os.path.dirname(checkpoint_path)
     weights_dir = MODEL_DIR + model_name + "/weights"
@@ -31,21 +40,43 @@ def main():
 
     image_shape = train_images[0].shape
     print(image_shape)
-    model = ocr_model.create_model(image_shape)
+    model = ocr_model.create_model(image_shape, exits=args.exits)
 
     if (args.compile):
         quit()
+
+    # pruning starts from the trained dense weights
+    epochs = 125
+    callbacks = []
+    if args.prune:
+        model.load_weights(dense_weights_dir + "/weights")
+        model = ocr_model.prune_model(model)
+        epochs = 30
+        callbacks = ocr_model.pruning_callbacks()
+
+    # every exit head learns the same labels
+    if args.exits:
+        train_labels = [train_labels] * len(model.outputs)
+        val_labels = [val_labels] * len(model.outputs)
     
     cp_callback = keras.callbacks.ModelCheckpoint(filepath=checkpoint_path, save_weights_only=True)
 
     early_stopping = keras.callbacks.EarlyStopping(patience=10, restore_best_weights=True)
     history = model.fit(train_images, train_labels,
                         batch_size=128,
-                        epochs=125,
+                        epochs=epochs,
                         validation_data=(val_images, val_labels),
-                        callbacks=[cp_callback, early_stopping])
+                        callbacks=[cp_callback, early_stopping] + callbacks)
+    if args.prune:
+        model = ocr_model.strip_pruning(model)
     model.save_weights(weights_dir + "/weights")
     
+    # the metrics of the full model
+    accuracy, val_accuracy = 'accuracy', 'val_accuracy'
+    if args.exits:
+        accuracy = model.output_names[-1] + '_accuracy'
+        val_accuracy = 'val_' + accuracy
+
     if (args.history is True):
         plt.figure(figsize=(20, 10))
 
@@ -57,8 +88,8 @@ def main():
         plt.title("Epochs vs. Training and Validation Loss")
 
         plt.subplot(1, 2, 2)
-        plt.plot(history.history['accuracy'], label='train')
-        plt.plot(history.history['val_accuracy'], label='val')
+        plt.plot(history.history[accuracy], label='train')
+        plt.plot(history.history[val_accuracy], label='val')
         plt.ylabel('accuracy')
         plt.legend()
         plt.title("Epochs vs. Training and Validation Accuracy")
@@ -58,6 +58,21 @@
 #define AM_BOOTLOADER_OVERRIDE_HIGH             (0x1)
 #define AM_BOOTLOADER_OVERRIDE_LOW              (0x0)
 
+//*****************************************************************************
+//
+// CRC-32 routines used for image verification. All of them produce the same
+// result; define these to am_bootloader_fast_crc32 and
+// am_bootloader_partial_crc32 to drop the 7KB of slice-by-8 tables.
+//
+//*****************************************************************************
+#ifndef AM_BOOTLOADER_IMAGE_CRC32
+#define AM_BOOTLOADER_IMAGE_CRC32               am_bootloader_slice8_crc32
+#endif
+
+#ifndef AM_BOOTLOADER_PARTIAL_CRC32
+#define AM_BOOTLOADER_PARTIAL_CRC32             am_bootloader_partial_slice8_crc32
+#endif
+
 
 #ifdef __cplusplus
 extern "C"
@@ -111,6 +126,8 @@ am_bootloader_image_t;
 extern uint32_t am_bootloader_crc32(const void *pvData, uint32_t ui32Length);
 extern uint32_t am_bootloader_fast_crc32(const void *pvData, uint32_t ui32NumBytes);
 extern void am_bootloader_partial_crc32(const void *pvData, uint32_t ui32NumBytes, uint32_t *pui32CRC);
+extern uint32_t am_bootloader_slice8_crc32(const void *pvData, uint32_t ui32NumBytes);
+extern void am_bootloader_partial_slice8_crc32(const void *pvData, uint32_t ui32NumBytes, uint32_t *pui32CRC);
 extern bool am_bootloader_image_check(am_bootloader_image_t *psImage);
 extern bool am_bootloader_flash_check(am_bootloader_image_t *psImage);
 extern int am_bootloader_flag_page_update(am_bootloader_image_t *psImage, uint32_t *pui32FlagPage);
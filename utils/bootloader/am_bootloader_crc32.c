@@ -0,0 +1,426 @@
+//*****************************************************************************
+//
+//! @file am_bootloader_crc32.c
+//!
+//! @brief CRC-32 routines used to verify boot and OTA images.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2020, Ambiq Micro, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision 2.5.1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#include <stdint.h>
+#include <stdbool.h>
+#include "am_bootloader.h"
+
+//*****************************************************************************
+//
+// CRC-32 table
+// Polynomial = 0x1EDC6F41 (also listed as CRC-32C or CRC-32/4)
+//
+// This polynomial should catch all errors up to 4 bits for image sizes under
+// about 255MB (which easily covers anything we can actually fit in flash), and
+// it has a reasonably high probablility of catching bigger errors.
+//
+// See http://users.ece.cmu.edu/~koopman/crc for more information.
+//
+//*****************************************************************************
+#define CRC32_POLYNOMIAL                    0x1EDC6F41
+static const uint32_t g_pui32CRC32Table[256] =
+{
+    0x00000000, 0x1EDC6F41, 0x3DB8DE82, 0x2364B1C3,
+    0x7B71BD04, 0x65ADD245, 0x46C96386, 0x58150CC7,
+    0xF6E37A08, 0xE83F1549, 0xCB5BA48A, 0xD587CBCB,
+    0x8D92C70C, 0x934EA84D, 0xB02A198E, 0xAEF676CF,
+    0xF31A9B51, 0xEDC6F410, 0xCEA245D3, 0xD07E2A92,
+    0x886B2655, 0x96B74914, 0xB5D3F8D7, 0xAB0F9796,
+    0x05F9E159, 0x1B258E18, 0x38413FDB, 0x269D509A,
+    0x7E885C5D, 0x6054331C, 0x433082DF, 0x5DECED9E,
+    0xF8E959E3, 0xE63536A2, 0xC5518761, 0xDB8DE820,
+    0x8398E4E7, 0x9D448BA6, 0xBE203A65, 0xA0FC5524,
+    0x0E0A23EB, 0x10D64CAA, 0x33B2FD69, 0x2D6E9228,
+    0x757B9EEF, 0x6BA7F1AE, 0x48C3406D, 0x561F2F2C,
+    0x0BF3C2B2, 0x152FADF3, 0x364B1C30, 0x28977371,
+    0x70827FB6, 0x6E5E10F7, 0x4D3AA134, 0x53E6CE75,
+    0xFD10B8BA, 0xE3CCD7FB, 0xC0A86638, 0xDE740979,
+    0x866105BE, 0x98BD6AFF, 0xBBD9DB3C, 0xA505B47D,
+    0xEF0EDC87, 0xF1D2B3C6, 0xD2B60205, 0xCC6A6D44,
+    0x947F6183, 0x8AA30EC2, 0xA9C7BF01, 0xB71BD040,
+    0x19EDA68F, 0x0731C9CE, 0x2455780D, 0x3A89174C,
+    0x629C1B8B, 0x7C4074CA, 0x5F24C509, 0x41F8AA48,
+    0x1C1447D6, 0x02C82897, 0x21AC9954, 0x3F70F615,
+    0x6765FAD2, 0x79B99593, 0x5ADD2450, 0x44014B11,
+    0xEAF73DDE, 0xF42B529F, 0xD74FE35C, 0xC9938C1D,
+    0x918680DA, 0x8F5AEF9B, 0xAC3E5E58, 0xB2E23119,
+    0x17E78564, 0x093BEA25, 0x2A5F5BE6, 0x348334A7,
+    0x6C963860, 0x724A5721, 0x512EE6E2, 0x4FF289A3,
+    0xE104FF6C, 0xFFD8902D, 0xDCBC21EE, 0xC2604EAF,
+    0x9A754268, 0x84A92D29, 0xA7CD9CEA, 0xB911F3AB,
+    0xE4FD1E35, 0xFA217174, 0xD945C0B7, 0xC799AFF6,
+    0x9F8CA331, 0x8150CC70, 0xA2347DB3, 0xBCE812F2,
+    0x121E643D, 0x0CC20B7C, 0x2FA6BABF, 0x317AD5FE,
+    0x696FD939, 0x77B3B678, 0x54D707BB, 0x4A0B68FA,
+    0xC0C1D64F, 0xDE1DB90E, 0xFD7908CD, 0xE3A5678C,
+    0xBBB06B4B, 0xA56C040A, 0x8608B5C9, 0x98D4DA88,
+    0x3622AC47, 0x28FEC306, 0x0B9A72C5, 0x15461D84,
+    0x4D531143, 0x538F7E02, 0x70EBCFC1, 0x6E37A080,
+    0x33DB4D1E, 0x2D07225F, 0x0E63939C, 0x10BFFCDD,
+    0x48AAF01A, 0x56769F5B, 0x75122E98, 0x6BCE41D9,
+    0xC5383716, 0xDBE45857, 0xF880E994, 0xE65C86D5,
+    0xBE498A12, 0xA095E553, 0x83F15490, 0x9D2D3BD1,
+    0x38288FAC, 0x26F4E0ED, 0x0590512E, 0x1B4C3E6F,
+    0x435932A8, 0x5D855DE9, 0x7EE1EC2A, 0x603D836B,
+    0xCECBF5A4, 0xD0179AE5, 0xF3732B26, 0xEDAF4467,
+    0xB5BA48A0, 0xAB6627E1, 0x88029622, 0x96DEF963,
+    0xCB3214FD, 0xD5EE7BBC, 0xF68ACA7F, 0xE856A53E,
+    0xB043A9F9, 0xAE9FC6B8, 0x8DFB777B, 0x9327183A,
+    0x3DD16EF5, 0x230D01B4, 0x0069B077, 0x1EB5DF36,
+    0x46A0D3F1, 0x587CBCB0, 0x7B180D73, 0x65C46232,
+    0x2FCF0AC8, 0x31136589, 0x1277D44A, 0x0CABBB0B,
+    0x54BEB7CC, 0x4A62D88D, 0x6906694E, 0x77DA060F,
+    0xD92C70C0, 0xC7F01F81, 0xE494AE42, 0xFA48C103,
+    0xA25DCDC4, 0xBC81A285, 0x9FE51346, 0x81397C07,
+    0xDCD59199, 0xC209FED8, 0xE16D4F1B, 0xFFB1205A,
+    0xA7A42C9D, 0xB97843DC, 0x9A1CF21F, 0x84C09D5E,
+    0x2A36EB91, 0x34EA84D0, 0x178E3513, 0x09525A52,
+    0x51475695, 0x4F9B39D4, 0x6CFF8817, 0x7223E756,
+    0xD726532B, 0xC9FA3C6A, 0xEA9E8DA9, 0xF442E2E8,
+    0xAC57EE2F, 0xB28B816E, 0x91EF30AD, 0x8F335FEC,
+    0x21C52923, 0x3F194662, 0x1C7DF7A1, 0x02A198E0,
+    0x5AB49427, 0x4468FB66, 0x670C4AA5, 0x79D025E4,
+    0x243CC87A, 0x3AE0A73B, 0x198416F8, 0x075879B9,
+    0x5F4D757E, 0x41911A3F, 0x62F5ABFC, 0x7C29C4BD,
+    0xD2DFB272, 0xCC03DD33, 0xEF676CF0, 0xF1BB03B1,
+    0xA9AE0F76, 0xB7726037, 0x9416D1F4, 0x8ACABEB5
+};
+
+//*****************************************************************************
+//
+//! @brief CRC-32 implementation for the boot loader.
+//!
+//! @param pvData - Pointer to the data to be checked.
+//! @param ui32NumBytes - Number of bytes to check.
+//!
+//! This function performs a CRC-32 on the input data and returns the 32-bit
+//! result. This version does not use a table, so it has a smaller code
+//! footprint.
+//!
+//! @return 32-bit CRC value.
+//
+//*****************************************************************************
+uint32_t
+am_bootloader_crc32(const void *pvData, uint32_t ui32NumBytes)
+{
+    uint32_t ui32CRC, i, j;
+    uint8_t *pui8Data;
+
+    ui32CRC = 0;
+    pui8Data = (uint8_t *) pvData;
+
+    for ( i = 0; i < ui32NumBytes; i++ )
+    {
+        ui32CRC ^= pui8Data[i] << 24;
+
+        for ( j = 0; j < 8; j++ )
+        {
+            ui32CRC = (ui32CRC & 0x80000000 ?
+                       ((ui32CRC << 1) ^ CRC32_POLYNOMIAL):
+                       (ui32CRC << 1));
+        }
+    }
+
+    return ui32CRC;
+}
+
+//*****************************************************************************
+//
+//! @brief Faster CRC-32 implementation for the boot loader.
+//!
+//! @param pvData - Pointer to the data to be checked.
+//! @param ui32NumBytes - Number of bytes to check.
+//!
+//! This function performs a CRC-32 on the input data and returns the 32-bit
+//! result. This version uses a 256-entry lookup table to speed up the
+//! computation of the result.
+//!
+//! @return 32-bit CRC value.
+//
+//*****************************************************************************
+uint32_t
+am_bootloader_fast_crc32(const void *pvData, uint32_t ui32NumBytes)
+{
+    uint32_t ui32CRC, ui32CRCIndex, i;
+    uint8_t *pui8Data;
+
+    ui32CRC = 0;
+    pui8Data = (uint8_t *) pvData;
+
+    for (i = 0; i < ui32NumBytes; i++ )
+    {
+        ui32CRCIndex = pui8Data[i] ^ (ui32CRC >> 24);
+        ui32CRC = (ui32CRC << 8) ^ g_pui32CRC32Table[ui32CRCIndex];
+    }
+
+    return ui32CRC;
+}
+
+//*****************************************************************************
+//
+//! @brief CRC-32 implementation allowing multiple partial images.
+//!
+//! @param pvData - Pointer to the data to be checked.
+//! @param ui32NumBytes - Number of bytes to check.
+//! @param pui32CRC - Location to store the partial CRC32 result.
+//!
+//! This function performs a CRC-32 on the input data and returns the 32-bit
+//! result. This version uses a 256-entry lookup table to speed up the
+//! computation of the result. The result of the CRC32 is stored in the
+//! location given by the caller. This allows the caller to keep a "running"
+//! CRC for individual chunks of an image.
+//!
+//! @return 32-bit CRC value.
+//
+//*****************************************************************************
+void
+am_bootloader_partial_crc32(const void *pvData, uint32_t ui32NumBytes,
+                            uint32_t *pui32CRC)
+{
+    uint32_t ui32CRCIndex, i;
+    uint8_t *pui8Data;
+
+    uint32_t ui32TempCRC = *pui32CRC;
+
+    pui8Data = (uint8_t *) pvData;
+
+    for ( i = 0; i < ui32NumBytes; i++ )
+    {
+        ui32CRCIndex = pui8Data[i] ^ (ui32TempCRC >> 24);
+        ui32TempCRC = (ui32TempCRC << 8) ^ g_pui32CRC32Table[ui32CRCIndex];
+    }
+
+    *pui32CRC = ui32TempCRC;
+}
+
+//*****************************************************************************
+//
+// Slice-by-8 CRC-32 tables
+//
+// Entry n of slice k is the CRC of byte n followed by k zero bytes, which is
+// n * x^(32 + 8k) mod P. That product is linear in the bits of n, so each
+// entry is the XOR of the basis values x^(32 + 8k + b) mod P for every bit b
+// set in n and the whole table is generated by the preprocessor from the 56
+// basis values below. Slice 0 is g_pui32CRC32Table.
+//
+//*****************************************************************************
+#define CRC32_X1_0 0x9F5FC3DF
+#define CRC32_X1_1 0x2063E8FF
+#define CRC32_X1_2 0x40C7D1FE
+#define CRC32_X1_3 0x818FA3FC
+#define CRC32_X1_4 0x1DC328B9
+#define CRC32_X1_5 0x3B865172
+#define CRC32_X1_6 0x770CA2E4
+#define CRC32_X1_7 0xEE1945C8
+
+#define CRC32_X2_0 0xC2EEE4D1
+#define CRC32_X2_1 0x9B01A6E3
+#define CRC32_X2_2 0x28DF2287
+#define CRC32_X2_3 0x51BE450E
+#define CRC32_X2_4 0xA37C8A1C
+#define CRC32_X2_5 0x58257B79
+#define CRC32_X2_6 0xB04AF6F2
+#define CRC32_X2_7 0x7E4982A5
+
+#define CRC32_X3_0 0xFC93054A
+#define CRC32_X3_1 0xE7FA65D5
+#define CRC32_X3_2 0xD128A4EB
+#define CRC32_X3_3 0xBC8D2697
+#define CRC32_X3_4 0x67C6226F
+#define CRC32_X3_5 0xCF8C44DE
+#define CRC32_X3_6 0x81C4E6FD
+#define CRC32_X3_7 0x1D55A2BB
+
+#define CRC32_X4_0 0x3AAB4576
+#define CRC32_X4_1 0x75568AEC
+#define CRC32_X4_2 0xEAAD15D8
+#define CRC32_X4_3 0xCB8644F1
+#define CRC32_X4_4 0x89D0E6A3
+#define CRC32_X4_5 0x0D7DA207
+#define CRC32_X4_6 0x1AFB440E
+#define CRC32_X4_7 0x35F6881C
+
+#define CRC32_X5_0 0x6BED1038
+#define CRC32_X5_1 0xD7DA2070
+#define CRC32_X5_2 0xB1682FA1
+#define CRC32_X5_3 0x7C0C3003
+#define CRC32_X5_4 0xF8186006
+#define CRC32_X5_5 0xEEECAF4D
+#define CRC32_X5_6 0xC30531DB
+#define CRC32_X5_7 0x98D60CF7
+
+#define CRC32_X6_0 0x2F7076AF
+#define CRC32_X6_1 0x5EE0ED5E
+#define CRC32_X6_2 0xBDC1DABC
+#define CRC32_X6_3 0x655FDA39
+#define CRC32_X6_4 0xCABFB472
+#define CRC32_X6_5 0x8BA307A5
+#define CRC32_X6_6 0x099A600B
+#define CRC32_X6_7 0x1334C016
+
+#define CRC32_X7_0 0x2669802C
+#define CRC32_X7_1 0x4CD30058
+#define CRC32_X7_2 0x99A600B0
+#define CRC32_X7_3 0x2D906E21
+#define CRC32_X7_4 0x5B20DC42
+#define CRC32_X7_5 0xB641B884
+#define CRC32_X7_6 0x725F1E49
+#define CRC32_X7_7 0xE4BE3C92
+
+#define CRC32_SLICE_BIT(k, n, b)    (((n) >> (b)) & 1 ? CRC32_X##k##_##b : 0)
+#define CRC32_SLICE_ENTRY(k, n)                                               \
+    (CRC32_SLICE_BIT(k, n, 0) ^ CRC32_SLICE_BIT(k, n, 1) ^                    \
+     CRC32_SLICE_BIT(k, n, 2) ^ CRC32_SLICE_BIT(k, n, 3) ^                    \
+     CRC32_SLICE_BIT(k, n, 4) ^ CRC32_SLICE_BIT(k, n, 5) ^                    \
+     CRC32_SLICE_BIT(k, n, 6) ^ CRC32_SLICE_BIT(k, n, 7))
+#define CRC32_SLICE_4(k, n)                                                   \
+    CRC32_SLICE_ENTRY(k, (n)), CRC32_SLICE_ENTRY(k, (n) + 1),                 \
+    CRC32_SLICE_ENTRY(k, (n) + 2), CRC32_SLICE_ENTRY(k, (n) + 3)
+#define CRC32_SLICE_16(k, n)                                                  \
+    CRC32_SLICE_4(k, (n)), CRC32_SLICE_4(k, (n) + 4),                         \
+    CRC32_SLICE_4(k, (n) + 8), CRC32_SLICE_4(k, (n) + 12)
+#define CRC32_SLICE_64(k, n)                                                  \
+    CRC32_SLICE_16(k, (n)), CRC32_SLICE_16(k, (n) + 16),                      \
+    CRC32_SLICE_16(k, (n) + 32), CRC32_SLICE_16(k, (n) + 48)
+#define CRC32_SLICE_256(k)                                                    \
+    CRC32_SLICE_64(k, 0), CRC32_SLICE_64(k, 64),                              \
+    CRC32_SLICE_64(k, 128), CRC32_SLICE_64(k, 192)
+
+static const uint32_t g_pui32CRC32SliceTable[7][256] =
+{
+    { CRC32_SLICE_256(1) },
+    { CRC32_SLICE_256(2) },
+    { CRC32_SLICE_256(3) },
+    { CRC32_SLICE_256(4) },
+    { CRC32_SLICE_256(5) },
+    { CRC32_SLICE_256(6) },
+    { CRC32_SLICE_256(7) },
+};
+
+//*****************************************************************************
+//
+// Fold eight bytes into the running CRC. The first four bytes are combined
+// with the CRC as a big-endian word (this CRC is MSB first); every byte then
+// goes through the slice that accounts for the bytes still following it.
+//
+//*****************************************************************************
+static inline uint32_t
+crc32_slice8_block(uint32_t ui32CRC, const uint8_t *pui8Data)
+{
+    ui32CRC ^= ((uint32_t)pui8Data[0] << 24) | ((uint32_t)pui8Data[1] << 16) |
+               ((uint32_t)pui8Data[2] << 8) | (uint32_t)pui8Data[3];
+
+    return g_pui32CRC32SliceTable[6][ui32CRC >> 24] ^
+           g_pui32CRC32SliceTable[5][(ui32CRC >> 16) & 0xFF] ^
+           g_pui32CRC32SliceTable[4][(ui32CRC >> 8) & 0xFF] ^
+           g_pui32CRC32SliceTable[3][ui32CRC & 0xFF] ^
+           g_pui32CRC32SliceTable[2][pui8Data[4]] ^
+           g_pui32CRC32SliceTable[1][pui8Data[5]] ^
+           g_pui32CRC32SliceTable[0][pui8Data[6]] ^
+           g_pui32CRC32Table[pui8Data[7]];
+}
+
+//*****************************************************************************
+//
+//! @brief Slice-by-8 CRC-32 implementation allowing multiple partial images.
+//!
+//! @param pvData - Pointer to the data to be checked.
+//! @param ui32NumBytes - Number of bytes to check.
+//! @param pui32CRC - Location to store the partial CRC32 result.
+//!
+//! This function produces the same result as am_bootloader_partial_crc32 but
+//! processes eight bytes per step using eight 256-entry tables. It costs 7KB
+//! of extra tables and is several times faster than the single table version
+//! on large images; tools/crc32_bench measures both.
+//!
+//! @return None.
+//
+//*****************************************************************************
+void
+am_bootloader_partial_slice8_crc32(const void *pvData, uint32_t ui32NumBytes,
+                                   uint32_t *pui32CRC)
+{
+    uint32_t ui32TempCRC = *pui32CRC;
+    const uint8_t *pui8Data = (const uint8_t *) pvData;
+
+    while ( ui32NumBytes >= 8 )
+    {
+        ui32TempCRC = crc32_slice8_block(ui32TempCRC, pui8Data);
+        pui8Data += 8;
+        ui32NumBytes -= 8;
+    }
+
+    while ( ui32NumBytes-- )
+    {
+        ui32TempCRC = (ui32TempCRC << 8) ^
+                      g_pui32CRC32Table[*pui8Data++ ^ (ui32TempCRC >> 24)];
+    }
+
+    *pui32CRC = ui32TempCRC;
+}
+
+//*****************************************************************************
+//
+//! @brief Slice-by-8 CRC-32 implementation for the boot loader.
+//!
+//! @param pvData - Pointer to the data to be checked.
+//! @param ui32NumBytes - Number of bytes to check.
+//!
+//! This function performs a CRC-32 on the input data and returns the 32-bit
+//! result. The result is identical to am_bootloader_crc32 and
+//! am_bootloader_fast_crc32.
+//!
+//! @return 32-bit CRC value.
+//
+//*****************************************************************************
+uint32_t
+am_bootloader_slice8_crc32(const void *pvData, uint32_t ui32NumBytes)
+{
+    uint32_t ui32CRC = 0;
+
+    am_bootloader_partial_slice8_crc32(pvData, ui32NumBytes, &ui32CRC);
+
+    return ui32CRC;
+}
@@ -55,6 +55,7 @@
 #include "am_util.h"
 #include "am_multi_boot_private.h"
 #include "am_multi_boot.h"
+#include "am_multiboot_lz.h"
 
 // Protection against NULL pointer
 #define FLASH_OPERATE(pFlash, func) ((pFlash)->func ? (pFlash)->func() : 0)
@@ -479,7 +480,7 @@ image_data_packet_read(uint8_t *pui8Src, uint32_t ui32Size)
             // Run a quick CRC on the received bytes, holding on to the result in a
             // global variable, so we can pick up where we left off on the next pass.
             //
-            am_bootloader_partial_crc32(g_am_multiboot.pui8RxBuffer, g_am_multiboot.ui32BytesInBuffer, &g_ui32CRC);
+            AM_BOOTLOADER_PARTIAL_CRC32(g_am_multiboot.pui8RxBuffer, g_am_multiboot.ui32BytesInBuffer, &g_ui32CRC);
 
 #ifdef MULTIBOOT_SECURE
             // Decrypt in place
@@ -707,6 +708,74 @@ program_image_from_flash(uint32_t ui32WriteAddr, uint32_t *pui32ReadAddr,
     }
 }
 
+//*****************************************************************************
+//
+// A model update may only write inside the model partition. When the blob is
+// staged in internal flash its CRC is checked before anything is erased, so a
+// bad download leaves the current model in place.
+//
+//*****************************************************************************
+static bool
+check_model_range(uint32_t ui32Start, uint32_t ui32Size)
+{
+    return (ui32Start >= MODEL_PARTITION_ADDRESS) &&
+           (ui32Size <= MODEL_PARTITION_SIZE) &&
+           (ui32Start - MODEL_PARTITION_ADDRESS <= MODEL_PARTITION_SIZE - ui32Size);
+}
+
+static bool
+check_model_image(am_multiboot_ota_t *pOtaInfo)
+{
+    if (!check_model_range((uint32_t)pOtaInfo->pui32LinkAddress, pOtaInfo->ui32NumBytes))
+    {
+        return false;
+    }
+#ifndef MULTIBOOT_SECURE
+    if (!(pOtaInfo->ui32Options & OTA_INFO_OPTIONS_EXT_FLASH) &&
+        (AM_BOOTLOADER_IMAGE_CRC32(pOtaInfo->pui32ImageAddr, pOtaInfo->ui32NumBytes) !=
+         pOtaInfo->ui32ImageCrc))
+    {
+        return false;
+    }
+#endif
+    return true;
+}
+
+//*****************************************************************************
+//
+// A compressed image is decompressed once without writing anything, so that a
+// damaged image is rejected before the current one is erased. The image is
+// then decompressed straight into its final location and must not overlap
+// the staged copy it is read from.
+//
+//*****************************************************************************
+static bool
+check_compressed_image(am_multiboot_ota_t *pOtaInfo, am_multiboot_flash_info_t *pFlash,
+                       am_multiboot_lz_header_t *psHeader)
+{
+    uint32_t ui32Start = (uint32_t)pOtaInfo->pui32LinkAddress;
+    uint32_t ui32Staged = (uint32_t)pOtaInfo->pui32ImageAddr;
+
+    if (!am_multiboot_lz_read_header(pOtaInfo->pui32ImageAddr, pOtaInfo->ui32NumBytes,
+                                     pFlash, psHeader) ||
+        !check_flash_address_range(ui32Start, psHeader->ui32Length))
+    {
+        return false;
+    }
+    if ((pOtaInfo->ui32Options & OTA_INFO_OPTIONS_MODEL) &&
+        !check_model_range(ui32Start, psHeader->ui32Length))
+    {
+        return false;
+    }
+    if (!(pOtaInfo->ui32Options & OTA_INFO_OPTIONS_EXT_FLASH) &&
+        (ui32Start < ui32Staged + pOtaInfo->ui32NumBytes) &&
+        (ui32Staged < ui32Start + psHeader->ui32Length))
+    {
+        return false;
+    }
+    return am_multiboot_lz_verify(pOtaInfo->pui32ImageAddr, pOtaInfo->ui32NumBytes, pFlash);
+}
+
 //*****************************************************************************
 //
 //! @brief Multiboot protocol handler for OTA update
@@ -719,7 +788,10 @@ program_image_from_flash(uint32_t ui32WriteAddr, uint32_t *pui32ReadAddr,
 //! @param pExtFlash is the pointer external flash access info if needed
 //!
 //! This function validates the OTA blob, and installs the image if verified.
-//! It updates the flag page with the new image information and issues a POI
+//! It updates the flag page with the new image information and issues a POI.
+//! With OTA_INFO_OPTIONS_MODEL only the model partition is written and the
+//! flag page is left alone. With OTA_INFO_OPTIONS_COMPRESSED the image is
+//! decompressed while it is programmed.
 //!
 //! @return false if OTA upgrade fails. Otherwise this function does not return
 //
@@ -751,6 +823,10 @@ am_multiboot_ota_handler(am_multiboot_ota_t *pOtaInfo, uint32_t *pTempBuf,
     {
         return false;
     }
+    if ((pOtaInfo->ui32Options & OTA_INFO_OPTIONS_MODEL) && !check_model_image(pOtaInfo))
+    {
+        return false;
+    }
     // Validate the ext flash info
     if (pOtaInfo->ui32Options & OTA_INFO_OPTIONS_EXT_FLASH)
     {
@@ -838,20 +914,55 @@ am_multiboot_ota_handler(am_multiboot_ota_t *pOtaInfo, uint32_t *pTempBuf,
         return false;
     }
 #endif
-    psImage->pui32StackPointer = (uint32_t *)(((uint32_t *)pOtaInfo->pui32ImageAddr)[0]);
-    psImage->pui32ResetVector = (uint32_t *)(((uint32_t *)pOtaInfo->pui32ImageAddr)[1]);
+    if (pOtaInfo->ui32Options & OTA_INFO_OPTIONS_COMPRESSED)
+    {
+        am_multiboot_lz_header_t sHeader;
 
-    //
-    // The image is presumed to be reasonable. Set our global
-    // variables based on the new image structure.
-    //
-    g_am_multiboot.pui32WriteAddress = psImage->pui32LinkAddress;
+        if ((g_intFlash.flashSectorSize > tempBufSize) ||
+            !check_compressed_image(pOtaInfo, pFlash, &sHeader))
+        {
+            FLASH_OPERATE(pFlash, flash_disable);
+            FLASH_OPERATE(pFlash, flash_deinit);
+            return false;
+        }
 
-    program_image_from_flash((uint32_t)pOtaInfo->pui32LinkAddress, pOtaInfo->pui32ImageAddr,
-        pOtaInfo->ui32NumBytes, false, pFlash, &g_intFlash);
+        //
+        // The flag page describes the image as installed.
+        //
+        psImage->ui32NumBytes = sHeader.ui32Length;
+        psImage->ui32CRC = sHeader.ui32Crc;
+        g_am_multiboot.pui32WriteAddress = psImage->pui32LinkAddress;
+
+        if (!am_multiboot_lz_program((uint32_t)pOtaInfo->pui32LinkAddress,
+                                     pOtaInfo->pui32ImageAddr, pOtaInfo->ui32NumBytes,
+                                     pFlash, &g_intFlash, g_pTempBuf))
+        {
+            FLASH_OPERATE(pFlash, flash_disable);
+            FLASH_OPERATE(pFlash, flash_deinit);
+            return false;
+        }
+
+        psImage->pui32StackPointer = (uint32_t *)(pOtaInfo->pui32LinkAddress[0]);
+        psImage->pui32ResetVector = (uint32_t *)(pOtaInfo->pui32LinkAddress[1]);
+    }
+    else
+    {
+        psImage->pui32StackPointer = (uint32_t *)(((uint32_t *)pOtaInfo->pui32ImageAddr)[0]);
+        psImage->pui32ResetVector = (uint32_t *)(((uint32_t *)pOtaInfo->pui32ImageAddr)[1]);
+
+        //
+        // The image is presumed to be reasonable. Set our global
+        // variables based on the new image structure.
+        //
+        g_am_multiboot.pui32WriteAddress = psImage->pui32LinkAddress;
+
+        program_image_from_flash((uint32_t)pOtaInfo->pui32LinkAddress, pOtaInfo->pui32ImageAddr,
+            pOtaInfo->ui32NumBytes, false, pFlash, &g_intFlash);
+    }
     // Protect the image if needed
     program_image(psImage->bEncrypted);
-    if ( !(pOtaInfo->ui32Options & OTA_INFO_OPTIONS_DATA) && USE_FLAG_PAGE )
+    if ( !(pOtaInfo->ui32Options & (OTA_INFO_OPTIONS_DATA | OTA_INFO_OPTIONS_MODEL)) &&
+         USE_FLAG_PAGE )
     {
         //
         // Write the flag page.
@@ -90,6 +90,10 @@ typedef struct
 
 #define OTA_INFO_OPTIONS_EXT_FLASH  0x1
 #define OTA_INFO_OPTIONS_DATA       0x2
+// Image is a model blob for the model partition; nothing else is touched
+#define OTA_INFO_OPTIONS_MODEL      0x4
+// Image is compressed as described in am_multiboot_lz.h
+#define OTA_INFO_OPTIONS_COMPRESSED 0x8
 #define OTA_INFO_MAGIC_NUM          0xDEADCAFE
 typedef struct
 {
@@ -105,6 +105,19 @@
 #define MAX_SRAM_USED                      0x00004000
 #endif
 
+//*****************************************************************************
+//
+// Model partition. Must match MODEL_PARTITION_ADDRESS and MODEL_PARTITION_SIZE
+// in the application's model_partition.h.
+//
+//*****************************************************************************
+#ifndef MODEL_PARTITION_ADDRESS
+#define MODEL_PARTITION_ADDRESS            0x00080000
+#endif
+#ifndef MODEL_PARTITION_SIZE
+#define MODEL_PARTITION_SIZE               0x00080000
+#endif
+
 extern am_bootloader_image_t *g_psBootImage;
 
 //*****************************************************************************
@@ -119,6 +132,13 @@ extern am_bootloader_image_t *g_psBootImage;
 #if FLAG_PAGE_LOCATION < MAX_BOOTLOADER_SIZE
 #error "Flag Page overlaps with Bootloader"
 #endif
+#if (FLAG_PAGE_LOCATION >= MODEL_PARTITION_ADDRESS) && \
+    (FLAG_PAGE_LOCATION < (MODEL_PARTITION_ADDRESS + MODEL_PARTITION_SIZE))
+#error "Flag Page overlaps with the model partition"
+#endif
+#endif
+#if MODEL_PARTITION_ADDRESS & (AM_HAL_FLASH_PAGE_SIZE - 1)
+#error "Model partition address not page aligned"
 #endif
 
 //*****************************************************************************
@@ -0,0 +1,739 @@
+//*****************************************************************************
+//
+//! @file am_multiboot_lz.c
+//!
+//! @brief Streaming decompression of compressed OTA images into flash.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2020, Ambiq Micro, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision 2.5.1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+#include <stdint.h>
+#include <stdbool.h>
+#include "am_bootloader.h"
+#include "am_multiboot_lz.h"
+
+#if AM_MULTIBOOT_LZ_WINDOW & (AM_MULTIBOOT_LZ_WINDOW - 1)
+#error "LZ window must be a power of 2"
+#endif
+
+//*****************************************************************************
+//
+// Decoder state. Compressed data is read from the staged image in small
+// chunks and the last AM_MULTIBOOT_LZ_WINDOW decompressed bytes are kept for
+// back references, so the SRAM needed does not depend on the image size.
+// Huffman codes are decoded a bit at a time instead of through lookup tables
+// to keep the decoder small; flash programming dominates the install time.
+//
+//*****************************************************************************
+typedef struct
+{
+    am_multiboot_flash_info_t *pReadFlash;
+    uint32_t ui32SrcAddr;
+    uint32_t ui32SrcLeft;
+    uint32_t ui32InPos;
+    uint32_t ui32InLen;
+    uint32_t ui32BitBuf;
+    uint32_t ui32BitCount;
+
+    uint32_t ui32Length;
+    uint32_t ui32OutBytes;
+    uint32_t ui32Crc;
+
+    // Only when programming
+    am_multiboot_flash_info_t *pWriteFlash;
+    uint32_t ui32WriteAddr;
+    uint8_t *pui8Sector;
+    uint32_t ui32SectorBytes;
+} am_multiboot_lz_t;
+
+//*****************************************************************************
+//
+// Canonical Huffman code: the number of codes of each length and the symbols
+// ordered by code.
+//
+//*****************************************************************************
+#define LZ_MAX_BITS         15
+#define LZ_MAX_LITERALS     288
+#define LZ_MAX_DISTANCES    30
+
+typedef struct
+{
+    uint16_t pui16Count[LZ_MAX_BITS + 1];
+    uint16_t pui16Symbol[LZ_MAX_LITERALS];
+} am_multiboot_lz_code_t;
+
+static uint32_t g_pui32LzInput[AM_MULTIBOOT_LZ_INPUT_SIZE / 4];
+static uint8_t g_pui8LzWindow[AM_MULTIBOOT_LZ_WINDOW];
+static am_multiboot_lz_code_t g_sLzLiterals;
+static am_multiboot_lz_code_t g_sLzDistances;
+
+static const uint16_t g_pui16LengthBase[29] =
+{
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t g_pui8LengthExtra[29] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t g_pui16DistanceBase[30] =
+{
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+static const uint8_t g_pui8DistanceExtra[30] =
+{
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+// Order in which the code length code lengths are sent
+static const uint8_t g_pui8CodeLengthOrder[19] =
+{
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+//*****************************************************************************
+//
+// Read the next chunk of compressed data. Reads never cross a flash page of
+// the source device.
+//
+//*****************************************************************************
+static bool
+lz_fill(am_multiboot_lz_t *psLz)
+{
+    uint32_t ui32Chunk = AM_MULTIBOOT_LZ_INPUT_SIZE;
+    uint32_t ui32Bytes;
+
+    if (psLz->ui32SrcLeft == 0)
+    {
+        return false;
+    }
+
+    if (psLz->pReadFlash->flashPageSize < ui32Chunk)
+    {
+        ui32Chunk = psLz->pReadFlash->flashPageSize;
+    }
+    ui32Bytes = ui32Chunk - (psLz->ui32SrcAddr & (ui32Chunk - 1));
+    if (ui32Bytes > psLz->ui32SrcLeft)
+    {
+        ui32Bytes = psLz->ui32SrcLeft;
+    }
+
+    // Reads are whole words; the staged image is padded to a word.
+    if (psLz->pReadFlash->flash_read_page((uint32_t)g_pui32LzInput,
+                                          (uint32_t *)psLz->ui32SrcAddr,
+                                          (ui32Bytes + 3) & ~3) != 0)
+    {
+        return false;
+    }
+
+    psLz->ui32SrcAddr += ui32Bytes;
+    psLz->ui32SrcLeft -= ui32Bytes;
+    psLz->ui32InPos = 0;
+    psLz->ui32InLen = ui32Bytes;
+    return true;
+}
+
+static bool
+lz_byte(am_multiboot_lz_t *psLz, uint8_t *pui8Byte)
+{
+    if ((psLz->ui32InPos == psLz->ui32InLen) && !lz_fill(psLz))
+    {
+        return false;
+    }
+    *pui8Byte = ((uint8_t *)g_pui32LzInput)[psLz->ui32InPos++];
+    return true;
+}
+
+// DEFLATE packs bits starting from the least significant bit of each byte
+static bool
+lz_bits(am_multiboot_lz_t *psLz, uint32_t ui32Count, uint32_t *pui32Value)
+{
+    uint8_t ui8Byte;
+
+    while (psLz->ui32BitCount < ui32Count)
+    {
+        if (!lz_byte(psLz, &ui8Byte))
+        {
+            return false;
+        }
+        psLz->ui32BitBuf |= (uint32_t)ui8Byte << psLz->ui32BitCount;
+        psLz->ui32BitCount += 8;
+    }
+
+    *pui32Value = psLz->ui32BitBuf & ((1UL << ui32Count) - 1);
+    psLz->ui32BitBuf >>= ui32Count;
+    psLz->ui32BitCount -= ui32Count;
+    return true;
+}
+
+//*****************************************************************************
+//
+// Erase and program the sector held in SRAM. A partial last sector keeps
+// whatever followed the image in flash.
+//
+//*****************************************************************************
+static bool
+lz_flush_sector(am_multiboot_lz_t *psLz)
+{
+    am_multiboot_flash_info_t *pFlash = psLz->pWriteFlash;
+    uint32_t ui32Offset = psLz->ui32SectorBytes;
+
+    while (ui32Offset < pFlash->flashSectorSize)
+    {
+        uint32_t ui32Bytes = pFlash->flashPageSize - (ui32Offset & (pFlash->flashPageSize - 1));
+        if (pFlash->flash_read_page((uint32_t)(psLz->pui8Sector + ui32Offset),
+                                    (uint32_t *)(psLz->ui32WriteAddr + ui32Offset),
+                                    ui32Bytes) != 0)
+        {
+            return false;
+        }
+        ui32Offset += ui32Bytes;
+    }
+
+    if (pFlash->flash_erase_sector(psLz->ui32WriteAddr) != 0)
+    {
+        return false;
+    }
+    for (ui32Offset = 0; ui32Offset < pFlash->flashSectorSize; ui32Offset += pFlash->flashPageSize)
+    {
+        if (pFlash->flash_write_page(psLz->ui32WriteAddr + ui32Offset,
+                                     (uint32_t *)(psLz->pui8Sector + ui32Offset),
+                                     pFlash->flashPageSize) != 0)
+        {
+            return false;
+        }
+    }
+
+    psLz->ui32WriteAddr += pFlash->flashSectorSize;
+    psLz->ui32SectorBytes = 0;
+    return true;
+}
+
+static bool
+lz_put(am_multiboot_lz_t *psLz, uint8_t ui8Byte)
+{
+    uint32_t ui32Pos = psLz->ui32OutBytes & (AM_MULTIBOOT_LZ_WINDOW - 1);
+
+    if (psLz->ui32OutBytes++ == psLz->ui32Length)
+    {
+        return false;
+    }
+
+    g_pui8LzWindow[ui32Pos] = ui8Byte;
+    if (ui32Pos == AM_MULTIBOOT_LZ_WINDOW - 1)
+    {
+        AM_BOOTLOADER_PARTIAL_CRC32(g_pui8LzWindow, AM_MULTIBOOT_LZ_WINDOW, &psLz->ui32Crc);
+    }
+
+    if (psLz->pWriteFlash)
+    {
+        psLz->pui8Sector[psLz->ui32SectorBytes++] = ui8Byte;
+        if (psLz->ui32SectorBytes == psLz->pWriteFlash->flashSectorSize)
+        {
+            return lz_flush_sector(psLz);
+        }
+    }
+    return true;
+}
+
+//*****************************************************************************
+//
+// Build a canonical Huffman code from the code length of each symbol.
+//
+//*****************************************************************************
+static bool
+lz_build(am_multiboot_lz_code_t *psCode, const uint8_t *pui8Lengths, uint32_t ui32Symbols)
+{
+    uint16_t pui16Offset[LZ_MAX_BITS + 1];
+    int32_t i32Left = 1;
+    uint32_t i;
+
+    for (i = 0; i <= LZ_MAX_BITS; i++)
+    {
+        psCode->pui16Count[i] = 0;
+    }
+    for (i = 0; i < ui32Symbols; i++)
+    {
+        psCode->pui16Count[pui8Lengths[i]]++;
+    }
+
+    // Reject codes with more codes of a length than there is room for
+    for (i = 1; i <= LZ_MAX_BITS; i++)
+    {
+        i32Left = (i32Left << 1) - psCode->pui16Count[i];
+        if (i32Left < 0)
+        {
+            return false;
+        }
+    }
+
+    pui16Offset[1] = 0;
+    for (i = 1; i < LZ_MAX_BITS; i++)
+    {
+        pui16Offset[i + 1] = pui16Offset[i] + psCode->pui16Count[i];
+    }
+    for (i = 0; i < ui32Symbols; i++)
+    {
+        if (pui8Lengths[i])
+        {
+            psCode->pui16Symbol[pui16Offset[pui8Lengths[i]]++] = i;
+        }
+    }
+    return true;
+}
+
+//*****************************************************************************
+//
+// Decode one symbol, a bit at a time: codes of each length are consecutive
+// values, so the code is found as soon as it falls inside the range of its
+// length.
+//
+//*****************************************************************************
+static bool
+lz_symbol(am_multiboot_lz_t *psLz, const am_multiboot_lz_code_t *psCode, uint32_t *pui32Symbol)
+{
+    int32_t i32Code = 0, i32First = 0, i32Index = 0;
+    uint32_t ui32Bit, ui32Length;
+
+    for (ui32Length = 1; ui32Length <= LZ_MAX_BITS; ui32Length++)
+    {
+        if (!lz_bits(psLz, 1, &ui32Bit))
+        {
+            return false;
+        }
+        i32Code |= ui32Bit;
+
+        int32_t i32Count = psCode->pui16Count[ui32Length];
+        if (i32Code - i32Count < i32First)
+        {
+            *pui32Symbol = psCode->pui16Symbol[i32Index + (i32Code - i32First)];
+            return true;
+        }
+        i32Index += i32Count;
+        i32First = (i32First + i32Count) << 1;
+        i32Code <<= 1;
+    }
+    return false;
+}
+
+static bool
+lz_stored(am_multiboot_lz_t *psLz)
+{
+    uint32_t ui32Length, ui32Check, ui32Byte;
+
+    // Stored blocks start on a byte boundary
+    psLz->ui32BitBuf = 0;
+    psLz->ui32BitCount = 0;
+
+    if (!lz_bits(psLz, 16, &ui32Length) || !lz_bits(psLz, 16, &ui32Check) ||
+        (ui32Length != (~ui32Check & 0xFFFF)))
+    {
+        return false;
+    }
+
+    while (ui32Length--)
+    {
+        if (!lz_bits(psLz, 8, &ui32Byte) || !lz_put(psLz, (uint8_t)ui32Byte))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+lz_codes(am_multiboot_lz_t *psLz)
+{
+    uint32_t ui32Symbol, ui32Extra, ui32Length, ui32Distance;
+
+    while (1)
+    {
+        if (!lz_symbol(psLz, &g_sLzLiterals, &ui32Symbol))
+        {
+            return false;
+        }
+
+        if (ui32Symbol < 256)
+        {
+            if (!lz_put(psLz, (uint8_t)ui32Symbol))
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if (ui32Symbol == 256)
+        {
+            return true;
+        }
+
+        ui32Symbol -= 257;
+        if ((ui32Symbol >= 29) ||
+            !lz_bits(psLz, g_pui8LengthExtra[ui32Symbol], &ui32Extra))
+        {
+            return false;
+        }
+        ui32Length = g_pui16LengthBase[ui32Symbol] + ui32Extra;
+
+        if (!lz_symbol(psLz, &g_sLzDistances, &ui32Symbol) ||
+            (ui32Symbol >= LZ_MAX_DISTANCES) ||
+            !lz_bits(psLz, g_pui8DistanceExtra[ui32Symbol], &ui32Extra))
+        {
+            return false;
+        }
+        ui32Distance = g_pui16DistanceBase[ui32Symbol] + ui32Extra;
+
+        if ((ui32Distance > AM_MULTIBOOT_LZ_WINDOW) || (ui32Distance > psLz->ui32OutBytes))
+        {
+            return false;
+        }
+
+        // Byte by byte, so a match may overlap the bytes it produces
+        while (ui32Length--)
+        {
+            uint8_t ui8Byte = g_pui8LzWindow[(psLz->ui32OutBytes - ui32Distance) &
+                                             (AM_MULTIBOOT_LZ_WINDOW - 1)];
+            if (!lz_put(psLz, ui8Byte))
+            {
+                return false;
+            }
+        }
+    }
+}
+
+static bool
+lz_fixed(am_multiboot_lz_t *psLz)
+{
+    uint8_t pui8Lengths[LZ_MAX_LITERALS];
+    uint32_t i;
+
+    for (i = 0; i < 144; i++)
+    {
+        pui8Lengths[i] = 8;
+    }
+    for (; i < 256; i++)
+    {
+        pui8Lengths[i] = 9;
+    }
+    for (; i < 280; i++)
+    {
+        pui8Lengths[i] = 7;
+    }
+    for (; i < LZ_MAX_LITERALS; i++)
+    {
+        pui8Lengths[i] = 8;
+    }
+    lz_build(&g_sLzLiterals, pui8Lengths, LZ_MAX_LITERALS);
+
+    for (i = 0; i < LZ_MAX_DISTANCES; i++)
+    {
+        pui8Lengths[i] = 5;
+    }
+    lz_build(&g_sLzDistances, pui8Lengths, LZ_MAX_DISTANCES);
+
+    return lz_codes(psLz);
+}
+
+static bool
+lz_dynamic(am_multiboot_lz_t *psLz)
+{
+    uint8_t pui8Lengths[LZ_MAX_LITERALS + LZ_MAX_DISTANCES];
+    uint32_t ui32Literals, ui32Distances, ui32CodeLengths;
+    uint32_t ui32Symbol, ui32Value, ui32Repeat, i;
+
+    if (!lz_bits(psLz, 5, &ui32Literals) || !lz_bits(psLz, 5, &ui32Distances) ||
+        !lz_bits(psLz, 4, &ui32CodeLengths))
+    {
+        return false;
+    }
+    ui32Literals += 257;
+    ui32Distances += 1;
+    ui32CodeLengths += 4;
+    if ((ui32Literals > 286) || (ui32Distances > LZ_MAX_DISTANCES))
+    {
+        return false;
+    }
+
+    // Code used to send the literal and distance code lengths
+    for (i = 0; i < 19; i++)
+    {
+        ui32Value = 0;
+        if ((i < ui32CodeLengths) && !lz_bits(psLz, 3, &ui32Value))
+        {
+            return false;
+        }
+        pui8Lengths[g_pui8CodeLengthOrder[i]] = ui32Value;
+    }
+    if (!lz_build(&g_sLzLiterals, pui8Lengths, 19))
+    {
+        return false;
+    }
+
+    for (i = 0; i < ui32Literals + ui32Distances; )
+    {
+        if (!lz_symbol(psLz, &g_sLzLiterals, &ui32Symbol))
+        {
+            return false;
+        }
+
+        if (ui32Symbol < 16)
+        {
+            pui8Lengths[i++] = ui32Symbol;
+            continue;
+        }
+
+        ui32Value = 0;
+        if (ui32Symbol == 16)
+        {
+            if ((i == 0) || !lz_bits(psLz, 2, &ui32Repeat))
+            {
+                return false;
+            }
+            ui32Value = pui8Lengths[i - 1];
+            ui32Repeat += 3;
+        }
+        else if (ui32Symbol == 17)
+        {
+            if (!lz_bits(psLz, 3, &ui32Repeat))
+            {
+                return false;
+            }
+            ui32Repeat += 3;
+        }
+        else
+        {
+            if (!lz_bits(psLz, 7, &ui32Repeat))
+            {
+                return false;
+            }
+            ui32Repeat += 11;
+        }
+
+        if (i + ui32Repeat > ui32Literals + ui32Distances)
+        {
+            return false;
+        }
+        while (ui32Repeat--)
+        {
+            pui8Lengths[i++] = ui32Value;
+        }
+    }
+
+    // A block without an end of block code could never finish
+    if ((pui8Lengths[256] == 0) ||
+        !lz_build(&g_sLzLiterals, pui8Lengths, ui32Literals) ||
+        !lz_build(&g_sLzDistances, pui8Lengths + ui32Literals, ui32Distances))
+    {
+        return false;
+    }
+
+    return lz_codes(psLz);
+}
+
+//*****************************************************************************
+//
+// Decompress the whole stream. Returns false on a malformed stream, a flash
+// error, or when the result does not match the length and CRC in the header.
+//
+//*****************************************************************************
+static bool
+lz_decode(am_multiboot_lz_t *psLz, uint32_t *pui32Src, uint32_t ui32SrcBytes)
+{
+    am_multiboot_lz_header_t sHeader;
+    uint32_t ui32Last, ui32Type;
+    bool bOk;
+
+    if (!am_multiboot_lz_read_header(pui32Src, ui32SrcBytes, psLz->pReadFlash, &sHeader))
+    {
+        return false;
+    }
+
+    psLz->ui32SrcAddr = (uint32_t)pui32Src + sizeof(sHeader);
+    psLz->ui32SrcLeft = ui32SrcBytes - sizeof(sHeader);
+    psLz->ui32InPos = 0;
+    psLz->ui32InLen = 0;
+    psLz->ui32BitBuf = 0;
+    psLz->ui32BitCount = 0;
+    psLz->ui32Length = sHeader.ui32Length;
+    psLz->ui32OutBytes = 0;
+    psLz->ui32Crc = 0;
+
+    do
+    {
+        if (!lz_bits(psLz, 1, &ui32Last) || !lz_bits(psLz, 2, &ui32Type))
+        {
+            return false;
+        }
+
+        switch (ui32Type)
+        {
+            case 0:
+                bOk = lz_stored(psLz);
+                break;
+            case 1:
+                bOk = lz_fixed(psLz);
+                break;
+            case 2:
+                bOk = lz_dynamic(psLz);
+                break;
+            default:
+                bOk = false;
+                break;
+        }
+        if (!bOk)
+        {
+            return false;
+        }
+    }
+    while (!ui32Last);
+
+    if (psLz->ui32OutBytes != psLz->ui32Length)
+    {
+        return false;
+    }
+
+    AM_BOOTLOADER_PARTIAL_CRC32(g_pui8LzWindow,
+                                psLz->ui32OutBytes & (AM_MULTIBOOT_LZ_WINDOW - 1),
+                                &psLz->ui32Crc);
+
+    if (psLz->pWriteFlash && psLz->ui32SectorBytes && !lz_flush_sector(psLz))
+    {
+        return false;
+    }
+
+    return psLz->ui32Crc == sHeader.ui32Crc;
+}
+
+//*****************************************************************************
+//
+//! @brief Read the header of a compressed image.
+//!
+//! @param pui32Src - Location of the staged compressed image.
+//! @param ui32SrcBytes - Size of the staged compressed image.
+//! @param pReadFlash - Flash the image is staged in.
+//! @param psHeader - Returns the header.
+//!
+//! @return true if the image starts with a compressed image header.
+//
+//*****************************************************************************
+bool
+am_multiboot_lz_read_header(uint32_t *pui32Src, uint32_t ui32SrcBytes,
+                            am_multiboot_flash_info_t *pReadFlash,
+                            am_multiboot_lz_header_t *psHeader)
+{
+    if ((ui32SrcBytes < sizeof(*psHeader)) ||
+        (pReadFlash->flash_read_page((uint32_t)g_pui32LzInput, pui32Src, sizeof(*psHeader)) != 0))
+    {
+        return false;
+    }
+
+    psHeader->ui32Magic = g_pui32LzInput[0];
+    psHeader->ui32Length = g_pui32LzInput[1];
+    psHeader->ui32Crc = g_pui32LzInput[2];
+
+    return psHeader->ui32Magic == AM_MULTIBOOT_LZ_MAGIC;
+}
+
+//*****************************************************************************
+//
+//! @brief Check a compressed image without writing anything.
+//!
+//! @param pui32Src - Location of the staged compressed image.
+//! @param ui32SrcBytes - Size of the staged compressed image.
+//! @param pReadFlash - Flash the image is staged in.
+//!
+//! This function decompresses the whole image and checks its length and CRC,
+//! so that a damaged image is rejected before any flash is erased.
+//!
+//! @return true if the image decompresses to the length and CRC in its header.
+//
+//*****************************************************************************
+bool
+am_multiboot_lz_verify(uint32_t *pui32Src, uint32_t ui32SrcBytes,
+                       am_multiboot_flash_info_t *pReadFlash)
+{
+    am_multiboot_lz_t sLz = {
+        .pReadFlash = pReadFlash,
+        .pWriteFlash = 0,
+    };
+
+    return lz_decode(&sLz, pui32Src, ui32SrcBytes);
+}
+
+//*****************************************************************************
+//
+//! @brief Decompress a staged image into flash.
+//!
+//! @param ui32WriteAddr - Sector aligned address to install the image at.
+//! @param pui32Src - Location of the staged compressed image.
+//! @param ui32SrcBytes - Size of the staged compressed image.
+//! @param pReadFlash - Flash the image is staged in.
+//! @param pWriteFlash - Flash the image is installed to.
+//! @param pui32SectorBuf - Buffer of one pWriteFlash sector.
+//!
+//! Decompressed data is collected one sector at a time and programmed through
+//! pWriteFlash as each sector fills.
+//!
+//! @return true if the image was installed and matches its CRC.
+//
+//*****************************************************************************
+bool
+am_multiboot_lz_program(uint32_t ui32WriteAddr, uint32_t *pui32Src, uint32_t ui32SrcBytes,
+                        am_multiboot_flash_info_t *pReadFlash,
+                        am_multiboot_flash_info_t *pWriteFlash,
+                        uint32_t *pui32SectorBuf)
+{
+    am_multiboot_lz_t sLz = {
+        .pReadFlash = pReadFlash,
+        .pWriteFlash = pWriteFlash,
+        .ui32WriteAddr = ui32WriteAddr,
+        .pui8Sector = (uint8_t *)pui32SectorBuf,
+        .ui32SectorBytes = 0,
+    };
+
+    if (ui32WriteAddr & (pWriteFlash->flashSectorSize - 1))
+    {
+        return false;
+    }
+
+    return lz_decode(&sLz, pui32Src, ui32SrcBytes);
+}
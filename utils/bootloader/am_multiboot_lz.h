@@ -0,0 +1,102 @@
+//*****************************************************************************
+//
+//! @file am_multiboot_lz.h
+//!
+//! @brief Streaming decompression of compressed OTA images into flash.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Copyright (c) 2020, Ambiq Micro, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice,
+// this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// Third party software included in this distribution is subject to the
+// additional license terms as defined in the /docs/licenses directory.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// This is part of revision 2.5.1 of the AmbiqSuite Development Package.
+//
+//*****************************************************************************
+
+#ifndef AM_MULTIBOOT_LZ_H
+#define AM_MULTIBOOT_LZ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "am_multi_boot.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Compressed image format.
+//
+// The payload starts with am_multiboot_lz_header_t followed by a raw DEFLATE
+// stream (RFC 1951) whose back references reach at most
+// AM_MULTIBOOT_LZ_WINDOW bytes, which is what zlib produces with a window of
+// 11 bits. tools/am_lz.py writes it.
+//
+//*****************************************************************************
+#define AM_MULTIBOOT_LZ_MAGIC               0x315A4C41  // "ALZ1"
+#define AM_MULTIBOOT_LZ_WINDOW              2048
+
+// Compressed bytes read from the staged image at a time
+#ifndef AM_MULTIBOOT_LZ_INPUT_SIZE
+#define AM_MULTIBOOT_LZ_INPUT_SIZE          256
+#endif
+
+typedef struct
+{
+    // Should be set to AM_MULTIBOOT_LZ_MAGIC
+    uint32_t    ui32Magic;
+    // Length of the image after decompression
+    uint32_t    ui32Length;
+    // CRC of the image after decompression
+    uint32_t    ui32Crc;
+} am_multiboot_lz_header_t;
+
+extern bool am_multiboot_lz_read_header(uint32_t *pui32Src, uint32_t ui32SrcBytes,
+                                        am_multiboot_flash_info_t *pReadFlash,
+                                        am_multiboot_lz_header_t *psHeader);
+extern bool am_multiboot_lz_verify(uint32_t *pui32Src, uint32_t ui32SrcBytes,
+                                   am_multiboot_flash_info_t *pReadFlash);
+extern bool am_multiboot_lz_program(uint32_t ui32WriteAddr, uint32_t *pui32Src,
+                                    uint32_t ui32SrcBytes,
+                                    am_multiboot_flash_info_t *pReadFlash,
+                                    am_multiboot_flash_info_t *pWriteFlash,
+                                    uint32_t *pui32SectorBuf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AM_MULTIBOOT_LZ_H